@@ -39,7 +39,8 @@ bool GlyphArray_set1(GlyphArray *glyph_array, size_t index, uint16_t data) {
   if (index > ga->len) {
     return false;
   }
-  ga->bloom_valid = false;
+  // The bloom only has to be a superset of the glyphs, so just add the new one.
+  if (ga->bloom_valid) ga->bloom = add_glyphID_to_bloom(ga->bloom, data);
   ga->array[index] = data;
   return true;
 }
@@ -50,7 +51,9 @@ bool GlyphArray_set(GlyphArray *glyph_array, size_t from, const uint16_t *data,
     // TODO: error out maybe?
     return false;
   }
-  ga->bloom_valid = false;
+  for (size_t i = 0; ga->bloom_valid && i < data_size && !is_full_bloom(ga->bloom); i++) {
+    ga->bloom = add_glyphID_to_bloom(ga->bloom, data[i]);
+  }
   if (from + data_size > ga->len) {
     size_t remainder = (from + data_size) - ga->len;
     if (ga->len + remainder > ga->allocated) {
@@ -85,7 +88,8 @@ bool GlyphArray_set(GlyphArray *glyph_array, size_t from, const uint16_t *data,
     }
     ga->len += remainder;
   }
-  memcpy(&ga->array[from], data, data_size * sizeof(uint16_t));
+  // GlyphArray_put shifts glyphs inside the same array, so the ranges can overlap
+  memmove(&ga->array[from], data, data_size * sizeof(uint16_t));
   return true;
 }
 
@@ -99,7 +103,6 @@ bool GlyphArray_shrink(GlyphArray *glyph_array, size_t reduction) {
   if (reduction > ga->len) {
     return false;
   }
-  ga->bloom_valid = false;
   ga->len -= reduction;
   return true;
 }
@@ -8,18 +8,87 @@
 #include "bswap.h"
 #include "hash.h"
 
-build_hash_functions(Bloom)
 build_hash_functions(uintptr_t)
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define popcount_64(x) ((uint32_t)__popcnt64(x))
+#else
+#define popcount_64(x) ((uint32_t)__builtin_popcountll(x))
+#endif
+
+// Coverage table compiled into a bitset spanning [first, last].
+// rank holds the coverage index of the first glyph of every word, so the
+// index of a glyph is rank + the bits set before it in its word.
+typedef struct {
+  uint16_t first, last;
+  uint16_t *rank; // NULL for filters, which only need membership
+  uint64_t bits[];
+} CompiledCoverage;
+
+// ClassDef table compiled into a dense array of classes, starting at `first`.
+typedef struct {
+  uint16_t first;
+  uint32_t count;
+  uint16_t classes[];
+} CompiledClassDef;
+
+#define LIGATURE_NONE 0xFFFF
+
+// A LigatureSet compiled into a trie of its components.
+// Node 0 is the null node, so 0 can be used as "no child" / "no sibling".
+typedef struct {
+  uint16_t glyph;    // Component glyph that leads to this node
+  uint16_t ligature; // Glyph that replaces the components, if a ligature ends here
+  uint16_t order;    // Index of that ligature inside its LigatureSet, LIGATURE_NONE if none ends here
+  uint16_t depth;    // Number of components after the first glyph
+  uint32_t child;
+  uint32_t next;
+} LigatureNode;
+
+typedef struct {
+  uint16_t setCount;
+  uint32_t *roots; // Root node of every LigatureSet, by coverage index
+  LigatureNode *nodes;
+} LigatureTrie;
+
+typedef struct {
+  const GenericSubstTable *table; // Extension tables are already resolved
+  uint16_t type;
+  const CompiledCoverage *coverage;   // Glyphs that start the Substitution, NULL if any glyph can
+  const CompiledCoverage **coverages; // Format 3 contexts: backtrack, input then lookahead coverages
+  const CompiledClassDef *classDefs[3]; // Format 2 contexts: input, backtrack, lookahead
+  const LigatureTrie *ligatures;
+} CompiledSubtable;
+
+typedef struct {
+  uint16_t type;
+  uint16_t subTableCount;
+  const CompiledSubtable *subtables;
+  const CompiledCoverage *filter; // Union of the subtables' coverages, NULL if any glyph can start one
+  Bloom bloom;                    // Same thing, to skip the whole GlyphArray at once
+} CompiledLookup;
+
+typedef struct ArenaBlock {
+  struct ArenaBlock *next;
+  size_t used, size;
+  uint64_t data[];
+} ArenaBlock;
+
+#define ARENA_BLOCK_SIZE 16384
+
 typedef struct LBT_Chain {
-  const LookupTable * const *lookupsArray;
+  const uint16_t *lookupIndices;
   size_t lookupCount;
   const GsubHeader *gsubHeader;
   const LookupList *lookupList;
-  HashTable_Bloom *bloom_hash;
-  HashTable_uintptr_t *ptr_hash;
+  CompiledLookup **lookups;            // By LookupList index, NULL for lookups the chain can't reach
+  HashTable_uintptr_t *compiled_hash;  // Table address -> compiled table, so shared tables are only compiled once
+  ArenaBlock *arena;                   // Everything compiled lives here, and dies with the chain
 } Chain;
 
+static const CompiledCoverage empty_coverage = { .first = 1, .last = 0 };
+
 #define compare_tags(tag1, tag2) ((tag1)[0] == (tag2)[0] &&                     \
                                   (tag1)[1] == (tag2)[1] &&                     \
                                   (tag1)[2] == (tag2)[2] &&                     \
@@ -139,6 +208,9 @@ static LookupTable *get_lookup(const LookupList *lookupList, uint16_t index) {
   return (LookupTable *)((uint8_t *)lookupList + parse_16(lookupList->lookupOffsets[index]));
 }
 
+static const CompiledLookup *get_compiled_Lookup(Chain *chain, uint16_t index);
+static bool compile_nested_Lookups(Chain *chain);
+
 
 // Returns the number of lookups inside the FeatureTable.
 // lookups must either be an array big enough to contain
@@ -164,9 +236,9 @@ static size_t get_lookups_from_feature(const FeatureTable *featureTable, const L
 
 // Returns the number of lookups of the given LangSysTable,
 // filtered and sorted as specified in features_enabled.
-// lookups must either be an array big enough to contain
-// all the pointers to lookups, or be NULL.
-static size_t get_lookups(const LangSysTable* langSysTable, const FeatureList *featureList, const LookupList *lookupList, const unsigned char (*features_enabled)[4], size_t nFeatures, LookupTable ***lookups) {
+// If lookups isn't NULL, it's set to a malloc'd array of
+// the LookupList indices of the lookups.
+static size_t get_lookups(const LangSysTable* langSysTable, const FeatureList *featureList, const LookupList *lookupList, const unsigned char (*features_enabled)[4], size_t nFeatures, uint16_t **lookups) {
   bool *lookups_map = calloc(parse_16(lookupList->lookupCount), sizeof(bool));
   if (lookups_map == NULL) return 0;
 
@@ -199,7 +271,7 @@ static size_t get_lookups(const LangSysTable* langSysTable, const FeatureList *f
     }
   }
   if (lookups != NULL) {
-    LookupTable **_lookups = malloc(sizeof(LookupTable *) * c);
+    uint16_t *_lookups = malloc(sizeof(uint16_t) * c);
     if (_lookups == NULL) {
       *lookups = NULL;
       goto end;
@@ -207,7 +279,7 @@ static size_t get_lookups(const LangSysTable* langSysTable, const FeatureList *f
     uint16_t lookupCount = parse_16(lookupList->lookupCount);
     for (uint16_t i = 0, j = 0; i < lookupCount; i++) {
       if (lookups_map[i]) {
-        _lookups[j] = get_lookup(lookupList, i);
+        _lookups[j] = i;
         ///printf("%d -> %d\n", j, i);
         j++;
       }
@@ -227,7 +299,7 @@ end:
 // to specify where it belongs in the chain.
 // Use `get_required_feature` if the tag is needed to decide where to place it.
 Chain *generate_chain(const uint8_t *GSUB_table, const unsigned char (*script)[4], const unsigned char (*lang)[4], const unsigned char (*features)[4], size_t n_features) {
-  LookupTable **lookupsArray = NULL;
+  uint16_t *lookupIndices = NULL;
 
   if (GSUB_table == NULL) {
     // There is no GSUB table, so return an empty chain
@@ -255,29 +327,38 @@ Chain *generate_chain(const uint8_t *GSUB_table, const unsigned char (*script)[4
   const LookupList *lookupList = (LookupList *)((uint8_t *)gsubHeader + parse_16(gsubHeader->lookupListOffset));
   ///printf("Total of %d lookups\n", parse_16(lookupList->lookupCount));
 
-  size_t lookupCount = get_lookups(langSysTable, featureList, lookupList, features, n_features, &lookupsArray);
+  size_t lookupCount = get_lookups(langSysTable, featureList, lookupList, features, n_features, &lookupIndices);
 
   Chain *chain = NULL;
   chain = calloc(1, sizeof(Chain));
   if (chain == NULL)
     goto fail;
 
-  chain->lookupsArray = (const LookupTable * const *)lookupsArray;
+  chain->lookupIndices = lookupIndices;
   chain->lookupCount = lookupCount;
   chain->gsubHeader = gsubHeader;
   chain->lookupList = lookupList;
-  chain->bloom_hash = new_Bloom_hash();
-  if (chain->bloom_hash == NULL)
+  chain->lookups = calloc(parse_16(lookupList->lookupCount), sizeof(CompiledLookup *));
+  if (chain->lookups == NULL && parse_16(lookupList->lookupCount) != 0)
+    goto fail_chain;
+  chain->compiled_hash = new_uintptr_t_hash();
+  if (chain->compiled_hash == NULL)
     goto fail_chain;
-  chain->ptr_hash = new_uintptr_t_hash();
-  if (chain->ptr_hash == NULL)
+
+  // Compile every lookup the chain can reach upfront, so apply_chain only reads the chain and
+  // can be called on the same chain from several threads at once.
+  for (size_t i = 0; i < lookupCount; i++) {
+    if (get_compiled_Lookup(chain, lookupIndices[i]) == NULL)
+      goto fail_chain;
+  }
+  if (!compile_nested_Lookups(chain))
     goto fail_chain;
 
   return chain;
 
 fail:
   // free(GSUB_table);
-  free(lookupsArray);
+  free(lookupIndices);
   return NULL;
 
 fail_chain:
@@ -288,17 +369,14 @@ fail_chain:
 void destroy_chain(Chain *chain) {
   if (chain == NULL) return;
   // free((void *)chain->gsubHeader);
-  free((void *)chain->lookupsArray);
-  free_Bloom_hash(chain->bloom_hash);
-  // uintptr_t_hash has malloc'd stuff inside, so free that first
-  if (chain->ptr_hash != NULL) {
-    for (size_t i = 0; i < chain->ptr_hash->size; i++) {
-      if (chain->ptr_hash->entries[i].address != NULL) {
-        free((void *)chain->ptr_hash->entries[i].value);
-      }
-    }
+  free((void *)chain->lookupIndices);
+  free(chain->lookups);
+  // compiled_hash only points inside the arena
+  free_uintptr_t_hash(chain->compiled_hash);
+  for (ArenaBlock *block = chain->arena, *next; block != NULL; block = next) {
+    next = block->next;
+    free(block);
   }
-  free_uintptr_t_hash(chain->ptr_hash);
   free(chain);
 }
 
@@ -386,151 +464,274 @@ static inline Bloom get_Coverage_array_bloom(const uint8_t *coverageTablesBase,
   return bloom;
 }
 
-static bool find_in_Coverage(const CoverageTable *coverageTable, uint16_t id, uint32_t *index) {
+static void *arena_alloc(Chain *chain, size_t size) {
+  size = (size + 7) & ~(size_t)7;
+  ArenaBlock *block = chain->arena;
+  if (block == NULL || block->used + size > block->size) {
+    size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+    block = calloc(1, sizeof(ArenaBlock) + block_size);
+    if (block == NULL) return NULL;
+    block->size = block_size;
+    block->next = chain->arena;
+    chain->arena = block;
+  }
+  void *ptr = (uint8_t *)block->data + block->used;
+  block->used += size;
+  return ptr;
+}
+
+static CompiledCoverage *new_CompiledCoverage(Chain *chain, uint16_t first, uint16_t last, bool ranked) {
+  size_t words = first <= last ? ((size_t)(last - first) >> 6) + 1 : 0;
+  CompiledCoverage *coverage = arena_alloc(chain, sizeof(CompiledCoverage) + words * sizeof(uint64_t) + (ranked ? words * sizeof(uint16_t) : 0));
+  if (coverage == NULL) return NULL;
+  coverage->first = first;
+  coverage->last = last;
+  coverage->rank = ranked ? (uint16_t *)&coverage->bits[words] : NULL;
+  return coverage;
+}
+
+static inline void add_to_CompiledCoverage(CompiledCoverage *coverage, uint16_t id) {
+  uint32_t offset = id - coverage->first;
+  coverage->bits[offset >> 6] |= (uint64_t)1 << (offset & 63);
+}
+
+static inline bool find_in_CompiledCoverage(const CompiledCoverage *coverage, uint16_t id, uint32_t *index) {
+  if (id < coverage->first || id > coverage->last) return false;
+  uint32_t offset = id - coverage->first;
+  uint64_t word = coverage->bits[offset >> 6], bit = (uint64_t)1 << (offset & 63);
+  if (!(word & bit)) return false;
+  if (index != NULL) {
+    *index = coverage->rank[offset >> 6] + popcount_64(word & (bit - 1));
+  }
+  return true;
+}
+
+// Compiles a Coverage table into a bitset, reusing it if it was already compiled for this chain.
+// Coverage indices come from the glyph order, as both formats list glyphs in numerical order.
+static const CompiledCoverage *compile_Coverage(Chain *chain, const CoverageTable *coverageTable) {
+  uintptr_t cached;
+  if (get_from_uintptr_t_hash(chain->compiled_hash, coverageTable, &cached)) {
+    return (const CompiledCoverage *)cached;
+  }
+
+  CompiledCoverage *coverage = NULL;
+  uint16_t first = 0xFFFF, last = 0;
   switch (parse_16(coverageTable->coverageFormat)) {
     case 1: { // Individual glyph indices
       const CoverageArrayTable *arrayTable = (CoverageArrayTable *)coverageTable;
       uint16_t glyphCount = parse_16(arrayTable->glyphCount);
-      if (glyphCount == 0) return false;
-      uint16_t first_ID = parse_16(arrayTable->glyphArray[0]);
-      if (first_ID > id) return false;
-      uint16_t last_ID = parse_16(arrayTable->glyphArray[glyphCount - 1]);
-      if (last_ID < id) return false;
-
-      // Binary search because we can
-      uint16_t top = glyphCount - 1;
-      uint16_t bottom = 0;
-      while (top - bottom >= 0) {
-        uint16_t current = (top + bottom) / 2;
-        uint16_t coverageID = parse_16(arrayTable->glyphArray[current]);
-        if (id < coverageID) {
-          top = current - 1;
-        } else if (id > coverageID) {
-          bottom = current + 1;
-        } else {
-          if (index != NULL) {
-            *index = current;
-          }
-          return true;
-        }
+      for (uint16_t i = 0; i < glyphCount; i++) {
+        uint16_t id = parse_16(arrayTable->glyphArray[i]);
+        if (id < first) first = id;
+        if (id > last) last = id;
+      }
+      coverage = new_CompiledCoverage(chain, first, last, true);
+      if (coverage == NULL) return NULL;
+      for (uint16_t i = 0; i < glyphCount; i++) {
+        add_to_CompiledCoverage(coverage, parse_16(arrayTable->glyphArray[i]));
       }
       break;
     }
     case 2: { // Range of glyphs
       const CoverageRangesTable *rangesTable = (CoverageRangesTable *)coverageTable;
       uint16_t rangeCount = parse_16(rangesTable->rangeCount);
-      if (rangeCount == 0) return false;
-      const CoverageRangeRecordTable *first_range = &(rangesTable->rangeRecords[0]);
-      if (parse_16(first_range->startGlyphID) > id) return false;
-      const CoverageRangeRecordTable *last_range = &(rangesTable->rangeRecords[rangeCount - 1]);
-      if (parse_16(last_range->endGlyphID) < id) return false;
-      uint16_t k = 0;
       for (uint16_t i = 0; i < rangeCount; i++) {
         const CoverageRangeRecordTable *range = &rangesTable->rangeRecords[i];
         uint16_t startGlyphID = parse_16(range->startGlyphID);
-        if (id < startGlyphID) break;
         uint16_t endGlyphID = parse_16(range->endGlyphID);
-        if (id > endGlyphID) {
-          k += endGlyphID - startGlyphID + 1;
-          continue;
-        }
-        if (index != NULL) {
-          *index = k + (id - startGlyphID);
+        if (startGlyphID > endGlyphID) continue;
+        if (startGlyphID < first) first = startGlyphID;
+        if (endGlyphID > last) last = endGlyphID;
+      }
+      coverage = new_CompiledCoverage(chain, first, last, true);
+      if (coverage == NULL) return NULL;
+      for (uint16_t i = 0; i < rangeCount; i++) {
+        const CoverageRangeRecordTable *range = &rangesTable->rangeRecords[i];
+        uint32_t endGlyphID = parse_16(range->endGlyphID);
+        for (uint32_t id = parse_16(range->startGlyphID); id <= endGlyphID; id++) {
+          add_to_CompiledCoverage(coverage, id);
         }
-        return true;
       }
       break;
     }
     default:
       fprintf(stderr, "UNKNOWN coverage format\n");
-      return false;
+      return &empty_coverage;
   }
-  return false;
+
+  size_t words = first <= last ? ((size_t)(last - first) >> 6) + 1 : 0;
+  uint32_t k = 0;
+  for (size_t i = 0; i < words; i++) {
+    coverage->rank[i] = k;
+    k += popcount_64(coverage->bits[i]);
+  }
+  set_to_uintptr_t_hash(chain->compiled_hash, coverageTable, (uintptr_t)coverage);
+  return coverage;
 }
 
-static bool find_in_class_array(const ClassDefGeneric *classDefTable, uint16_t id, uint16_t *class) {
+// Compiles the array of Coverage tables at coverageTables, relative to coverageTablesBase, into out.
+static bool compile_Coverage_array(Chain *chain, const uint8_t *coverageTablesBase, const uint16_t *coverageTables, uint16_t coverageSize, const CompiledCoverage **out) {
+  for (uint16_t i = 0; i < coverageSize; i++) {
+    out[i] = compile_Coverage(chain, (CoverageTable *)(coverageTablesBase + parse_16(coverageTables[i])));
+    if (out[i] == NULL) return false;
+  }
+  return true;
+}
+
+static const CompiledClassDef *compile_ClassDef(Chain *chain, const ClassDefGeneric *classDefTable) {
+  uintptr_t cached;
+  if (get_from_uintptr_t_hash(chain->compiled_hash, classDefTable, &cached)) {
+    return (const CompiledClassDef *)cached;
+  }
+
+  CompiledClassDef *classDef = NULL;
   switch (parse_16(classDefTable->classFormat)) {
     case ClassFormat_1: { // Individual glyph indices
       const ClassDefFormat1 *arrayTable = (ClassDefFormat1 *)classDefTable;
-      uint16_t startGlyphID = parse_16(arrayTable->startGlyphID);
       uint16_t glyphCount = parse_16(arrayTable->glyphCount);
-      if (id < startGlyphID || id >= startGlyphID + glyphCount) {
-        break;
-      }
-      if (class != NULL) {
-        *class = parse_16(arrayTable->classValueArray[id - startGlyphID]);
+      classDef = arena_alloc(chain, sizeof(CompiledClassDef) + glyphCount * sizeof(uint16_t));
+      if (classDef == NULL) return NULL;
+      classDef->first = parse_16(arrayTable->startGlyphID);
+      classDef->count = glyphCount;
+      for (uint16_t i = 0; i < glyphCount; i++) {
+        classDef->classes[i] = parse_16(arrayTable->classValueArray[i]);
       }
-      return true;
+      break;
     }
     case ClassFormat_2: { // Range of glyphs
       const ClassDefFormat2 *rangesTable = (ClassDefFormat2 *)classDefTable;
       uint16_t classRangeCount = parse_16(rangesTable->classRangeCount);
-      if (classRangeCount == 0) break;
-      const ClassRangeRecord *first_range = &(rangesTable->classRangeRecords[0]);
-      if (parse_16(first_range->startGlyphID) > id) break;
-      const ClassRangeRecord *last_range = &(rangesTable->classRangeRecords[classRangeCount - 1]);
-      if (parse_16(last_range->endGlyphID) < id) break;
-
-      // Binary search because we can
-      uint16_t top = classRangeCount - 1;
-      uint16_t bottom = 0;
-      while (top - bottom >= 0) {
-        uint16_t current = (top + bottom) / 2;
-        const ClassRangeRecord *range = &rangesTable->classRangeRecords[current];
-        if (id < parse_16(range->startGlyphID)) {
-          top = current - 1;
-        } else if (id > parse_16(range->endGlyphID)) {
-          bottom = current + 1;
-        } else {
-          if (class != NULL) {
-            *class = parse_16(range->_class);
-          }
-          return true;
+      uint16_t first = 0xFFFF, last = 0;
+      for (uint16_t i = 0; i < classRangeCount; i++) {
+        const ClassRangeRecord *range = &rangesTable->classRangeRecords[i];
+        uint16_t startGlyphID = parse_16(range->startGlyphID);
+        uint16_t endGlyphID = parse_16(range->endGlyphID);
+        if (startGlyphID > endGlyphID) continue;
+        if (startGlyphID < first) first = startGlyphID;
+        if (endGlyphID > last) last = endGlyphID;
+      }
+      uint32_t count = first <= last ? (uint32_t)(last - first) + 1 : 0;
+      classDef = arena_alloc(chain, sizeof(CompiledClassDef) + count * sizeof(uint16_t));
+      if (classDef == NULL) return NULL;
+      classDef->first = first;
+      classDef->count = count;
+      for (uint16_t i = 0; i < classRangeCount; i++) {
+        const ClassRangeRecord *range = &rangesTable->classRangeRecords[i];
+        uint32_t endGlyphID = parse_16(range->endGlyphID);
+        uint16_t _class = parse_16(range->_class);
+        for (uint32_t id = parse_16(range->startGlyphID); id <= endGlyphID; id++) {
+          classDef->classes[id - first] = _class;
         }
       }
       break;
     }
     default:
       fprintf(stderr, "UNKNOWN class format\n");
+      classDef = arena_alloc(chain, sizeof(CompiledClassDef));
+      if (classDef == NULL) return NULL;
       break;
   }
-  if (class != NULL) {
-    *class = 0;
+
+  set_to_uintptr_t_hash(chain->compiled_hash, classDefTable, (uintptr_t)classDef);
+  return classDef;
+}
+
+// Glyphs outside of the ClassDef are class 0.
+static inline uint16_t find_in_CompiledClassDef(const CompiledClassDef *classDef, uint16_t id) {
+  uint32_t offset = (uint32_t)id - classDef->first;
+  return offset < classDef->count ? classDef->classes[offset] : 0;
+}
+
+// Compiles every LigatureSet of the table into a trie, keeping the order of the ligatures so
+// matching still returns the first ligature of the set that applies.
+static const LigatureTrie *compile_LigatureTrie(Chain *chain, const LigatureSubstitutionTable *ligatureSubstitutionTable) {
+  uint16_t ligatureSetCount = parse_16(ligatureSubstitutionTable->ligatureSetCount);
+
+  // Every component can need its own node, plus one root per set and the null node
+  size_t nodeCount = 1 + ligatureSetCount;
+  for (uint16_t s = 0; s < ligatureSetCount; s++) {
+    const LigatureSetTable *ligatureSet = (LigatureSetTable *)((uint8_t *)ligatureSubstitutionTable + parse_16(ligatureSubstitutionTable->ligatureSetOffsets[s]));
+    uint16_t ligatureCount = parse_16(ligatureSet->ligatureCount);
+    for (uint16_t i = 0; i < ligatureCount; i++) {
+      const LigatureTable *ligature = (LigatureTable *)((uint8_t *)ligatureSet + parse_16(ligatureSet->ligatureOffsets[i]));
+      uint16_t componentCount = parse_16(ligature->componentCount);
+      if (componentCount > 1) nodeCount += componentCount - 1;
+    }
+  }
+
+  LigatureTrie *trie = arena_alloc(chain, sizeof(LigatureTrie));
+  if (trie == NULL) return NULL;
+  trie->setCount = ligatureSetCount;
+  trie->roots = arena_alloc(chain, ligatureSetCount * sizeof(uint32_t));
+  trie->nodes = arena_alloc(chain, nodeCount * sizeof(LigatureNode));
+  if ((trie->roots == NULL && ligatureSetCount != 0) || trie->nodes == NULL) return NULL;
+
+  LigatureNode *nodes = trie->nodes;
+  uint32_t n = 1;
+  for (uint16_t s = 0; s < ligatureSetCount; s++) {
+    const LigatureSetTable *ligatureSet = (LigatureSetTable *)((uint8_t *)ligatureSubstitutionTable + parse_16(ligatureSubstitutionTable->ligatureSetOffsets[s]));
+    uint32_t root = n++;
+    nodes[root].order = LIGATURE_NONE;
+    trie->roots[s] = root;
+
+    uint16_t ligatureCount = parse_16(ligatureSet->ligatureCount);
+    for (uint16_t i = 0; i < ligatureCount; i++) {
+      const LigatureTable *ligature = (LigatureTable *)((uint8_t *)ligatureSet + parse_16(ligatureSet->ligatureOffsets[i]));
+      uint16_t componentCount = parse_16(ligature->componentCount);
+      if (componentCount == 0) continue;
+
+      uint32_t node = root;
+      for (uint16_t j = 0; j < componentCount - 1; j++) {
+        uint16_t glyph = parse_16(ligature->componentGlyphIDs[j]);
+        uint32_t child = nodes[node].child;
+        while (child != 0 && nodes[child].glyph != glyph) child = nodes[child].next;
+        if (child == 0) {
+          child = n++;
+          nodes[child] = (LigatureNode){
+            .glyph = glyph,
+            .order = LIGATURE_NONE,
+            .depth = nodes[node].depth + 1,
+            .next = nodes[node].child,
+          };
+          nodes[node].child = child;
+        }
+        node = child;
+      }
+      // A ligature with the same components that comes earlier in the set shadows this one.
+      if (nodes[node].order == LIGATURE_NONE) {
+        nodes[node].order = i;
+        nodes[node].ligature = parse_16(ligature->ligatureGlyph);
+      }
+    }
   }
-  return false;
+  return trie;
 }
 
-static bool apply_SingleSubstitution(const SingleSubstFormatGeneric *singleSubstFormatGeneric, GlyphArray* glyph_array, size_t index) {
-  const CoverageTable *coverageTable = (CoverageTable *)((uint8_t *)singleSubstFormatGeneric + parse_16(singleSubstFormatGeneric->coverageOffset));
-  switch (parse_16(singleSubstFormatGeneric->substFormat)) {
+static bool apply_SingleSubstitution(const CompiledSubtable *sub, GlyphArray* glyph_array, size_t index) {
+  uint32_t coverage_index;
+  if (!find_in_CompiledCoverage(sub->coverage, glyph_array->array[index], &coverage_index)) return false;
+  switch (parse_16(sub->table->substFormat)) {
     case SingleSubstitutionFormat_1: {
-      const SingleSubstFormat1 *singleSubst = (SingleSubstFormat1 *)singleSubstFormatGeneric;
-      if (find_in_Coverage(coverageTable, glyph_array->array[index], NULL)) {
-        GlyphArray_set1(glyph_array, index, glyph_array->array[index] + parse_16(singleSubst->deltaGlyphID));
-        return true;
-      }
-      break;
+      const SingleSubstFormat1 *singleSubst = (SingleSubstFormat1 *)sub->table;
+      GlyphArray_set1(glyph_array, index, glyph_array->array[index] + parse_16(singleSubst->deltaGlyphID));
+      return true;
     }
     case SingleSubstitutionFormat_2: {
-      const SingleSubstFormat2 *singleSubst = (SingleSubstFormat2 *)singleSubstFormatGeneric;
-      uint32_t coverage_index;
-      if (find_in_Coverage(coverageTable, glyph_array->array[index], &coverage_index)) {
-        GlyphArray_set1(glyph_array, index, parse_16(singleSubst->substituteGlyphIDs[coverage_index]));
-        return true;
-      }
-      break;
+      const SingleSubstFormat2 *singleSubst = (SingleSubstFormat2 *)sub->table;
+      GlyphArray_set1(glyph_array, index, parse_16(singleSubst->substituteGlyphIDs[coverage_index]));
+      return true;
     }
     default:
-      fprintf(stderr, "UNKNOWN SubstFormat %d\n", parse_16(singleSubstFormatGeneric->substFormat));
+      fprintf(stderr, "UNKNOWN SubstFormat %d\n", parse_16(sub->table->substFormat));
       break;
   }
   return false;
 }
 
-static bool apply_MultipleSubstitution(const MultipleSubstFormat1 *multipleSubstFormat, GlyphArray* glyph_array, size_t *index) {
-  const CoverageTable *coverageTable = (CoverageTable *)((uint8_t *)multipleSubstFormat + parse_16(multipleSubstFormat->coverageOffset));
+static bool apply_MultipleSubstitution(const CompiledSubtable *sub, GlyphArray* glyph_array, size_t *index) {
+  const MultipleSubstFormat1 *multipleSubstFormat = (MultipleSubstFormat1 *)sub->table;
   uint32_t coverage_index;
-  bool applicable = find_in_Coverage(coverageTable, glyph_array->array[*index], &coverage_index);
+  bool applicable = find_in_CompiledCoverage(sub->coverage, glyph_array->array[*index], &coverage_index);
   if (!applicable || coverage_index >= parse_16(multipleSubstFormat->sequenceCount)) return false;
 
   const SequenceTable *sequenceTable = (SequenceTable *)((uint8_t *)multipleSubstFormat + parse_16(multipleSubstFormat->sequenceOffsets[coverage_index]));
@@ -543,41 +744,36 @@ static bool apply_MultipleSubstitution(const MultipleSubstFormat1 *multipleSubst
   return true;
 }
 
-static const LigatureTable *find_Ligature(const LigatureSetTable *ligatureSet, GlyphArray* glyph_array, size_t index) {
-  uint16_t ligatureCount = parse_16(ligatureSet->ligatureCount);
-  for (uint16_t i = 0; i < ligatureCount; i++) {
-    const LigatureTable *ligature = (LigatureTable *)((uint8_t *)ligatureSet + parse_16(ligatureSet->ligatureOffsets[i]));
-    bool fail = false;
-    uint16_t componentCount = parse_16(ligature->componentCount);
-    if (index + componentCount - 1 > glyph_array->len) continue;
-    for (uint16_t j = 0; j < componentCount - 1; j++) {
-      if (parse_16(ligature->componentGlyphIDs[j]) != glyph_array->array[index+j]) {
-        fail = true;
-        break;
-      }
-    }
-    if (!fail) {
-      return ligature;
-    }
+// Returns the trie node of the ligature that starts at index, or NULL if none does.
+static const LigatureNode *match_Ligature(const CompiledSubtable *sub, const uint16_t *glyphs, size_t len, size_t index) {
+  uint32_t coverage_index;
+  const LigatureTrie *trie = sub->ligatures;
+  bool applicable = find_in_CompiledCoverage(sub->coverage, glyphs[index], &coverage_index);
+  if (!applicable || coverage_index >= trie->setCount) return NULL;
+
+  // Walk down the trie as far as the glyphs go, keeping the earliest ligature of the set that ended on the way.
+  const LigatureNode *nodes = trie->nodes;
+  uint32_t node = trie->roots[coverage_index];
+  uint32_t match = nodes[node].order != LIGATURE_NONE ? node : 0;
+  for (size_t i = index + 1; i < len && nodes[node].child != 0; i++) {
+    uint32_t child = nodes[node].child;
+    while (child != 0 && nodes[child].glyph != glyphs[i]) child = nodes[child].next;
+    if (child == 0) break;
+    node = child;
+    if (nodes[node].order < (match != 0 ? nodes[match].order : LIGATURE_NONE)) match = node;
   }
-  return NULL;
+  return match != 0 ? &nodes[match] : NULL;
 }
 
-static bool apply_LigatureSubstitution(const LigatureSubstitutionTable *ligatureSubstitutionTable, GlyphArray* glyph_array, size_t index) {
-  const CoverageTable *coverageTable = (CoverageTable *)((uint8_t *)ligatureSubstitutionTable + parse_16(ligatureSubstitutionTable->coverageOffset));
-  uint32_t coverage_index;
-  bool applicable = find_in_Coverage(coverageTable, glyph_array->array[index], &coverage_index);
-  if (!applicable || coverage_index >= parse_16(ligatureSubstitutionTable->ligatureSetCount)) return false;
-  const LigatureSetTable *ligatureSet = (LigatureSetTable *)((uint8_t *)ligatureSubstitutionTable + parse_16(ligatureSubstitutionTable->ligatureSetOffsets[coverage_index]));
-  const LigatureTable *ligature = find_Ligature(ligatureSet, glyph_array, index + 1);
-  if (ligature != NULL) {
-    GlyphArray_set1(glyph_array, index, parse_16(ligature->ligatureGlyph));
-    uint16_t componentCount = parse_16(ligature->componentCount);
-    GlyphArray_put(glyph_array, index + 1, glyph_array, index + componentCount, glyph_array->len - (index + componentCount));
-    GlyphArray_shrink(glyph_array, componentCount - 1);
-    return true;
-  }
-  return false;
+static bool apply_LigatureSubstitution(const CompiledSubtable *sub, GlyphArray* glyph_array, size_t index) {
+  const LigatureNode *ligature = match_Ligature(sub, glyph_array->array, glyph_array->len, index);
+  if (ligature == NULL) return false;
+
+  GlyphArray_set1(glyph_array, index, ligature->ligature);
+  uint16_t componentCount = ligature->depth + 1;
+  GlyphArray_put(glyph_array, index + 1, glyph_array, index + componentCount, glyph_array->len - (index + componentCount));
+  GlyphArray_shrink(glyph_array, componentCount - 1);
+  return true;
 }
 
 static bool check_with_Sequence(GlyphArray *glyph_array, size_t index, const uint16_t *sequenceRule, uint16_t sequenceSize, int8_t step) {
@@ -590,30 +786,25 @@ static bool check_with_Sequence(GlyphArray *glyph_array, size_t index, const uin
   return true;
 }
 
-static bool check_with_Coverage(const GlyphArray *glyph_array, size_t index, const uint8_t *coverageTablesBase, const uint16_t *coverageTables, uint16_t coverageSize, int8_t step) {
-  if (coverageSize == 0) return true;
-
+static bool check_with_Coverage(const GlyphArray *glyph_array, size_t index, const CompiledCoverage * const *coverages, uint16_t coverageSize, int8_t step) {
   for (uint16_t i = 0; i < coverageSize; i++) {
-    const CoverageTable *coverageTable = (CoverageTable *)(coverageTablesBase + parse_16(coverageTables[i]));
-    if (!find_in_Coverage(coverageTable, glyph_array->array[index + (i * step)], NULL))
+    if (!find_in_CompiledCoverage(coverages[i], glyph_array->array[index + (i * step)], NULL))
       return false;
   }
   return true;
 }
 
-static bool check_with_Class(const GlyphArray *glyph_array, size_t index, const ClassDefGeneric *classDef, const uint16_t *sequenceTable, uint16_t sequence_size, int8_t step) {
+static bool check_with_Class(const GlyphArray *glyph_array, size_t index, const CompiledClassDef *classDef, const uint16_t *sequenceTable, uint16_t sequence_size, int8_t step) {
   for (uint16_t i = 0; i < sequence_size; i++) {
     uint16_t glyph = glyph_array->array[index + (i * step)];
-    uint16_t class;
-    find_in_class_array(classDef, glyph, &class);
-    if (class != parse_16(sequenceTable[i])) {
+    if (find_in_CompiledClassDef(classDef, glyph) != parse_16(sequenceTable[i])) {
       return false;
     }
   }
   return true;
 }
 
-static void apply_Lookup_at_index(const Chain *chain, const LookupTable *lookupTable, const Bloom* blooms, GlyphArray* glyph_array, size_t *index);
+static void apply_Lookup_at_index(const Chain *chain, const CompiledLookup *lookup, GlyphArray* glyph_array, size_t *index);
 
 static void apply_SequenceRule(const Chain *chain, uint16_t glyphCount, const SequenceLookupRecord *seqLookupRecords, uint16_t seqLookupCount, GlyphArray *glyph_array, size_t *index) {
   GlyphArray *input_ga = GlyphArray_new(glyphCount);
@@ -622,9 +813,13 @@ static void apply_SequenceRule(const Chain *chain, uint16_t glyphCount, const Se
   GlyphArray_append(input_ga, &glyph_array->array[*index], glyphCount);
   for (uint16_t i = 0; i < seqLookupCount; i++) {
     const SequenceLookupRecord *sequenceLookupRecord = &seqLookupRecords[i];
-    const LookupTable *lookupTable = get_lookup(chain->lookupList, parse_16(sequenceLookupRecord->lookupListIndex));
+    // Nested lookups were compiled with the chain, even the ones that aren't part of it.
+    uint16_t lookupIndex = parse_16(sequenceLookupRecord->lookupListIndex);
+    if (lookupIndex >= parse_16(chain->lookupList->lookupCount)) continue;
+    const CompiledLookup *lookup = chain->lookups[lookupIndex];
+    if (lookup == NULL) continue;
     size_t input_index = parse_16(sequenceLookupRecord->sequenceIndex);
-    apply_Lookup_at_index(chain, lookupTable, NULL, input_ga, &input_index);
+    apply_Lookup_at_index(chain, lookup, input_ga, &input_index);
   }
   GlyphArray_put(glyph_array, *index + input_ga->len, glyph_array, *index + glyphCount, glyph_array->len - (*index + glyphCount));
   GlyphArray_put(glyph_array, *index, input_ga, 0, input_ga->len);
@@ -661,13 +856,13 @@ static Bloom get_SequenceSubstitution_bloom(const GenericSequenceContextFormat *
   }
 }
 
-static bool apply_SequenceSubstitution(const Chain *chain, const GenericSequenceContextFormat *genericSequence, GlyphArray* glyph_array, size_t *index) {
+static bool apply_SequenceSubstitution(const Chain *chain, const CompiledSubtable *sub, GlyphArray* glyph_array, size_t *index) {
+  const GenericSequenceContextFormat *genericSequence = (GenericSequenceContextFormat *)sub->table;
   switch (parse_16(genericSequence->format)) {
     case SequenceContextFormat_1: {
       const SequenceContextFormat1 *sequenceContext = (SequenceContextFormat1 *)genericSequence;
-      const CoverageTable *coverageTable = (CoverageTable *)((uint8_t *)sequenceContext + parse_16(sequenceContext->coverageOffset));
       uint32_t coverage_index;
-      bool applicable = find_in_Coverage(coverageTable, glyph_array->array[*index], &coverage_index);
+      bool applicable = find_in_CompiledCoverage(sub->coverage, glyph_array->array[*index], &coverage_index);
       if (!applicable || coverage_index >= parse_16(sequenceContext->seqRuleSetCount)) return false;
 
       const SequenceRuleSet *sequenceRuleSet = (SequenceRuleSet *)((uint8_t *)sequenceContext + parse_16(sequenceContext->seqRuleSetOffsets[coverage_index]));
@@ -691,14 +886,12 @@ static bool apply_SequenceSubstitution(const Chain *chain, const GenericSequence
     }
     case SequenceContextFormat_2: {
       const SequenceContextFormat2 *sequenceContext = (SequenceContextFormat2 *)genericSequence;
-      const CoverageTable *coverageTable = (CoverageTable *)((uint8_t *)sequenceContext + parse_16(sequenceContext->coverageOffset));
-      if (!find_in_Coverage(coverageTable, glyph_array->array[*index], NULL))
+      if (!find_in_CompiledCoverage(sub->coverage, glyph_array->array[*index], NULL))
         return false;
 
-      const ClassDefGeneric *inputClassDef = (ClassDefGeneric *)((uint8_t *)sequenceContext + parse_16(sequenceContext->classDefOffset));
+      const CompiledClassDef *inputClassDef = sub->classDefs[0];
 
-      uint16_t starting_class;
-      find_in_class_array(inputClassDef, glyph_array->array[*index], &starting_class);
+      uint16_t starting_class = find_in_CompiledClassDef(inputClassDef, glyph_array->array[*index]);
       if (starting_class >= parse_16(sequenceContext->classSeqRuleSetCount)) {
         // ??
         break;
@@ -735,7 +928,7 @@ static bool apply_SequenceSubstitution(const Chain *chain, const GenericSequence
       if (*index + glyphCount > glyph_array->len) {
         return false;
       }
-      if (!check_with_Coverage(glyph_array, *index, (uint8_t *)genericSequence, (uint16_t *)((uint8_t *)sequenceContext + sizeof(uint16_t) * 3), glyphCount, +1)) {
+      if (!check_with_Coverage(glyph_array, *index, sub->coverages, glyphCount, +1)) {
         return false;
       }
 
@@ -780,13 +973,13 @@ static Bloom get_ChainedSequenceSubstitution_bloom(const GenericChainedSequenceC
   }
 }
 
-static bool apply_ChainedSequenceSubstitution(const Chain *chain, const GenericChainedSequenceContextFormat *genericChainedSequence, GlyphArray* glyph_array, size_t *index) {
+static bool apply_ChainedSequenceSubstitution(const Chain *chain, const CompiledSubtable *sub, GlyphArray* glyph_array, size_t *index) {
+  const GenericChainedSequenceContextFormat *genericChainedSequence = (GenericChainedSequenceContextFormat *)sub->table;
   switch (parse_16(genericChainedSequence->format)) {
     case ChainedSequenceContextFormat_1: {
       const ChainedSequenceContextFormat1 *chainedSequenceContext = (ChainedSequenceContextFormat1 *)genericChainedSequence;
-      const CoverageTable *coverageTable = (CoverageTable *)((uint8_t *)chainedSequenceContext + parse_16(chainedSequenceContext->coverageOffset));
       uint32_t coverage_index;
-      bool applicable = find_in_Coverage(coverageTable, glyph_array->array[*index], &coverage_index);
+      bool applicable = find_in_CompiledCoverage(sub->coverage, glyph_array->array[*index], &coverage_index);
       if (!applicable || coverage_index >= parse_16(chainedSequenceContext->chainedSeqRuleSetCount)) return false;
 
       const ChainedSequenceRuleSet *chainedSequenceRuleSet = (ChainedSequenceRuleSet *)((uint8_t *)chainedSequenceContext + parse_16(chainedSequenceContext->chainedSeqRuleSetOffsets[coverage_index]));
@@ -827,16 +1020,14 @@ static bool apply_ChainedSequenceSubstitution(const Chain *chain, const GenericC
     }
     case ChainedSequenceContextFormat_2: {
       const ChainedSequenceContextFormat2 *chainedSequenceContext = (ChainedSequenceContextFormat2 *)genericChainedSequence;
-      const CoverageTable *coverageTable = (CoverageTable *)((uint8_t *)chainedSequenceContext + parse_16(chainedSequenceContext->coverageOffset));
-      bool applicable = find_in_Coverage(coverageTable, glyph_array->array[*index], NULL);
+      bool applicable = find_in_CompiledCoverage(sub->coverage, glyph_array->array[*index], NULL);
       if (!applicable) return false;
 
-      const ClassDefGeneric *inputClassDef = (ClassDefGeneric *)((uint8_t *)chainedSequenceContext + parse_16(chainedSequenceContext->inputClassDefOffset));
-      const ClassDefGeneric *backtrackClassDef = (ClassDefGeneric *)((uint8_t *)chainedSequenceContext + parse_16(chainedSequenceContext->backtrackClassDefOffset));
-      const ClassDefGeneric *lookaheadClassDef = (ClassDefGeneric *)((uint8_t *)chainedSequenceContext + parse_16(chainedSequenceContext->lookaheadClassDefOffset));
+      const CompiledClassDef *inputClassDef = sub->classDefs[0];
+      const CompiledClassDef *backtrackClassDef = sub->classDefs[1];
+      const CompiledClassDef *lookaheadClassDef = sub->classDefs[2];
 
-      uint16_t starting_class;
-      find_in_class_array(inputClassDef, glyph_array->array[*index], &starting_class);
+      uint16_t starting_class = find_in_CompiledClassDef(inputClassDef, glyph_array->array[*index]);
 
       if (starting_class >= parse_16(chainedSequenceContext->chainedClassSeqRuleSetCount)) {
         // ??
@@ -898,14 +1089,14 @@ static bool apply_ChainedSequenceSubstitution(const Chain *chain, const GenericC
       if (backtrackGlyphCount > *index) {
         return false;
       }
-      if (!check_with_Coverage(glyph_array, *index, (uint8_t *)genericChainedSequence, (uint16_t *)((uint8_t *)inputCoverage + sizeof(uint16_t) * 1), inputGlyphCount, +1)) {
+      if (!check_with_Coverage(glyph_array, *index, sub->coverages + backtrackGlyphCount, inputGlyphCount, +1)) {
         return false;
       }
       // backtrack is defined with inverse order, so glyph index - 2 will be backtrack coverage index 2
-      if (!check_with_Coverage(glyph_array, *index - 1, (uint8_t *)genericChainedSequence, (uint16_t *)((uint8_t *)backtrackCoverage + sizeof(uint16_t) * 1), backtrackGlyphCount, -1)) {
+      if (!check_with_Coverage(glyph_array, *index - 1, sub->coverages, backtrackGlyphCount, -1)) {
         return false;
       }
-      if (!check_with_Coverage(glyph_array, *index + inputGlyphCount, (uint8_t *)genericChainedSequence, (uint16_t *)((uint8_t *)lookaheadCoverage + sizeof(uint16_t) * 1), lookaheadGlyphCount, +1)) {
+      if (!check_with_Coverage(glyph_array, *index + inputGlyphCount, sub->coverages + backtrackGlyphCount + inputGlyphCount, lookaheadGlyphCount, +1)) {
         return false;
       }
 
@@ -922,12 +1113,12 @@ static bool apply_ChainedSequenceSubstitution(const Chain *chain, const GenericC
 }
 
 
-static bool apply_ReverseChainingContextSingleLookupType(const ReverseChainSingleSubstFormat1 *reverseChain, GlyphArray* glyph_array, size_t index) {
-  CoverageTable *coverageTable = (CoverageTable *)((uint8_t *)reverseChain + parse_16(reverseChain->coverageOffset));
+static bool apply_ReverseChainingContextSingleLookupType(const CompiledSubtable *sub, GlyphArray* glyph_array, size_t index) {
+  const ReverseChainSingleSubstFormat1 *reverseChain = (ReverseChainSingleSubstFormat1 *)sub->table;
   switch (parse_16(reverseChain->substFormat)) {
     case ReverseChainSingleSubstFormat_1: {
       uint32_t coverage_index;
-      bool applicable = find_in_Coverage(coverageTable, glyph_array->array[index], &coverage_index);
+      bool applicable = find_in_CompiledCoverage(sub->coverage, glyph_array->array[index], &coverage_index);
       if (!applicable) return false;
 
       const ReverseChainSingleSubstFormat1_backtrack *backtrackCoverage = (ReverseChainSingleSubstFormat1_backtrack *)((uint8_t *)reverseChain + sizeof(uint16_t) * 2);
@@ -943,10 +1134,10 @@ static bool apply_ReverseChainingContextSingleLookupType(const ReverseChainSingl
         return false;
       }
       // backtrack is defined with inverse order, so glyph index - 2 will be backtrack coverage index 2
-      if (!check_with_Coverage(glyph_array, index - 1, (uint8_t *)reverseChain, (uint16_t *)((uint8_t *)backtrackCoverage + sizeof(uint16_t) * 1), backtrackGlyphCount, -1)) {
+      if (!check_with_Coverage(glyph_array, index - 1, sub->coverages, backtrackGlyphCount, -1)) {
         return false;
       }
-      if (!check_with_Coverage(glyph_array, index + 1, (uint8_t *)reverseChain, (uint16_t *)((uint8_t *)lookaheadCoverage + sizeof(uint16_t) * 1), lookaheadGlyphCount, +1)) {
+      if (!check_with_Coverage(glyph_array, index + 1, sub->coverages + backtrackGlyphCount, lookaheadGlyphCount, +1)) {
         return false;
       }
 
@@ -964,49 +1155,30 @@ static bool apply_ReverseChainingContextSingleLookupType(const ReverseChainSingl
   return false;
 }
 
-static bool apply_Substitution(const Chain *chain, GlyphArray* glyph_array, const GenericSubstTable *genericSubstTable, uint16_t lookupType, size_t *index) {
-  switch (lookupType) {
-    case SingleLookupType: {
-      const SingleSubstFormatGeneric *singleSubstFormatGeneric = (SingleSubstFormatGeneric *)genericSubstTable;
-      return apply_SingleSubstitution(singleSubstFormatGeneric, glyph_array, *index);
-    }
-    case MultipleLookupType: {
-      const MultipleSubstFormat1 *multipleSubstFormat = (MultipleSubstFormat1 *)genericSubstTable;
+static bool apply_Substitution(const Chain *chain, const CompiledSubtable *sub, GlyphArray* glyph_array, size_t *index) {
+  switch (sub->type) {
+    case SingleLookupType:
+      return apply_SingleSubstitution(sub, glyph_array, *index);
+    case MultipleLookupType:
       // Stop at the first one we apply
-      return apply_MultipleSubstitution(multipleSubstFormat, glyph_array, index);
-    }
-    case AlternateLookupType: // TODO: just filter those out at chain creation time...
+      return apply_MultipleSubstitution(sub, glyph_array, index);
+    case AlternateLookupType: // Never reached, its coverage is left empty at chain creation time.
       // We don't really need to support it.
       // Most use-cases revolve around user selection from the list of alternates,
       // which we don't... really care about.
       // Maybe we could think about enabling this for some weird features like 'rand'.
-      fprintf(stderr, "AlternateLookupType unsupported\n");
       return false;
-    case LigatureLookupType: {
-      const LigatureSubstitutionTable *ligatureSubstitutionTable = (LigatureSubstitutionTable *)genericSubstTable;
+    case LigatureLookupType:
       // Stop at the first one we apply
-      return apply_LigatureSubstitution(ligatureSubstitutionTable, glyph_array, *index);
-    }
-    case ContextLookupType: {
-      const GenericSequenceContextFormat *genericSequence = (GenericSequenceContextFormat *)genericSubstTable;
-      return apply_SequenceSubstitution(chain, genericSequence, glyph_array, index);
-    }
-    case ChainingLookupType: {
-      const GenericChainedSequenceContextFormat *genericChainedSequence = (GenericChainedSequenceContextFormat *)genericSubstTable;
-      return apply_ChainedSequenceSubstitution(chain, genericChainedSequence, glyph_array, index);
-    }
-    case ExtensionSubstitutionLookupType: {
-      const ExtensionSubstitutionTable *extensionSubstitutionTable = (ExtensionSubstitutionTable *)genericSubstTable;
-      const GenericSubstTable *_genericSubstTable = (GenericSubstTable *)((uint8_t *)extensionSubstitutionTable + parse_32(extensionSubstitutionTable->extensionOffset));
-      return apply_Substitution(chain, glyph_array, _genericSubstTable, parse_16(extensionSubstitutionTable->extensionLookupType), index);
-    }
-    case ReverseChainingContextSingleLookupType: {
-      const ReverseChainSingleSubstFormat1 *reverseChain = (ReverseChainSingleSubstFormat1 *)genericSubstTable;
+      return apply_LigatureSubstitution(sub, glyph_array, *index);
+    case ContextLookupType:
+      return apply_SequenceSubstitution(chain, sub, glyph_array, index);
+    case ChainingLookupType:
+      return apply_ChainedSequenceSubstitution(chain, sub, glyph_array, index);
+    case ReverseChainingContextSingleLookupType:
       // Stop at the first one we apply
-      return apply_ReverseChainingContextSingleLookupType(reverseChain, glyph_array, *index);
-    }
+      return apply_ReverseChainingContextSingleLookupType(sub, glyph_array, *index);
     default:
-      fprintf(stderr, "UNKNOWN LookupType\n");
       return false;
   }
 }
@@ -1056,100 +1228,326 @@ static Bloom get_Substitution_bloom(const GenericSubstTable *genericSubstTable,
   }
 }
 
-// Returns the bloom digest that matches with the glyphs that "start" any of the
-// Substitution tables of the Lookup.
-static Bloom get_cached_Lookup_bloom(const Chain *chain, const LookupTable *lookupTable, uint16_t lookupType) {
-  Bloom lookup_bloom = null_bloom;
-  if (!get_from_Bloom_hash(chain->bloom_hash, lookupTable, &lookup_bloom)) {
-    uint16_t subTableCount = parse_16(lookupTable->subTableCount);
-    for (uint16_t i = 0; i < subTableCount; i++) {
-      const GenericSubstTable *genericSubstTable = (GenericSubstTable *)((uint8_t *)lookupTable + parse_16(lookupTable->subtableOffsets[i]));
-      Bloom _bloom = null_bloom;
-      if (!get_from_Bloom_hash(chain->bloom_hash, genericSubstTable, &_bloom)) {
-        _bloom = get_Substitution_bloom(genericSubstTable, lookupType);
-        set_to_Bloom_hash(chain->bloom_hash, genericSubstTable, _bloom);
+// Compiles the tables a Substitution needs into sub.
+// Returns false if we ran out of memory.
+static bool compile_Substitution(Chain *chain, CompiledSubtable *sub) {
+  const uint8_t *base = (const uint8_t *)sub->table;
+  sub->coverage = &empty_coverage;
+  switch (sub->type) {
+    case SingleLookupType:
+    case MultipleLookupType:
+    case LigatureLookupType:
+    case ReverseChainingContextSingleLookupType: {
+      // All of them have the coverage in the same place
+      const SingleSubstFormatGeneric *genericSubst = (SingleSubstFormatGeneric *)base;
+      sub->coverage = compile_Coverage(chain, (CoverageTable *)(base + parse_16(genericSubst->coverageOffset)));
+      if (sub->coverage == NULL) return false;
+      if (sub->type == LigatureLookupType) {
+        sub->ligatures = compile_LigatureTrie(chain, (LigatureSubstitutionTable *)base);
+        return sub->ligatures != NULL;
+      }
+      if (sub->type == ReverseChainingContextSingleLookupType) {
+        const ReverseChainSingleSubstFormat1_backtrack *backtrackCoverage = (ReverseChainSingleSubstFormat1_backtrack *)(base + sizeof(uint16_t) * 2);
+        uint16_t backtrackGlyphCount = parse_16(backtrackCoverage->backtrackGlyphCount);
+        const ReverseChainSingleSubstFormat1_lookahead *lookaheadCoverage = (ReverseChainSingleSubstFormat1_lookahead *)((uint8_t *)backtrackCoverage + sizeof(uint16_t) * (backtrackGlyphCount + 1));
+        uint16_t lookaheadGlyphCount = parse_16(lookaheadCoverage->lookaheadGlyphCount);
+        const CompiledCoverage **coverages = arena_alloc(chain, (backtrackGlyphCount + lookaheadGlyphCount) * sizeof(CompiledCoverage *));
+        if (coverages == NULL) return false;
+        sub->coverages = coverages;
+        return compile_Coverage_array(chain, base, backtrackCoverage->backtrackCoverageOffsets, backtrackGlyphCount, coverages)
+            && compile_Coverage_array(chain, base, lookaheadCoverage->lookaheadCoverageOffsets, lookaheadGlyphCount, coverages + backtrackGlyphCount);
+      }
+      return true;
+    }
+    case AlternateLookupType:
+      return true;
+    case ContextLookupType: {
+      const GenericSequenceContextFormat *genericSequence = (GenericSequenceContextFormat *)base;
+      switch (parse_16(genericSequence->format)) {
+        case SequenceContextFormat_1: {
+          const SequenceContextFormat1 *sequenceContext = (SequenceContextFormat1 *)base;
+          sub->coverage = compile_Coverage(chain, (CoverageTable *)(base + parse_16(sequenceContext->coverageOffset)));
+          return sub->coverage != NULL;
+        }
+        case SequenceContextFormat_2: {
+          const SequenceContextFormat2 *sequenceContext = (SequenceContextFormat2 *)base;
+          sub->coverage = compile_Coverage(chain, (CoverageTable *)(base + parse_16(sequenceContext->coverageOffset)));
+          sub->classDefs[0] = compile_ClassDef(chain, (ClassDefGeneric *)(base + parse_16(sequenceContext->classDefOffset)));
+          return sub->coverage != NULL && sub->classDefs[0] != NULL;
+        }
+        case SequenceContextFormat_3: {
+          const SequenceContextFormat3 *sequenceContext = (SequenceContextFormat3 *)base;
+          uint16_t glyphCount = parse_16(sequenceContext->glyphCount);
+          const CompiledCoverage **coverages = arena_alloc(chain, glyphCount * sizeof(CompiledCoverage *));
+          if (coverages == NULL) return false;
+          if (!compile_Coverage_array(chain, base, (uint16_t *)(base + sizeof(uint16_t) * 3), glyphCount, coverages)) return false;
+          sub->coverages = coverages;
+          sub->coverage = glyphCount != 0 ? coverages[0] : NULL;
+          return true;
+        }
+        default:
+          fprintf(stderr, "UNKNOWN SequenceContextFormat %d\n", parse_16(genericSequence->format));
+          return true;
+      }
+    }
+    case ChainingLookupType: {
+      const GenericChainedSequenceContextFormat *genericChainedSequence = (GenericChainedSequenceContextFormat *)base;
+      switch (parse_16(genericChainedSequence->format)) {
+        case ChainedSequenceContextFormat_1: {
+          const ChainedSequenceContextFormat1 *chainedSequenceContext = (ChainedSequenceContextFormat1 *)base;
+          sub->coverage = compile_Coverage(chain, (CoverageTable *)(base + parse_16(chainedSequenceContext->coverageOffset)));
+          return sub->coverage != NULL;
+        }
+        case ChainedSequenceContextFormat_2: {
+          const ChainedSequenceContextFormat2 *chainedSequenceContext = (ChainedSequenceContextFormat2 *)base;
+          sub->coverage = compile_Coverage(chain, (CoverageTable *)(base + parse_16(chainedSequenceContext->coverageOffset)));
+          sub->classDefs[0] = compile_ClassDef(chain, (ClassDefGeneric *)(base + parse_16(chainedSequenceContext->inputClassDefOffset)));
+          sub->classDefs[1] = compile_ClassDef(chain, (ClassDefGeneric *)(base + parse_16(chainedSequenceContext->backtrackClassDefOffset)));
+          sub->classDefs[2] = compile_ClassDef(chain, (ClassDefGeneric *)(base + parse_16(chainedSequenceContext->lookaheadClassDefOffset)));
+          return sub->coverage != NULL && sub->classDefs[0] != NULL && sub->classDefs[1] != NULL && sub->classDefs[2] != NULL;
+        }
+        case ChainedSequenceContextFormat_3: {
+          const ChainedSequenceContextFormat3_backtrack *backtrackCoverage = (ChainedSequenceContextFormat3_backtrack *)(base + sizeof(uint16_t));
+          uint16_t backtrackGlyphCount = parse_16(backtrackCoverage->backtrackGlyphCount);
+          const ChainedSequenceContextFormat3_input *inputCoverage = (ChainedSequenceContextFormat3_input *)((uint8_t *)backtrackCoverage + sizeof(uint16_t) * (backtrackGlyphCount + 1));
+          uint16_t inputGlyphCount = parse_16(inputCoverage->inputGlyphCount);
+          const ChainedSequenceContextFormat3_lookahead *lookaheadCoverage = (ChainedSequenceContextFormat3_lookahead *)((uint8_t *)inputCoverage + sizeof(uint16_t) * (inputGlyphCount + 1));
+          uint16_t lookaheadGlyphCount = parse_16(lookaheadCoverage->lookaheadGlyphCount);
+
+          const CompiledCoverage **coverages = arena_alloc(chain, ((size_t)backtrackGlyphCount + inputGlyphCount + lookaheadGlyphCount) * sizeof(CompiledCoverage *));
+          if (coverages == NULL) return false;
+          if (!compile_Coverage_array(chain, base, (uint16_t *)((uint8_t *)backtrackCoverage + sizeof(uint16_t)), backtrackGlyphCount, coverages)
+              || !compile_Coverage_array(chain, base, (uint16_t *)((uint8_t *)inputCoverage + sizeof(uint16_t)), inputGlyphCount, coverages + backtrackGlyphCount)
+              || !compile_Coverage_array(chain, base, (uint16_t *)((uint8_t *)lookaheadCoverage + sizeof(uint16_t)), lookaheadGlyphCount, coverages + backtrackGlyphCount + inputGlyphCount))
+            return false;
+          sub->coverages = coverages;
+          sub->coverage = inputGlyphCount != 0 ? coverages[backtrackGlyphCount] : NULL;
+          return true;
+        }
+        default:
+          fprintf(stderr, "UNKNOWN ChainedSequenceContextFormat %d\n", parse_16(genericChainedSequence->format));
+          return true;
       }
-      lookup_bloom = add_bloom_to_bloom(lookup_bloom, _bloom);
-      if (is_full_bloom(lookup_bloom)) break;
     }
-    set_to_Bloom_hash(chain->bloom_hash, lookupTable, lookup_bloom);
+    default:
+      fprintf(stderr, "UNKNOWN LookupType\n");
+      return true;
   }
-  return lookup_bloom;
 }
 
-// Returns the bloom digests for all the Substitution tables of the Lookup.
-static Bloom *get_cached_Substitution_blooms_for_Lookup(const Chain *chain, const LookupTable *lookupTable, uint16_t lookupType) {
-  Bloom* sub_blooms = NULL;
-  if (!get_from_uintptr_t_hash(chain->ptr_hash, lookupTable, (uintptr_t*)&sub_blooms)){
-    uint16_t subTableCount = parse_16(lookupTable->subTableCount);
-    sub_blooms = malloc(subTableCount * sizeof(Bloom));
-    if (sub_blooms == NULL) return NULL; // TODO: panic?
+// Returns the compiled Lookup at index in the LookupList, compiling it if needed.
+static const CompiledLookup *get_compiled_Lookup(Chain *chain, uint16_t index) {
+  if (index >= parse_16(chain->lookupList->lookupCount)) return NULL;
+  if (chain->lookups[index] != NULL) return chain->lookups[index];
+
+  const LookupTable *lookupTable = get_lookup(chain->lookupList, index);
+  uint16_t subTableCount = parse_16(lookupTable->subTableCount);
+  CompiledLookup *lookup = arena_alloc(chain, sizeof(CompiledLookup));
+  CompiledSubtable *subtables = arena_alloc(chain, subTableCount * sizeof(CompiledSubtable));
+  if (lookup == NULL || subtables == NULL) return NULL;
+  lookup->type = parse_16(lookupTable->lookupType);
+  lookup->subTableCount = subTableCount;
+  lookup->subtables = subtables;
+  lookup->bloom = null_bloom;
+
+  bool any_glyph = false;
+  uint16_t first = 0xFFFF, last = 0;
+  for (uint16_t i = 0; i < subTableCount; i++) {
+    CompiledSubtable *sub = &subtables[i];
+    sub->table = (GenericSubstTable *)((uint8_t *)lookupTable + parse_16(lookupTable->subtableOffsets[i]));
+    sub->type = lookup->type;
+    if (sub->type == ExtensionSubstitutionLookupType) {
+      const ExtensionSubstitutionTable *extensionSubstitutionTable = (ExtensionSubstitutionTable *)sub->table;
+      sub->table = (GenericSubstTable *)((uint8_t *)extensionSubstitutionTable + parse_32(extensionSubstitutionTable->extensionOffset));
+      sub->type = parse_16(extensionSubstitutionTable->extensionLookupType);
+    }
+    if (!compile_Substitution(chain, sub)) return NULL;
+
+    lookup->bloom = add_bloom_to_bloom(lookup->bloom, get_Substitution_bloom(sub->table, sub->type));
+    if (sub->coverage == NULL) {
+      any_glyph = true;
+    } else if (sub->coverage->first <= sub->coverage->last) {
+      if (sub->coverage->first < first) first = sub->coverage->first;
+      if (sub->coverage->last > last) last = sub->coverage->last;
+    }
+  }
+  // Every subtable of an Extension lookup has the same type, which is the one that matters when applying.
+  if (subTableCount != 0) lookup->type = subtables[0].type;
 
+  if (!any_glyph) {
+    CompiledCoverage *filter = new_CompiledCoverage(chain, first, last, false);
+    if (filter == NULL) return NULL;
     for (uint16_t i = 0; i < subTableCount; i++) {
-      const GenericSubstTable *genericSubstTable = (GenericSubstTable *)((uint8_t *)lookupTable + parse_16(lookupTable->subtableOffsets[i]));
-      Bloom _bloom = null_bloom;
-      if (!get_from_Bloom_hash(chain->bloom_hash, genericSubstTable, &_bloom)) {
-        _bloom = get_Substitution_bloom(genericSubstTable, lookupType);
-        set_to_Bloom_hash(chain->bloom_hash, genericSubstTable, _bloom);
+      const CompiledCoverage *coverage = subtables[i].coverage;
+      for (uint32_t id = coverage->first; id <= coverage->last; id++) {
+        if (find_in_CompiledCoverage(coverage, id, NULL)) add_to_CompiledCoverage(filter, id);
       }
-      sub_blooms[i] = _bloom;
     }
-    set_to_uintptr_t_hash(chain->ptr_hash, lookupTable, (uintptr_t)sub_blooms);
+    lookup->filter = filter;
   }
-  return sub_blooms;
+
+  chain->lookups[index] = lookup;
+  return lookup;
 }
 
-static void apply_Lookup_at_index(const Chain *chain, const LookupTable *lookupTable, const Bloom* blooms, GlyphArray* glyph_array, size_t *index) {
-  uint16_t lookupType = parse_16(lookupTable->lookupType);
-  uint16_t glyphID = glyph_array->array[*index];
-  Bloom glyphID_bloom = get_glyphID_bloom(glyphID);
+// LookupList indices still to be checked for nested lookups, each only queued once.
+typedef struct {
+  uint16_t *indices;
+  size_t len;
+  bool *queued;
+  uint16_t lookupCount;
+} LookupQueue;
 
-  // Obtain the bloom digests of the Substitution tables of the Lookup.
-  // We get NULL here when we come from apply_SequenceRule.
-  if (blooms == NULL) {
-    blooms = get_cached_Substitution_blooms_for_Lookup(chain, lookupTable, lookupType);
+static void queue_SequenceLookupRecords(LookupQueue *queue, const SequenceLookupRecord *seqLookupRecords, uint16_t seqLookupCount) {
+  for (uint16_t i = 0; i < seqLookupCount; i++) {
+    uint16_t index = parse_16(seqLookupRecords[i].lookupListIndex);
+    if (index >= queue->lookupCount || queue->queued[index]) continue;
+    queue->queued[index] = true;
+    queue->indices[queue->len++] = index;
   }
+}
 
-  // Stop at the first Substitution that's successfully applied.
-  uint16_t subTableCount = parse_16(lookupTable->subTableCount);
-  for (uint16_t i = 0; i < subTableCount; i++) {
-    const GenericSubstTable *genericSubstTable = (GenericSubstTable *)((uint8_t *)lookupTable + parse_16(lookupTable->subtableOffsets[i]));
-    if (blooms != NULL) {
-      // If the glyph doesn't match the bloom digest for the Substitution, skip it.
-      if (!glyphID_bloom_compare_bloom(glyphID_bloom, blooms[i])) {
-        continue;
+// Queues every lookup the rules of a contextual Substitution can apply.
+static void queue_nested_Lookups(LookupQueue *queue, const CompiledSubtable *sub) {
+  const uint8_t *base = (const uint8_t *)sub->table;
+  if (sub->type == ContextLookupType) {
+    switch (parse_16(((GenericSequenceContextFormat *)base)->format)) {
+      case SequenceContextFormat_1:
+      case SequenceContextFormat_2: {
+        // Both formats have the same layout past the ClassDef, only with classes instead of glyphs in the rules
+        bool classes = parse_16(((GenericSequenceContextFormat *)base)->format) == SequenceContextFormat_2;
+        const uint16_t *ruleSetOffsets = classes ? ((SequenceContextFormat2 *)base)->classSeqRuleSetOffsets : ((SequenceContextFormat1 *)base)->seqRuleSetOffsets;
+        uint16_t ruleSetCount = parse_16(classes ? ((SequenceContextFormat2 *)base)->classSeqRuleSetCount : ((SequenceContextFormat1 *)base)->seqRuleSetCount);
+        for (uint16_t i = 0; i < ruleSetCount; i++) {
+          if (ruleSetOffsets[i] == 0) continue;
+          const SequenceRuleSet *ruleSet = (SequenceRuleSet *)(base + parse_16(ruleSetOffsets[i]));
+          for (uint16_t j = 0; j < parse_16(ruleSet->seqRuleCount); j++) {
+            const SequenceRule *rule = (SequenceRule *)((uint8_t *)ruleSet + parse_16(ruleSet->seqRuleOffsets[j]));
+            const SequenceLookupRecord *seqLookupRecords = (SequenceLookupRecord *)((uint8_t *)rule + (1 + parse_16(rule->glyphCount)) * sizeof(uint16_t));
+            queue_SequenceLookupRecords(queue, seqLookupRecords, parse_16(rule->seqLookupCount));
+          }
+        }
+        break;
+      }
+      case SequenceContextFormat_3: {
+        const SequenceContextFormat3 *sequenceContext = (SequenceContextFormat3 *)base;
+        const SequenceLookupRecord *seqLookupRecords = (SequenceLookupRecord *)(base + (2 + parse_16(sequenceContext->glyphCount) + 1) * sizeof(uint16_t));
+        queue_SequenceLookupRecords(queue, seqLookupRecords, parse_16(sequenceContext->seqLookupCount));
+        break;
       }
     }
-    if (apply_Substitution(chain, glyph_array, genericSubstTable, lookupType, index)) {
+  } else if (sub->type == ChainingLookupType) {
+    switch (parse_16(((GenericChainedSequenceContextFormat *)base)->format)) {
+      case ChainedSequenceContextFormat_1:
+      case ChainedSequenceContextFormat_2: {
+        bool classes = parse_16(((GenericChainedSequenceContextFormat *)base)->format) == ChainedSequenceContextFormat_2;
+        const uint16_t *ruleSetOffsets = classes ? ((ChainedSequenceContextFormat2 *)base)->chainedClassSeqRuleSetOffsets : ((ChainedSequenceContextFormat1 *)base)->chainedSeqRuleSetOffsets;
+        uint16_t ruleSetCount = parse_16(classes ? ((ChainedSequenceContextFormat2 *)base)->chainedClassSeqRuleSetCount : ((ChainedSequenceContextFormat1 *)base)->chainedSeqRuleSetCount);
+        for (uint16_t i = 0; i < ruleSetCount; i++) {
+          if (ruleSetOffsets[i] == 0) continue;
+          const ChainedSequenceRuleSet *ruleSet = (ChainedSequenceRuleSet *)(base + parse_16(ruleSetOffsets[i]));
+          for (uint16_t j = 0; j < parse_16(ruleSet->chainedSeqRuleCount); j++) {
+            // Backtrack, input (without its first glyph) and lookahead sequences, each after its count
+            const uint8_t *at = (uint8_t *)ruleSet + parse_16(ruleSet->chainedSeqRuleOffsets[j]);
+            at += sizeof(uint16_t) * (1 + parse_16(((ChainedSequenceRule_generic *)at)->glyphCount));
+            at += sizeof(uint16_t) * parse_16(((ChainedSequenceRule_generic *)at)->glyphCount);
+            at += sizeof(uint16_t) * (1 + parse_16(((ChainedSequenceRule_generic *)at)->glyphCount));
+            const ChainedSequenceRule_seq *sequenceRule = (ChainedSequenceRule_seq *)at;
+            queue_SequenceLookupRecords(queue, sequenceRule->seqLookupRecords, parse_16(sequenceRule->seqLookupCount));
+          }
+        }
+        break;
+      }
+      case ChainedSequenceContextFormat_3: {
+        const uint8_t *at = base + sizeof(uint16_t);
+        for (int k = 0; k < 3; k++) at += sizeof(uint16_t) * (1 + parse_16(((ChainedSequenceRule_generic *)at)->glyphCount));
+        const ChainedSequenceContextFormat3_seq *seqCoverage = (ChainedSequenceContextFormat3_seq *)at;
+        queue_SequenceLookupRecords(queue, seqCoverage->seqLookupRecords, parse_16(seqCoverage->seqLookupCount));
+        break;
+      }
+    }
+  }
+}
+
+// Compiles the lookups that contextual rules apply, which don't have to be part of the chain themselves,
+// and the ones those apply in turn. A queue instead of recursion, since lookups can reach each other in cycles.
+static bool compile_nested_Lookups(Chain *chain) {
+  uint16_t lookupCount = parse_16(chain->lookupList->lookupCount);
+  LookupQueue queue = { .indices = malloc(lookupCount * sizeof(uint16_t) + 1), .queued = calloc(lookupCount + 1, sizeof(bool)), .lookupCount = lookupCount };
+  bool ok = queue.indices != NULL && queue.queued != NULL;
+  for (size_t i = 0; ok && i < chain->lookupCount; i++) {
+    uint16_t index = chain->lookupIndices[i];
+    if (!queue.queued[index]) queue.queued[index] = true, queue.indices[queue.len++] = index;
+  }
+  while (ok && queue.len > 0) {
+    // Nested lookups that don't compile get skipped when applying, like before
+    const CompiledLookup *lookup = get_compiled_Lookup(chain, queue.indices[--queue.len]);
+    if (lookup == NULL) continue;
+    for (uint16_t i = 0; i < lookup->subTableCount; i++) queue_nested_Lookups(&queue, &lookup->subtables[i]);
+  }
+  free(queue.indices);
+  free(queue.queued);
+  return ok;
+}
+
+static void apply_Lookup_at_index(const Chain *chain, const CompiledLookup *lookup, GlyphArray* glyph_array, size_t *index) {
+  // Stop at the first Substitution that's successfully applied.
+  // Every Substitution starts by checking its compiled coverage, so the ones that can't apply are skipped quickly.
+  for (uint16_t i = 0; i < lookup->subTableCount; i++) {
+    if (apply_Substitution(chain, &lookup->subtables[i], glyph_array, index)) {
       break;
     }
   }
 }
 
-static void apply_Lookup(const Chain *chain, const LookupTable *lookupTable, GlyphArray* glyph_array) {
+// Ligatures can only shrink the GlyphArray, so instead of shifting the rest of the array after every
+// ligature like apply_LigatureSubstitution does, a Ligature lookup compacts the glyphs in place in one pass.
+static void apply_LigatureLookup(const CompiledLookup *lookup, GlyphArray* glyph_array) {
+  uint16_t *glyphs = glyph_array->array;
+  size_t len = glyph_array->len, out = 0;
+  const CompiledCoverage *filter = lookup->filter;
+  for (size_t index = 0; index < len;) {
+    const LigatureNode *ligature = NULL;
+    if (filter == NULL || find_in_CompiledCoverage(filter, glyphs[index], NULL)) {
+      // Stop at the first Substitution that's successfully applied.
+      for (uint16_t i = 0; i < lookup->subTableCount && ligature == NULL; i++) {
+        ligature = match_Ligature(&lookup->subtables[i], glyphs, len, index);
+      }
+    }
+    // out never passes index, so the glyphs still to be matched are left untouched.
+    if (ligature != NULL) {
+      glyphs[out++] = ligature->ligature;
+      index += ligature->depth + 1;
+      if (glyph_array->bloom_valid) glyph_array->bloom = add_glyphID_to_bloom(glyph_array->bloom, ligature->ligature);
+    } else {
+      glyphs[out++] = glyphs[index++];
+    }
+  }
+  GlyphArray_shrink(glyph_array, len - out);
+}
+
+static void apply_Lookup(const Chain *chain, const CompiledLookup *lookup, GlyphArray* glyph_array) {
   size_t index = 0, reverse_index = glyph_array->len - 1, *index_ptr = &index;
-  uint16_t lookupType = parse_16(lookupTable->lookupType);
   // ReverseChaining needs to be applied in reverse order.
-  if (lookupType == ReverseChainingContextSingleLookupType)
+  if (lookup->type == ReverseChainingContextSingleLookupType)
     index_ptr = &reverse_index;
 
-  // Get bloom for the whole lookup.
-  Bloom lookup_bloom = get_cached_Lookup_bloom(chain, lookupTable, lookupType);
-
   // If no glyph in the input matches any of the Substitutions, skip the Lookup.
   Bloom ga_bloom = GlyphArray_get_bloom(glyph_array);
-  if (!bloom_compare_bloom(ga_bloom, lookup_bloom)) {
+  if (!bloom_compare_bloom(ga_bloom, lookup->bloom)) {
     return;
   }
 
-  // Extract list of blooms from the hashtable to let apply_Lookup_at_index skip
-  // getting them for each glyph.
-  Bloom* sub_blooms = get_cached_Substitution_blooms_for_Lookup(chain, lookupTable, lookupType);
+  if (lookup->type == LigatureLookupType) {
+    apply_LigatureLookup(lookup, glyph_array);
+    return;
+  }
 
+  const CompiledCoverage *filter = lookup->filter;
   while (index < glyph_array->len) {
-    // If the current glyph doesn't match any of the Substitutions, skip it.
-    if ((glyphID_compare_bloom(glyph_array->array[*index_ptr], lookup_bloom))) {
-      apply_Lookup_at_index(chain, lookupTable, sub_blooms, glyph_array, index_ptr);
+    // If the current glyph can't start any of the Substitutions, skip it.
+    if (filter == NULL || find_in_CompiledCoverage(filter, glyph_array->array[*index_ptr], NULL)) {
+      apply_Lookup_at_index(chain, lookup, glyph_array, index_ptr);
     }
     index++;
     // ReverseChaining doesn't change the number of glyphs, so we can just do --.
@@ -1159,7 +1557,7 @@ static void apply_Lookup(const Chain *chain, const LookupTable *lookupTable, Gly
 
 void apply_chain(const Chain *chain, GlyphArray* glyph_array) {
   for (size_t i = 0; i < chain->lookupCount; i++) {
-    apply_Lookup(chain, chain->lookupsArray[i], glyph_array);
+    const CompiledLookup *lookup = chain->lookups[chain->lookupIndices[i]];
+    if (lookup != NULL) apply_Lookup(chain, lookup, glyph_array);
   }
 }
-
@@ -81,8 +81,9 @@ LBT_Chain LIBATURES_PUBLIC *LBT_generate_chain(const LBT_ChainCreator *cc,
 /**
  * \brief Apply chain to an `LBT_Glyph` array.
  *
- * This function is not thread-safe. Create multiple chains to execute them in
- * parallel.
+ * The chain is only read, everything it can reach was compiled by
+ * ::LBT_generate_chain, so one chain can be applied from several threads at
+ * once.
  *
  * \param[in] chain
  * \param[in] glyph_array Array of glyphs to "ligate".
@@ -0,0 +1,155 @@
+/*
+ * cvec.h v1.0.0 - Aqil Contractor @AqilC 2024
+ * Licenced under Attribution-NonCommercial-ShareAlike 3.0
+ *
+ * Vector that any number of threads can append to at once without a lock. Elements go into fixed size chunks, an
+ * append reserves its spot with one atomic add on the current chunk, and whichever thread finds the chunk full links
+ * the next one with a compare and swap. Nothing ever moves once it's been appended, so pointers to elements stay good
+ * until the vector is reset.
+ * Compile by adding a file called `cvec.c` with the following contents in your project:
+ *     #define CVEC_H_IMPLEMENTATION
+ *     #include <cvec.h>
+ *
+ * Options provided by defines before including:
+ *   CVEC_H_STATIC_INLINE:
+ *     Implements all methods as static inline. Automatically defines CVEC_H_IMPLEMENTATION.
+ *   CVEC_H_MALLOC / CVEC_H_FREE:
+ *     Names for user-provided malloc(size_t) and free(void*) functions.
+ *
+ * Appending is the only thing that's thread safe. Reading, cvec_reset and cvec_free are for one thread, once every
+ * append has finished (after joining the threads that made them, for example):
+ *     cvec_each(&v, chunk)
+ *         for(uint32_t i = 0; i < cvec_chunk_len(chunk); i ++) use(((thing*) chunk->data)[i]);
+ */
+
+#ifndef CVEC_H
+#define CVEC_H
+
+#ifdef CVEC_H_STATIC_INLINE
+	#define CVEC_H_IMPLEMENTATION
+	#define CVEC_H_EXTERN static inline
+#else
+	#define CVEC_H_EXTERN
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+typedef struct cvec_chunk {
+	struct cvec_chunk* _Atomic next;
+	_Atomic uint32_t reserved; // Elements handed out, which goes past cap once appends stop fitting
+	_Atomic uint32_t end;      // Where the elements stop, before cap when the append that ran out of room didn't fit
+	uint32_t cap;
+	_Alignas(16) uint8_t data[];
+} cvec_chunk;
+
+typedef struct cvec {
+	cvec_chunk* head;
+	cvec_chunk* _Atomic tail; // The chunk appends go to
+	uint32_t size;            // Bytes per element
+	uint32_t chunk;           // Elements per chunk, and the most one append can take
+} cvec;
+
+CVEC_H_EXTERN bool cvec_init(cvec* v, uint32_t size, uint32_t chunk);
+// Appends n elements next to each other and returns where to write them, or NULL when n is more than a chunk holds
+// or there's no memory left. Thread safe.
+CVEC_H_EXTERN void* cvec_push(cvec* v, uint32_t n);
+CVEC_H_EXTERN uint64_t cvec_len(const cvec* v);
+// Empties the vector but keeps its chunks, so the next round of appends doesn't allocate.
+CVEC_H_EXTERN void cvec_reset(cvec* v);
+CVEC_H_EXTERN void cvec_free(cvec* v);
+
+static inline uint32_t cvec_chunk_len(const cvec_chunk* c) {
+	uint32_t reserved = atomic_load_explicit(&c->reserved, memory_order_relaxed);
+	uint32_t end = atomic_load_explicit(&c->end, memory_order_relaxed);
+	return reserved < end ? reserved : end;
+}
+
+// Loops over the chunks in the order they were filled
+#define cvec_each(v, c) for(cvec_chunk* c = (v)->head; c; c = atomic_load_explicit(&c->next, memory_order_acquire))
+
+#endif
+
+#ifdef CVEC_H_IMPLEMENTATION
+
+#if !defined CVEC_H_MALLOC || !defined CVEC_H_FREE
+	#include <stdlib.h>
+#endif
+
+#ifndef CVEC_H_MALLOC
+	#define CVEC_H_MALLOC malloc
+#endif
+
+#ifndef CVEC_H_FREE
+	#define CVEC_H_FREE free
+#endif
+
+static inline cvec_chunk* cvec_chunk_new_(const cvec* v) {
+	cvec_chunk* c = CVEC_H_MALLOC(sizeof(cvec_chunk) + (size_t) v->chunk * v->size);
+	if(!c) return NULL;
+	atomic_init(&c->next, NULL);
+	atomic_init(&c->reserved, 0);
+	atomic_init(&c->end, v->chunk);
+	c->cap = v->chunk;
+	return c;
+}
+
+CVEC_H_EXTERN bool cvec_init(cvec* v, uint32_t size, uint32_t chunk) {
+	v->size = size;
+	v->chunk = chunk;
+	v->head = cvec_chunk_new_(v);
+	atomic_init(&v->tail, v->head);
+	return v->head;
+}
+
+CVEC_H_EXTERN void* cvec_push(cvec* v, uint32_t n) {
+	if(!n || n > v->chunk) return NULL;
+	cvec_chunk* c = atomic_load_explicit(&v->tail, memory_order_acquire);
+	for(;;) {
+		uint32_t at = atomic_fetch_add_explicit(&c->reserved, n, memory_order_relaxed);
+		if(at + n <= c->cap) return c->data + (size_t) at * v->size;
+
+		// Reservations are handed out in order, so exactly one append straddles the end, and that's where the chunk
+		// stops. Everyone that didn't fit goes on to the next chunk, making it if nobody has yet.
+		if(at < c->cap) atomic_store_explicit(&c->end, at, memory_order_relaxed);
+		cvec_chunk* next = atomic_load_explicit(&c->next, memory_order_acquire);
+		if(!next) {
+			cvec_chunk* made = cvec_chunk_new_(v);
+			if(!made) return NULL;
+			if(atomic_compare_exchange_strong_explicit(&c->next, &next, made, memory_order_acq_rel, memory_order_acquire)) next = made;
+			else CVEC_H_FREE(made); // Lost the race, next is the one that got linked
+		}
+
+		// Moves the tail along for everyone else, unless someone already did
+		cvec_chunk* expected = c;
+		atomic_compare_exchange_strong_explicit(&v->tail, &expected, next, memory_order_acq_rel, memory_order_relaxed);
+		c = next;
+	}
+}
+
+CVEC_H_EXTERN uint64_t cvec_len(const cvec* v) {
+	uint64_t len = 0;
+	cvec_each(v, c) len += cvec_chunk_len(c);
+	return len;
+}
+
+CVEC_H_EXTERN void cvec_reset(cvec* v) {
+	cvec_each(v, c) {
+		atomic_store_explicit(&c->reserved, 0, memory_order_relaxed);
+		atomic_store_explicit(&c->end, c->cap, memory_order_relaxed);
+	}
+	atomic_store_explicit(&v->tail, v->head, memory_order_release);
+}
+
+CVEC_H_EXTERN void cvec_free(cvec* v) {
+	for(cvec_chunk* c = v->head; c;) {
+		cvec_chunk* next = atomic_load_explicit(&c->next, memory_order_relaxed);
+		CVEC_H_FREE(c);
+		c = next;
+	}
+	v->head = NULL;
+	atomic_store_explicit(&v->tail, NULL, memory_order_relaxed);
+}
+
+#endif
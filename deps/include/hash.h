@@ -24,55 +24,44 @@
 */
 
 /*
-  An example:
-
-#include "hash.h"
-KHASH_MAP_INIT_INT(32, char)
-int main() {
-  int ret, is_missing;
-  ht_iter_t k;
-  ht_hash_t(32) *h = ht_init(32);
-  k = ht_put(32, h, 5, &ret);
-  ht_value(h, k) = 10;
-  k = ht_get(32, h, 10);
-  is_missing = (k == ht_end(h));
-  k = ht_get(32, h, 5);
-  ht_del(32, h, k);
-  for (k = ht_begin(h); k != ht_end(h); ++k)
-    if (ht_exist(h, k)) ht_value(h, k) = 1;
-  ht_destroy(32, h);
-  return 0;
-}
-*/
-
-
-#ifndef __AC_KHASH_H
-#define __AC_KHASH_H
-
-/*!
-  @header
-
-  Generic hash table library.
+ * hash.h v2.0.0 - Aqil Contractor @AqilC 2024
+ *
+ * Open addressing hash table laid out like Abseil's SwissTable. Every slot has a control byte: empty, deleted, or 7
+ * bits of the hash of the key in it. Slots are probed 16 at a time, one SSE2 compare of the control bytes finds
+ * the ones worth comparing keys with, and a group with an empty slot in it ends the probe. Deleting from a group that
+ * has an empty slot makes it empty again instead of leaving a tombstone. This used to be khash, the licence above is
+ * for the macro interface and hash functions, which are still its.
+ *
+ * Options provided by defines before including:
+ *   HASH_H_NO_SIMD:
+ *     Checks control bytes one at a time instead of with SSE2.
+ *   kmalloc / kfree:
+ *     Names for user-provided malloc(size_t) and free(void*) functions.
+ *
+ * Example:
+ *     ht(ages, char*, int) ages = {0};
+ *     ht_impl_str(ages, int);
+ *     *hput(ages, ages, "bob") = 5;
+ *     int* age = hget(ages, ages, "bob");
+ *     for(ht_int_t i = 0; i < ages.n_buckets; i ++)
+ *       if(hexist(ages, i)) printf("%s: %d\n", hkey(ages, i), hval(ages, i));
+ *     hdel(ages, ages, "bob");
+ *     hdestroy(ages, ages);
+ *
+ * Pointers from hput and hget are good until the next hput, which can move everything. Deleting with ages_del(&ages, i)
+ * while looping over the slots is fine, nothing moves.
  */
 
-#define AC_VERSION_KHASH_H "0.2.8"
+#ifndef HASH_H
+#define HASH_H
 
 #include <stdlib.h>
 #include <string.h>
-#include <limits.h>
+#include <stdint.h>
 
-/* compiler specific configuration */
-
-#if UINT_MAX == 0xffffffffu
-typedef unsigned int ht_int32_t;
-#elif ULONG_MAX == 0xffffffffu
-typedef unsigned long ht_int32_t;
-#endif
-
-#if ULONG_MAX == ULLONG_MAX
-typedef unsigned long khint64_t;
-#else
-typedef unsigned long long khint64_t;
+#if !defined(HASH_H_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define HASH_H_SSE2
+	#include <emmintrin.h>
 #endif
 
 #ifndef ht_inline
@@ -91,193 +80,183 @@ typedef unsigned long long khint64_t;
 #endif
 #endif /* klib_unused */
 
+typedef uint32_t ht_int32_t;
+typedef uint64_t ht_int64_t;
 typedef ht_int32_t ht_int_t;
 typedef ht_int_t ht_iter_t;
 
-#define __ac_isempty(flag, i) ((flag[i >> 4] >> ((i & 0xfU) << 1)) & 2)
-#define __ac_isdel(flag, i) ((flag[i >> 4] >> ((i & 0xfU) << 1)) & 1)
-#define __ac_iseither(flag, i) ((flag[i >> 4] >> ((i & 0xfU) << 1)) & 3)
-#define __ac_set_isdel_false(flag, i) (flag[i >> 4] &= ~(1ul << ((i & 0xfU) << 1)))
-#define __ac_set_isempty_false(flag, i) (flag[i >> 4] &= ~(2ul << ((i & 0xfU) << 1)))
-#define __ac_set_isboth_false(flag, i) (flag[i >> 4] &= ~(3ul << ((i & 0xfU) << 1)))
-#define __ac_set_isdel_true(flag, i) (flag[i >> 4] |= 1ul << ((i & 0xfU) << 1))
-
-#define __ac_fsize(m) ((m) < 16? 1 : (m) >> 4)
-
-#ifndef kroundup32
-#define kroundup32(x) (--(x), (x)|=(x)>>1, (x)|=(x)>>2, (x)|=(x)>>4, (x)|=(x)>>8, (x)|=(x)>>16, ++(x))
-#endif
-
-#ifndef kcalloc
-#define kcalloc(N,Z) calloc(N,Z)
-#endif
 #ifndef kmalloc
 #define kmalloc(Z) malloc(Z)
 #endif
-#ifndef krealloc
-#define krealloc(P,Z) realloc(P,Z)
-#endif
 #ifndef kfree
 #define kfree(P) free(P)
 #endif
 
-#define ht(__name, ht_key_t, ht_val_t)                                                                                                \
-  struct ht_##__name##_t {                                                                                                           \
-    ht_int_t n_buckets, size, n_occupied, upper_bound, last_inserted;                                                                \
-    ht_int32_t *flags;                                                                                                               \
-    ht_key_t *keys;                                                                                                                  \
-    ht_val_t *vals;                                                                                                                  \
-  }
+#define HT_GROUP 16                 // Slots probed at once, the table's capacity is always a multiple of it
+#define HT_EMPTY ((int8_t) -128)
+#define HT_DELETED ((int8_t) -2)
+#define HT_MAX_LOAD(cap) ((cap) - (cap) / 8) // Full and deleted slots allowed before the table grows or gets rehashed
+
+// Slots in the group whose control byte is b, as a bitmask
+static ht_inline uint32_t ht_group_match_(const int8_t* g, int8_t b) {
+#ifdef HASH_H_SSE2
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(b), _mm_loadu_si128((const __m128i*) g)));
+#else
+  uint32_t m = 0;
+  for (int i = 0; i < HT_GROUP; ++i) m |= (uint32_t) (g[i] == b) << i;
+  return m;
+#endif
+}
+
+// Slots in the group that are empty or deleted, the two control bytes with the top bit set
+static ht_inline uint32_t ht_group_free_(const int8_t* g) {
+#ifdef HASH_H_SSE2
+  return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) g));
+#else
+  uint32_t m = 0;
+  for (int i = 0; i < HT_GROUP; ++i) m |= (uint32_t) (g[i] < 0) << i;
+  return m;
+#endif
+}
 
-#define __KHASH_PROTOTYPES(__name, ht_key_t, ht_val_t)                                                                                \
-  extern void __name##_destroy(struct ht_##__name##_t *h);                                                                                 \
-  extern void __name##_clear(struct ht_##__name##_t *h);                                                                                   \
-  extern ht_int_t __name##_get(const struct ht_##__name##_t *h, ht_key_t key);                                                               \
-  extern int __name##_resize(struct ht_##__name##_t *h, ht_int_t new_n_buckets);                                                            \
-  extern ht_int_t __name##_put(struct ht_##__name##_t *h, ht_key_t key, int *ret);                                                           \
-  extern void __name##_del(struct ht_##__name##_t *h, ht_int_t x);
+static ht_inline uint32_t ht_ctz_(uint32_t m) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long i;
+  _BitScanForward(&i, m);
+  return i;
+#else
+  return __builtin_ctz(m);
+#endif
+}
 
-#define __KHASH_IMPL(__name, SCOPE, ht_key_t, ht_val_t, __hash_func, __hash_equal)                                                    \
-  SCOPE void __name##_destroy(struct ht_##__name##_t *h)                                                                                   \
-  {                                                                                                                                 \
-    if (h) {                                                                                                                        \
-      kfree((void *)h->keys); kfree(h->flags);                                                                                      \
-      kfree((void *)h->vals);                                                                                                       \
-    }                                                                                                                               \
-  }                                                                                                                                 \
-  SCOPE void __name##_clear(struct ht_##__name##_t *h)                                                                                     \
-  {                                                                                                                                 \
-    if (h && h->flags) {                                                                                                            \
-      memset(h->flags, 0xaa, __ac_fsize(h->n_buckets) * sizeof(ht_int32_t));                                                         \
-      h->size = h->n_occupied = 0;                                                                                                  \
-    }                                                                                                                               \
-  }                                                                                                                                 \
-  SCOPE ht_val_t* __name##_get(const struct ht_##__name##_t *h, ht_key_t key)                                                                 \
-  {                                                                                                                                 \
-    if (h->n_buckets) {                                                                                                             \
-      ht_int_t k, i, last, mask, step = 0;                                                                                           \
-      mask = h->n_buckets - 1;                                                                                                      \
-      k = __hash_func(key); i = k & mask;                                                                                           \
-      last = i;                                                                                                                     \
-      while (!__ac_isempty(h->flags, i) && (__ac_isdel(h->flags, i) || !__hash_equal(h->keys[i], key))) {                           \
-        i = (i + (++step)) & mask;                                                                                                  \
-        if (i == last) return NULL;                                                                                         \
-      }                                                                                                                             \
-      return __ac_iseither(h->flags, i) ? NULL : h->vals + i;                                                                          \
-    } else return 0;                                                                                                                \
-  }                                                                                                                                 \
-  SCOPE int __name##_resize(struct ht_##__name##_t *h, ht_int_t new_n_buckets)                                                               \
-  { /* This function uses 0.25*n_buckets bytes of working space instead of [sizeof(key_t+val_t)+.25]*n_buckets. */                  \
-    ht_int32_t *new_flags = 0;                                                                                                       \
-    ht_int_t j = 1;                                                                                                                  \
-    {                                                                                                                               \
-      kroundup32(new_n_buckets);                                                                                                    \
-      if (new_n_buckets < 4) new_n_buckets = 4;                                                                                     \
-      if (h->size >= (new_n_buckets>>1) + (new_n_buckets>>2)) j = 0;  /* requested size is too small */                             \
-      else { /* hash table size to be changed (shrink or expand); rehash */                                                         \
-        new_flags = (ht_int32_t*)kmalloc(__ac_fsize(new_n_buckets) * sizeof(ht_int32_t));                                             \
-        if (!new_flags) return -1;                                                                                                  \
-        memset(new_flags, 0xaa, __ac_fsize(new_n_buckets) * sizeof(ht_int32_t));                                                     \
-        if (h->n_buckets < new_n_buckets) {  /* expand */                                                                           \
-          ht_key_t *new_keys = (ht_key_t*)krealloc((void *)h->keys, new_n_buckets * sizeof(ht_key_t));                                 \
-          if (!new_keys) { kfree(new_flags); return -1; }                                                                           \
-          h->keys = new_keys;                                                                                                       \
-                                                                                                                                    \
-          ht_val_t *new_vals = (ht_val_t*)krealloc((void *)h->vals, new_n_buckets * sizeof(ht_val_t));                                 \
-          if (!new_vals) { kfree(new_flags); return -1; }                                                                           \
-          h->vals = new_vals;                                                                                                       \
-        } /* otherwise shrink */                                                                                                    \
-      }                                                                                                                             \
-    }                                                                                                                               \
-    if (j) { /* rehashing is needed */                                                                                              \
-      for (j = 0; j != h->n_buckets; ++j) {                                                                                         \
-        if (__ac_iseither(h->flags, j) == 0) {                                                                                      \
-          ht_key_t key = h->keys[j];                                                                                                 \
-          ht_val_t val;                                                                                                              \
-          ht_int_t new_mask;                                                                                                         \
-          new_mask = new_n_buckets - 1;                                                                                             \
-          val = h->vals[j];                                                                                                         \
-          __ac_set_isdel_true(h->flags, j);                                                                                         \
-          while (1) { /* kick-out process; sort of like in Cuckoo hashing */                                                        \
-            ht_int_t k, i, step = 0;                                                                                                 \
-            k = __hash_func(key);                                                                                                   \
-            i = k & new_mask;                                                                                                       \
-            while (!__ac_isempty(new_flags, i)) i = (i + (++step)) & new_mask;                                                      \
-            __ac_set_isempty_false(new_flags, i);                                                                                   \
-            if (i < h->n_buckets && __ac_iseither(h->flags, i) == 0) { /* kick out the existing element */                          \
-              { ht_key_t tmp = h->keys[i]; h->keys[i] = key; key = tmp; }                                                            \
-              ht_val_t tmp = h->vals[i];                                                                                             \
-              h->vals[i] = val;                                                                                                     \
-              val = tmp;                                                                                                            \
-              __ac_set_isdel_true(h->flags, i); /* mark it as deleted in the old hash table */                                      \
-            } else { /* write the element and jump out of the loop */                                                               \
-              h->keys[i] = key;                                                                                                     \
-              h->vals[i] = val;                                                                                                     \
-              break;                                                                                                                \
-            }                                                                                                                       \
-          }                                                                                                                         \
-        }                                                                                                                           \
-      }                                                                                                                             \
-      if (h->n_buckets > new_n_buckets) { /* shrink the hash table */                                                               \
-        h->keys = (ht_key_t*)krealloc((void *)h->keys, new_n_buckets * sizeof(ht_key_t));                                             \
-        h->vals = (ht_val_t*)krealloc((void *)h->vals, new_n_buckets * sizeof(ht_val_t));                                             \
-      }                                                                                                                             \
-      kfree(h->flags); /* free the working space */                                                                                 \
-      h->flags = new_flags;                                                                                                         \
-      h->n_buckets = new_n_buckets;                                                                                                 \
-      h->n_occupied = h->size;                                                                                                      \
-      h->upper_bound = (new_n_buckets>>1) + (new_n_buckets>>2);                                                                     \
-    }                                                                                                                               \
-    return 0;                                                                                                                       \
-  }                                                                                                                                 \
-  SCOPE ht_val_t* __name##_put(struct ht_##__name##_t *h, ht_key_t key)                                                              \
-  {                                                                                                                                 \
-    ht_int_t x;                                                                                                                      \
-    if (h->n_occupied >= h->upper_bound) /* update the hash table */                                                                \
-      __name##_resize(h, h->n_buckets + (h->n_buckets > (h->size << 1) ? -1 : 1));                                                 \
-                                                                                                                                    \
-    ht_int_t k, i, site, last, mask = h->n_buckets - 1, step = 0;                                                                    \
-    x = site = h->n_buckets; k = __hash_func(key); i = k & mask;                                                                    \
-    if (__ac_isempty(h->flags, i)) x = i; /* for speed up */                                                                        \
-    else {                                                                                                                          \
-      last = i;                                                                                                                     \
-      while (!__ac_isempty(h->flags, i) && (__ac_isdel(h->flags, i) || !__hash_equal(h->keys[i], key))) {                           \
-        if (__ac_isdel(h->flags, i)) site = i;                                                                                      \
-        i = (i + (++step)) & mask;                                                                                                  \
-        if (i == last) { x = site; break; }                                                                                         \
-      }                                                                                                                             \
-      if (x == h->n_buckets) {                                                                                                      \
-        if (__ac_isempty(h->flags, i) && site != h->n_buckets) x = site;                                                            \
-        else x = i;                                                                                                                 \
-      }                                                                                                                             \
-    }                                                                                                                               \
-    if (__ac_isempty(h->flags, x)) { /* not present at all */                                                                       \
-      h->keys[x] = key;                                                                                                             \
-      __ac_set_isboth_false(h->flags, x);                                                                                           \
-      ++h->size; ++h->n_occupied;                                                                                                   \
-    } else if (__ac_isdel(h->flags, x)) { /* deleted */                                                                             \
-      h->keys[x] = key;                                                                                                             \
-      __ac_set_isboth_false(h->flags, x);                                                                                           \
-      ++h->size;                                                                                                                    \
-    }                                                                                                                               \
-    return h->vals + x;                                                                                                                       \
-  }                                                                                                                                 \
-  SCOPE void __name##_del(struct ht_##__name##_t *h, ht_int_t x)                                                                             \
-  {                                                                                                                                 \
-    if (x != h->n_buckets && !__ac_iseither(h->flags, x)) {                                                                         \
-      __ac_set_isdel_true(h->flags, x);                                                                                             \
-      --h->size;                                                                                                                    \
-    }                                                                                                                               \
+// Spreads the key's hash over 64 bits, since the hash functions below are mostly weak ones like the identity. The
+// top 7 bits go in the control byte and the 32 under them pick the group the probe starts at.
+#define ht_mix_(hash) ((uint64_t) (hash) * 0x9E3779B97F4A7C15ull)
+#define ht_h2_(mixed) ((int8_t) ((mixed) >> 57))
+#define ht_h1_(mixed) ((ht_int_t) ((mixed) >> 25))
+
+// First empty or deleted slot along the probe sequence for a hash. Groups are probed in triangular steps, which
+// visit every group once when the group count is a power of 2. The table is never completely full.
+static ht_inline ht_int_t ht_find_free_(const int8_t* ctrl, ht_int_t n_buckets, uint64_t mixed) {
+  ht_int_t mask = n_buckets / HT_GROUP - 1, g = ht_h1_(mixed) & mask;
+  for (ht_int_t step = 1;; ++step) {
+    uint32_t avail = ht_group_free_(ctrl + g * HT_GROUP);
+    if (avail) return g * HT_GROUP + ht_ctz_(avail);
+    g = (g + step) & mask;
   }
+}
 
-#define KHASH_DECLARE(__name, ht_key_t, ht_val_t)                                                                                       \
-  __KHASH_PROTOTYPES(__name, ht_key_t, ht_val_t)
+#define ht(__name, ht_key_t, ht_val_t)                                                                                  \
+  struct ht_##__name##_t {                                                                                              \
+    ht_int_t n_buckets, size;                                                                                           \
+    ht_int_t growth_left; /* Empty slots that can still be filled before the table has to grow */                       \
+    int8_t *ctrl;                                                                                                       \
+    ht_key_t *keys;                                                                                                     \
+    ht_val_t *vals;                                                                                                     \
+  }
 
-#define KHASH_INIT2(__name, SCOPE, ht_key_t, ht_val_t, __hash_func, __hash_equal)                                            \
-  __KHASH_IMPL(__name, SCOPE, ht_key_t, ht_val_t, __hash_func, __hash_equal)
+#define __HASH_IMPL(__name, SCOPE, ht_key_t, ht_val_t, __hash_func, __hash_equal)                                       \
+  SCOPE void __name##_destroy(struct ht_##__name##_t *h)                                                                \
+  {                                                                                                                     \
+    if (h) kfree(h->ctrl);                                                                                              \
+  }                                                                                                                     \
+  SCOPE void __name##_clear(struct ht_##__name##_t *h)                                                                  \
+  {                                                                                                                     \
+    if (h && h->ctrl) {                                                                                                 \
+      memset(h->ctrl, HT_EMPTY, h->n_buckets);                                                                          \
+      h->size = 0;                                                                                                      \
+      h->growth_left = HT_MAX_LOAD(h->n_buckets);                                                                       \
+    }                                                                                                                   \
+  }                                                                                                                     \
+  /* Slot the key is in, or n_buckets when it isn't there */                                                            \
+  SCOPE ht_int_t __name##_find(const struct ht_##__name##_t *h, ht_key_t key, uint64_t mixed)                           \
+  {                                                                                                                     \
+    if (!h->n_buckets) return 0;                                                                                        \
+    int8_t h2 = ht_h2_(mixed);                                                                                          \
+    ht_int_t mask = h->n_buckets / HT_GROUP - 1, g = ht_h1_(mixed) & mask;                                              \
+    for (ht_int_t step = 1; step <= mask + 1; ++step) {                                                                 \
+      const int8_t *ctrl = h->ctrl + g * HT_GROUP;                                                                      \
+      for (uint32_t m = ht_group_match_(ctrl, h2); m; m &= m - 1) {                                                     \
+        ht_int_t i = g * HT_GROUP + ht_ctz_(m);                                                                         \
+        if (__hash_equal(h->keys[i], key)) return i;                                                                    \
+      }                                                                                                                 \
+      if (ht_group_match_(ctrl, HT_EMPTY)) break;                                                                       \
+      g = (g + step) & mask;                                                                                            \
+    }                                                                                                                   \
+    return h->n_buckets;                                                                                                \
+  }                                                                                                                     \
+  SCOPE ht_int_t __name##_index(const struct ht_##__name##_t *h, ht_key_t key)                                          \
+  {                                                                                                                     \
+    return __name##_find(h, key, ht_mix_(__hash_func(key)));                                                            \
+  }                                                                                                                     \
+  SCOPE ht_val_t* __name##_get(const struct ht_##__name##_t *h, ht_key_t key)                                           \
+  {                                                                                                                     \
+    ht_int_t i = __name##_index(h, key);                                                                                \
+    return i < h->n_buckets ? h->vals + i : NULL;                                                                       \
+  }                                                                                                                     \
+  /* Rehashes into room for at least new_n_buckets slots, also clearing out deleted ones */                             \
+  SCOPE int __name##_resize(struct ht_##__name##_t *h, ht_int_t new_n_buckets)                                          \
+  {                                                                                                                     \
+    ht_int_t cap = HT_GROUP;                                                                                            \
+    while (cap < new_n_buckets || HT_MAX_LOAD(cap) <= h->size) cap <<= 1;                                               \
+    size_t keys_at = cap, vals_at = keys_at + (((size_t) cap * sizeof(ht_key_t) + 15) & ~(size_t) 15);                  \
+    int8_t *ctrl = (int8_t*) kmalloc(vals_at + (size_t) cap * sizeof(ht_val_t));                                        \
+    if (!ctrl) return -1;                                                                                               \
+    memset(ctrl, HT_EMPTY, cap);                                                                                        \
+    ht_key_t *keys = (ht_key_t*) (ctrl + keys_at);                                                                      \
+    ht_val_t *vals = (ht_val_t*) (ctrl + vals_at);                                                                      \
+    for (ht_int_t j = 0; j < h->n_buckets; ++j) {                                                                       \
+      if (h->ctrl[j] < 0) continue;                                                                                     \
+      uint64_t mixed = ht_mix_(__hash_func(h->keys[j]));                                                                \
+      ht_int_t i = ht_find_free_(ctrl, cap, mixed);                                                                     \
+      ctrl[i] = ht_h2_(mixed);                                                                                          \
+      keys[i] = h->keys[j];                                                                                             \
+      vals[i] = h->vals[j];                                                                                             \
+    }                                                                                                                   \
+    kfree(h->ctrl);                                                                                                     \
+    h->ctrl = ctrl;                                                                                                     \
+    h->keys = keys;                                                                                                     \
+    h->vals = vals;                                                                                                     \
+    h->n_buckets = cap;                                                                                                 \
+    h->growth_left = HT_MAX_LOAD(cap) - h->size;                                                                        \
+    return 0;                                                                                                           \
+  }                                                                                                                     \
+  /* Value for the key, adding the key with the value left for the caller to set when it isn't there yet */            \
+  SCOPE ht_val_t* __name##_put(struct ht_##__name##_t *h, ht_key_t key)                                                 \
+  {                                                                                                                     \
+    uint64_t mixed = ht_mix_(__hash_func(key));                                                                         \
+    ht_int_t i = __name##_find(h, key, mixed);                                                                          \
+    if (i < h->n_buckets) return h->vals + i;                                                                           \
+    if (!h->growth_left) {                                                                                              \
+      /* Mostly deleted slots just get cleaned up, otherwise the table doubles */                                       \
+      ht_int_t cap = h->size * 2 < HT_MAX_LOAD(h->n_buckets) ? h->n_buckets : h->n_buckets * 2;                         \
+      if (__name##_resize(h, cap) < 0) return NULL;                                                                     \
+    }                                                                                                                   \
+    i = ht_find_free_(h->ctrl, h->n_buckets, mixed);                                                                    \
+    if (h->ctrl[i] == HT_EMPTY) --h->growth_left;                                                                       \
+    h->ctrl[i] = ht_h2_(mixed);                                                                                         \
+    h->keys[i] = key;                                                                                                   \
+    ++h->size;                                                                                                          \
+    return h->vals + i;                                                                                                 \
+  }                                                                                                                     \
+  /* Deletes the slot. If its group still has an empty slot, no probe ever went past the group, so the slot can be    \
+     empty again instead of a tombstone. */                                                                             \
+  SCOPE void __name##_del(struct ht_##__name##_t *h, ht_int_t x)                                                        \
+  {                                                                                                                     \
+    if (x >= h->n_buckets || h->ctrl[x] < 0) return;                                                                    \
+    if (ht_group_match_(h->ctrl + x / HT_GROUP * HT_GROUP, HT_EMPTY)) {                                                 \
+      h->ctrl[x] = HT_EMPTY;                                                                                            \
+      ++h->growth_left;                                                                                                 \
+    } else h->ctrl[x] = HT_DELETED;                                                                                     \
+    --h->size;                                                                                                          \
+  }                                                                                                                     \
+  SCOPE void __name##_remove(struct ht_##__name##_t *h, ht_key_t key)                                                   \
+  {                                                                                                                     \
+    __name##_del(h, __name##_index(h, key));                                                                            \
+  }
 
-#define ht_impl(__name, ht_key_t, ht_val_t, __hash_func, __hash_equal)                                                    \
-  KHASH_INIT2(__name, static ht_inline klib_unused, ht_key_t, ht_val_t, __hash_func, __hash_equal)
+#define ht_impl(__name, ht_key_t, ht_val_t, __hash_func, __hash_equal)                                                  \
+  __HASH_IMPL(__name, static ht_inline klib_unused, ht_key_t, ht_val_t, __hash_func, __hash_equal)
 
 /* --- BEGIN OF HASH FUNCTIONS --- */
 
@@ -285,19 +264,16 @@ typedef ht_int_t ht_iter_t;
 #define ht_int_hash_equal(a, b) ((a) == (b))
 #define ht_int64_hash_func(key) (ht_int32_t)((key)>>33^(key)^(key)<<11)
 #define ht_int64_hash_equal(a, b) ((a) == (b))
-static ht_inline ht_int_t __ac_X31_hash_string(const char *s)
+static ht_inline ht_int_t ht_X31_hash_string(const char *s)
 {
   ht_int_t h = (ht_int_t)*s;
   if (h) for (++s ; *s; ++s) h = (h << 5) - h + (ht_int_t)*s;
   return h;
 }
-#define ht_str_hash_func(key) __ac_X31_hash_string(key)
-/*! @function
-  @abstract     Const char* comparison function
- */
+#define ht_str_hash_func(key) ht_X31_hash_string(key)
 #define ht_str_hash_equal(a, b) (strcmp(a, b) == 0)
 
-static ht_inline ht_int_t __ac_Wang_hash(ht_int_t key)
+static ht_inline ht_int_t ht_Wang_hash(ht_int_t key)
 {
     key += ~(key << 15);
     key ^=  (key >> 10);
@@ -307,7 +283,7 @@ static ht_inline ht_int_t __ac_Wang_hash(ht_int_t key)
     key ^=  (key >> 16);
     return key;
 }
-#define ht_int_hash_func2(key) __ac_Wang_hash((ht_int_t)key)
+#define ht_int_hash_func2(key) ht_Wang_hash((ht_int_t)key)
 
 /* --- END OF HASH FUNCTIONS --- */
 
@@ -318,20 +294,20 @@ static ht_inline ht_int_t __ac_Wang_hash(ht_int_t key)
 #define hresize(__name, h, s) __name##_resize(&h, s)
 #define hput(__name, h, ...) __name##_put(&h, (typeof((h).keys[0])) __VA_ARGS__)
 #define hget(__name, h, ...) __name##_get(&h, (typeof((h).keys[0])) __VA_ARGS__)
-#define hdel(__name, h, ...) __name##_del(&h, (typeof((h).keys[0])) __VA_ARGS__)
-#define hexist(h, x) (!__ac_iseither((h).flags, (x)))
+#define hdel(__name, h, ...) __name##_remove(&h, (typeof((h).keys[0])) __VA_ARGS__)
+#define hexist(h, x) ((h).ctrl[x] >= 0)
 #define hkey(h, x) ((h).keys[x])
 #define hval(h, x) ((h).vals[x])
 
 /* More convenient interfaces */
 
-#define ht_impl_int(__name, ht_val_t)                                                                                           \
+#define ht_impl_int(__name, ht_val_t)                                                                                   \
   ht_impl(__name, ht_int32_t, ht_val_t, ht_int_hash_func, ht_int_hash_equal)
-#define ht_impl_int64(__name, ht_val_t)                                                                                         \
+#define ht_impl_int64(__name, ht_val_t)                                                                                 \
   ht_impl(__name, ht_int64_t, ht_val_t, ht_int64_hash_func, ht_int64_hash_equal)
 
-#define ht_impl_str(__name, ht_val_t)                                                                                           \
+#define ht_impl_str(__name, ht_val_t)                                                                                   \
   ht_impl(__name, char*, ht_val_t, ht_str_hash_func, ht_str_hash_equal)
 
 
-#endif /* __AC_KHASH_H */
+#endif /* HASH_H */
@@ -0,0 +1,326 @@
+/*
+ * raster.h v1.0.0 - Aqil Contractor @AqilC 2024
+ * Licenced under Attribution-NonCommercial-ShareAlike 3.0
+ *
+ * Antialiased outline rasterizer, the same way font-rs does it (https://github.com/raphlinus/font-rs): curves get
+ * flattened into lines, every line adds its signed area to an accumulation buffer, and one prefix sum over the buffer
+ * turns it into coverage. The prefix sum is done 4 pixels at a time with SSE2 when it's available.
+ * Compile by adding a file called `raster.c` with the following contents in your project:
+ *     #define RASTER_H_IMPLEMENTATION
+ *     #include <raster.h>
+ *
+ * Options provided by defines before including:
+ *   RASTER_H_STATIC_INLINE:
+ *     Implements all methods as static inline. Automatically defines RASTER_H_IMPLEMENTATION.
+ *   RASTER_H_NO_SIMD:
+ *     Always uses the scalar prefix sum.
+ *   RASTER_H_REALLOC / RASTER_H_FREE:
+ *     Names for user-provided realloc(void*, size_t) and free(void*) functions.
+ *
+ * Outlines can come from anywhere through raster_line/raster_quad/raster_cubic, in pixels with y going down. Include
+ * FreeType or stb_truetype before this file to get raster_ft_outline or raster_stbtt_glyph, which size the canvas to the
+ * glyph and draw its outline in one go.
+ *
+ * A canvas isn't thread safe, give every thread its own.
+ */
+
+#ifndef RASTER_H
+#define RASTER_H
+
+#ifdef RASTER_H_STATIC_INLINE
+	#define RASTER_H_IMPLEMENTATION
+	#define RASTER_H_EXTERN static inline
+#else
+	#define RASTER_H_EXTERN
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct raster_canvas {
+	float* acc;      // Signed area per pixel, with a few cells of padding at the end
+	uint8_t* pixels; // Coverage from the last raster_end, w * h
+	uint32_t w, h;
+	uint32_t cap;    // Cells acc and pixels have room for
+	int left, top;   // Where the canvas is relative to the glyph origin, set by the FreeType and stb_truetype helpers
+} raster_canvas;
+
+// Clears the canvas and resizes it to w * h, keeping its memory around if it's big enough already.
+RASTER_H_EXTERN bool raster_begin(raster_canvas* c, uint32_t w, uint32_t h);
+RASTER_H_EXTERN void raster_line(raster_canvas* c, float x0, float y0, float x1, float y1);
+RASTER_H_EXTERN void raster_quad(raster_canvas* c, float x0, float y0, float x1, float y1, float x2, float y2);
+RASTER_H_EXTERN void raster_cubic(raster_canvas* c, float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3);
+// Turns everything drawn since raster_begin into 8 bit coverage, using the nonzero rule. The pixels belong to the canvas.
+RASTER_H_EXTERN uint8_t* raster_end(raster_canvas* c);
+RASTER_H_EXTERN void raster_free(raster_canvas* c);
+
+#ifdef FT_FREETYPE_H
+// Sizes the canvas to the outline's pixel bounds, the same ones FT_Render_Glyph would use, and draws it.
+RASTER_H_EXTERN bool raster_ft_outline(raster_canvas* c, const FT_Outline* outline);
+#endif
+#ifdef __STB_INCLUDE_STB_TRUETYPE_H__
+// Sizes the canvas to the glyph's bitmap box at the scale and draws it. The canvas' top is negated like stbtt's y offsets.
+RASTER_H_EXTERN bool raster_stbtt_glyph(raster_canvas* c, const stbtt_fontinfo* info, int glyph, float scale);
+#endif
+
+#ifdef RASTER_H_IMPLEMENTATION
+
+#include <string.h>
+#include <math.h>
+
+#ifndef RASTER_H_REALLOC
+	#include <stdlib.h>
+	#define RASTER_H_REALLOC realloc
+	#define RASTER_H_FREE free
+#endif
+
+#if !defined(RASTER_H_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define RASTER_H_SSE2
+	#include <emmintrin.h>
+#endif
+
+// Curves are split into segments until they're within about 1/3 of a pixel of the real curve
+#define RASTER_H_TOLERANCE 3.0f
+
+RASTER_H_EXTERN bool raster_begin(raster_canvas* c, uint32_t w, uint32_t h) {
+	// Cells get processed 4 at a time, and lines ending on the right edge write one past the last pixel
+	uint32_t cells = ((w * h + 3) & ~3u) + 4;
+	if(cells > c->cap) {
+		float* acc = RASTER_H_REALLOC(c->acc, cells * sizeof(float));
+		if(!acc) return false;
+		c->acc = acc;
+		uint8_t* pixels = RASTER_H_REALLOC(c->pixels, cells);
+		if(!pixels) return false;
+		c->pixels = pixels;
+		c->cap = cells;
+	}
+	c->w = w, c->h = h;
+	memset(c->acc, 0, cells * sizeof(float));
+	return true;
+}
+
+RASTER_H_EXTERN void raster_line(raster_canvas* c, float x0, float y0, float x1, float y1) {
+	if(y0 == y1) return;
+	float dir = 1.0f;
+	if(y0 > y1) {
+		float t;
+		t = x0, x0 = x1, x1 = t;
+		t = y0, y0 = y1, y1 = t;
+		dir = -1.0f;
+	}
+
+	// Points outside the canvas would write outside the buffer, so x gets clamped and y gets cut off
+	float w = c->w;
+	x0 = x0 < 0 ? 0 : x0 > w ? w : x0;
+	x1 = x1 < 0 ? 0 : x1 > w ? w : x1;
+	float dxdy = (x1 - x0) / (y1 - y0);
+	float x = x0;
+	if(y0 < 0) x -= y0 * dxdy;
+	int ystart = y0 < 0 ? 0 : (int) y0;
+	int yend = (int) ceilf(y1);
+	if(yend > (int) c->h) yend = c->h;
+
+	for(int y = ystart; y < yend; y ++) {
+		float* row = c->acc + y * c->w;
+		float dy = (y + 1 < y1 ? y + 1 : y1) - (y > y0 ? y : y0);
+		float xnext = x + dxdy * dy;
+		float d = dy * dir;
+		float xl = x < xnext ? x : xnext, xr = x < xnext ? xnext : x;
+		float xlfloor = floorf(xl);
+		int xli = xlfloor;
+		int xri = ceilf(xr);
+
+		// Within one pixel, the area splits between it and the one after by where the line crosses on average
+		if(xri <= xli + 1) {
+			float xmf = 0.5f * (x + xnext) - xlfloor;
+			row[xli] += d - d * xmf;
+			row[xli + 1] += d * xmf;
+		}
+		else {
+			float s = 1.0f / (xr - xl);
+			float xlf = xl - xlfloor;
+			float a0 = 0.5f * s * (1.0f - xlf) * (1.0f - xlf);
+			float xrf = xr - xri + 1.0f;
+			float am = 0.5f * s * xrf * xrf;
+			row[xli] += d * a0;
+			if(xri == xli + 2) row[xli + 1] += d * (1.0f - a0 - am);
+			else {
+				float a1 = s * (1.5f - xlf);
+				row[xli + 1] += d * (a1 - a0);
+				for(int xi = xli + 2; xi < xri - 1; xi ++) row[xi] += d * s;
+				float a2 = a1 + (xri - xli - 3) * s;
+				row[xri - 1] += d * (1.0f - a2 - am);
+			}
+			row[xri] += d * am;
+		}
+		x = xnext;
+	}
+}
+
+RASTER_H_EXTERN void raster_quad(raster_canvas* c, float x0, float y0, float x1, float y1, float x2, float y2) {
+	float ddx = x0 - 2.0f * x1 + x2, ddy = y0 - 2.0f * y1 + y2;
+	int n = 1 + (int) sqrtf(sqrtf(RASTER_H_TOLERANCE * (ddx * ddx + ddy * ddy)));
+	float px = x0, py = y0, step = 1.0f / n;
+	for(int i = 1; i < n; i ++) {
+		float t = i * step, mt = 1.0f - t;
+		float nx = mt * mt * x0 + 2.0f * mt * t * x1 + t * t * x2;
+		float ny = mt * mt * y0 + 2.0f * mt * t * y1 + t * t * y2;
+		raster_line(c, px, py, nx, ny);
+		px = nx, py = ny;
+	}
+	raster_line(c, px, py, x2, y2);
+}
+
+RASTER_H_EXTERN void raster_cubic(raster_canvas* c, float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3) {
+	// The bigger of the two second differences bounds how far the curve strays from its chords
+	float ax = x0 - 2.0f * x1 + x2, ay = y0 - 2.0f * y1 + y2;
+	float bx = x1 - 2.0f * x2 + x3, by = y1 - 2.0f * y2 + y3;
+	float dd = ax * ax + ay * ay > bx * bx + by * by ? ax * ax + ay * ay : bx * bx + by * by;
+	int n = 1 + (int) sqrtf(sqrtf(RASTER_H_TOLERANCE * 2.25f * dd));
+	float px = x0, py = y0, step = 1.0f / n;
+	for(int i = 1; i < n; i ++) {
+		float t = i * step, mt = 1.0f - t;
+		float a = mt * mt * mt, b = 3.0f * mt * mt * t, cc = 3.0f * mt * t * t, d = t * t * t;
+		float nx = a * x0 + b * x1 + cc * x2 + d * x3;
+		float ny = a * y0 + b * y1 + cc * y2 + d * y3;
+		raster_line(c, px, py, nx, ny);
+		px = nx, py = ny;
+	}
+	raster_line(c, px, py, x3, y3);
+}
+
+RASTER_H_EXTERN uint8_t* raster_end(raster_canvas* c) {
+	uint32_t n = c->w * c->h, i = 0;
+	const float* a = c->acc;
+	uint8_t* out = c->pixels;
+
+#ifdef RASTER_H_SSE2
+	// Prefix sum of 4 cells in two shifted adds, then the running total from the last group gets added on
+	__m128 offset = _mm_setzero_ps();
+	const __m128 sign = _mm_set1_ps(-0.0f), one = _mm_set1_ps(1.0f), scale = _mm_set1_ps(255.0f);
+	for(; i + 4 <= n; i += 4) {
+		__m128 x = _mm_loadu_ps(a + i);
+		x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)));
+		x = _mm_add_ps(x, _mm_shuffle_ps(_mm_setzero_ps(), x, 0x40));
+		x = _mm_add_ps(x, offset);
+		__m128 y = _mm_mul_ps(_mm_min_ps(_mm_andnot_ps(sign, x), one), scale);
+		__m128i z = _mm_cvtps_epi32(y);
+		z = _mm_packs_epi32(z, z);
+		z = _mm_packus_epi16(z, z);
+		int32_t px = _mm_cvtsi128_si32(z);
+		memcpy(out + i, &px, 4);
+		offset = _mm_shuffle_ps(x, x, 0xFF);
+	}
+	float sum = _mm_cvtss_f32(offset);
+#else
+	float sum = 0;
+#endif
+
+	for(; i < n; i ++) {
+		sum += a[i];
+		float y = fabsf(sum);
+		out[i] = (y < 1.0f ? y : 1.0f) * 255.0f + 0.5f;
+	}
+	return out;
+}
+
+RASTER_H_EXTERN void raster_free(raster_canvas* c) {
+	RASTER_H_FREE(c->acc);
+	RASTER_H_FREE(c->pixels);
+	*c = (raster_canvas) { 0 };
+}
+
+#ifdef FT_FREETYPE_H
+#include FT_OUTLINE_H
+
+// Decomposition state, points come in as 26.6 relative to the glyph origin with y going up
+struct raster_ft_pen {
+	raster_canvas* c;
+	float x, y;
+};
+#define RASTER_FT_X(p, v) ((v)->x * (1.0f / 64.0f) - (p)->c->left)
+#define RASTER_FT_Y(p, v) ((p)->c->top - (v)->y * (1.0f / 64.0f))
+
+static int raster_ft_move(const FT_Vector* to, void* user) {
+	struct raster_ft_pen* p = user;
+	p->x = RASTER_FT_X(p, to), p->y = RASTER_FT_Y(p, to);
+	return 0;
+}
+static int raster_ft_line(const FT_Vector* to, void* user) {
+	struct raster_ft_pen* p = user;
+	float x = RASTER_FT_X(p, to), y = RASTER_FT_Y(p, to);
+	raster_line(p->c, p->x, p->y, x, y);
+	p->x = x, p->y = y;
+	return 0;
+}
+static int raster_ft_conic(const FT_Vector* control, const FT_Vector* to, void* user) {
+	struct raster_ft_pen* p = user;
+	float x = RASTER_FT_X(p, to), y = RASTER_FT_Y(p, to);
+	raster_quad(p->c, p->x, p->y, RASTER_FT_X(p, control), RASTER_FT_Y(p, control), x, y);
+	p->x = x, p->y = y;
+	return 0;
+}
+static int raster_ft_cubic(const FT_Vector* c1, const FT_Vector* c2, const FT_Vector* to, void* user) {
+	struct raster_ft_pen* p = user;
+	float x = RASTER_FT_X(p, to), y = RASTER_FT_Y(p, to);
+	raster_cubic(p->c, p->x, p->y, RASTER_FT_X(p, c1), RASTER_FT_Y(p, c1), RASTER_FT_X(p, c2), RASTER_FT_Y(p, c2), x, y);
+	p->x = x, p->y = y;
+	return 0;
+}
+
+RASTER_H_EXTERN bool raster_ft_outline(raster_canvas* c, const FT_Outline* outline) {
+	static const FT_Outline_Funcs funcs = {
+		.move_to = raster_ft_move, .line_to = raster_ft_line,
+		.conic_to = raster_ft_conic, .cubic_to = raster_ft_cubic
+	};
+
+	FT_BBox box;
+	FT_Outline_Get_CBox(outline, &box);
+	int left = box.xMin >> 6, right = (box.xMax + 63) >> 6;
+	int bottom = box.yMin >> 6, top = (box.yMax + 63) >> 6;
+	c->left = left, c->top = top;
+	if(!raster_begin(c, right - left, top - bottom)) return false;
+	if(!outline->n_points) return true;
+
+	struct raster_ft_pen pen = { .c = c, .x = 0, .y = 0 };
+	return !FT_Outline_Decompose((FT_Outline*) outline, &funcs, &pen);
+}
+#endif
+
+#ifdef __STB_INCLUDE_STB_TRUETYPE_H__
+RASTER_H_EXTERN bool raster_stbtt_glyph(raster_canvas* c, const stbtt_fontinfo* info, int glyph, float scale) {
+	int x0, y0, x1, y1;
+	stbtt_GetGlyphBitmapBox(info, glyph, scale, scale, &x0, &y0, &x1, &y1);
+	c->left = x0, c->top = -y0;
+	if(!raster_begin(c, x1 - x0, y1 - y0)) return false;
+
+	stbtt_vertex* v;
+	int n = stbtt_GetGlyphShape(info, glyph, &v);
+	float px = 0, py = 0, sx = 0, sy = 0;
+	#define RASTER_STBTT_X(x) ((x) * scale - x0)
+	#define RASTER_STBTT_Y(y) (-(y) * scale - y0)
+	for(int i = 0; i < n; i ++) {
+		float x = RASTER_STBTT_X(v[i].x), y = RASTER_STBTT_Y(v[i].y);
+		switch(v[i].type) {
+			case STBTT_vmove:
+				raster_line(c, px, py, sx, sy); // Closes the last contour, if it wasn't already
+				sx = x, sy = y;
+				break;
+			case STBTT_vline: raster_line(c, px, py, x, y); break;
+			case STBTT_vcurve: raster_quad(c, px, py, RASTER_STBTT_X(v[i].cx), RASTER_STBTT_Y(v[i].cy), x, y); break;
+			case STBTT_vcubic:
+				raster_cubic(c, px, py, RASTER_STBTT_X(v[i].cx), RASTER_STBTT_Y(v[i].cy), RASTER_STBTT_X(v[i].cx1), RASTER_STBTT_Y(v[i].cy1), x, y);
+				break;
+		}
+		px = x, py = y;
+	}
+	raster_line(c, px, py, sx, sy);
+	#undef RASTER_STBTT_X
+	#undef RASTER_STBTT_Y
+	stbtt_FreeShape(info, v);
+	return true;
+}
+#endif
+
+#endif // RASTER_H_IMPLEMENTATION
+#endif // RASTER_H
@@ -1,5 +1,5 @@
 /*
- * vec.h v1.0.0 - Aqil Contractor @AqilC 2023
+ * vec.h v1.1.0 - Aqil Contractor @AqilC 2023
  * Licenced under Attribution-NonCommercial-ShareAlike 3.0
  *
  * This file includes all of the source for the Vector library macros and functions.
@@ -20,8 +20,10 @@
  *     Name for user-provided free(void*) function.
  *   VEC_H_OVERLOAD_ALLOCATORS:
  *     Define `void* vnew()` as you see fit, but after initial allocation, cast to struct vecdata_* and add 1 to pointer as done in current implementation.
- *     Define re-allocator function with the function signature: struct vecdata_* name(struct vecdata_* data, uint32_t size);
+ *     Define re-allocator function with the function signature: struct vecdata_* name(struct vecdata_* data, uint64_t size);
  *     Make sure to define VEC_H_REALLOC_FUNC with `name` after redefining.
+ *   VEC_H_GROW(used):
+ *     Capacity in bytes a vector grows to once it needs `used` bytes. Defaults to 1.25x plus 16 bytes.
  *     
  * WARNING: CURRENTLY NOT FULLY THREAD SAFE. Use with caution when using in thread safe code!
  */
@@ -42,20 +44,32 @@
 #include <stdint.h>
 #include <string.h>
 
+// Sizes are in bytes, 64 bit so big vertex streams don't wrap around
 struct vecdata_ {
-	uint32_t used;
-	uint32_t cap;
+	uint64_t used;
+	uint64_t cap;
 	uint8_t data[];
 };
 #define _DATA(x) ((struct vecdata_*)(x) - 1)
 #define vlen(x) (_DATA(x)->used / sizeof(*(x)))
 #define vcap(x) (_DATA(x)->cap / sizeof(*(x)))
 
+#ifndef VEC_H_GROW
+	#define VEC_H_GROW(used) ((used) + ((used) >> 2) + 16)
+#endif
+
 // The normal push macro, pushes a value onto the obj
-#define vpush(x, ...) (*((typeof(x)) vpush_((void**)&(x), sizeof(*(x)))) = (typeof(*x)) __VA_ARGS__)
-// vpush(data, 5); expands to something like: *(int*)vpush_((void**) &data, 4) = (int) 5;
+#define vpush(x, ...) (*((typeof(x)) vpush_inline_((void**)&(x), sizeof(*(x)))) = (typeof(*x)) __VA_ARGS__)
+// vpush(data, 5); expands to something like: *(int*)vpush_inline_((void**) &data, 4) = (int) 5;
+
+// Pushes n elements without setting them, and returns a pointer to the first one to write them to
+#define vpush_uninit(x, n) ((typeof(x)) vpush_inline_((void**)&(x), (n) * sizeof(*(x))))
 
-#define vpusharr(x, ...) (memcpy(vpush_((void**)&(x), sizeof((typeof(*(x))[]) __VA_ARGS__)), (typeof(*(x))[]) __VA_ARGS__, sizeof((typeof(*(x))[]) __VA_ARGS__)))
+// Pushes a whole array literal. The element count is the literal's, so vpusharr(idx, { a, b, c }) pushes 3.
+#define vpusharr(x, ...) (memcpy(vpush_inline_((void**)&(x), sizeof((typeof(*(x))[]) __VA_ARGS__)), (typeof(*(x))[]) __VA_ARGS__, sizeof((typeof(*(x))[]) __VA_ARGS__)))
+
+// Makes room for n more elements without pushing them, so the pushes after it don't have to realloc
+#define vreserve(x, n) vreserve_((void**)&(x), (n) * sizeof(*(x)))
 #define vcpyarr(x, n, ...) (memcpy((x) + (n), (typeof(*(x))[]) __VA_ARGS__, sizeof((typeof(*(x))[]) __VA_ARGS__)))
 
 // Push n items onto the vector, so we can allocate more space at once
@@ -91,13 +105,13 @@ struct vecdata_ {
 #endif
 
 // Removes data from the middle of the array
-#define vremove(x, idx) vremove_((x), sizeof(*(x)), (idx))
+#define vremove(x, idx) vremove_((x), sizeof(*(x)), (idx) * sizeof(*(x)))
 
 // Pointer to the last element of the vector
 #define vlast(x) ((typeof(x)) ((char*)(x) + _DATA(x)->used) - 1)
 
-// Prealloc more space before setting elements.
-#define vprealloc(x, n) vpush_((void**)&(x), sizeof(*(x)) * (n))
+// Prealloc more space before setting elements. Same as vpush_uninit, without the cast.
+#define vprealloc(x, n) vpush_inline_((void**)&(x), sizeof(*(x)) * (n))
 
 // New vector initialized with a struct or array
 #define vecify(x) ((typeof(x))vnewn(sizeof(x) * 2) = x)
@@ -110,7 +124,7 @@ typedef char* vstr;
 
 // All you need to get started with this vector lib!
 VEC_H_EXTERN void* vnew();
-VEC_H_EXTERN void* vnewn(uint32_t n);
+VEC_H_EXTERN void* vnewn(uint64_t n);
 // #define vnew() ((void*) ((struct vecdata_*) calloc(1, sizeof(struct vecdata_)) + 1))
 
 // Returns a *new* concatenated vector, use `pushv` if you don't want a new vec :D
@@ -122,19 +136,29 @@ VEC_H_EXTERN char  vcmp(void* a, void* b);
 // Initialize a vector with a string straight away
 // VEC_H_EXTERN char* strtov(char* s);
 VEC_H_EXTERN char* vtostr(void* v);
-VEC_H_EXTERN void  vremove_(void* v, uint32_t size, uint32_t pos);
-VEC_H_EXTERN void* vpush_(void** v, uint32_t size);
+VEC_H_EXTERN void  vremove_(void* v, uint64_t size, uint64_t pos);
+VEC_H_EXTERN void* vpush_(void** v, uint64_t size);
+VEC_H_EXTERN void  vreserve_(void** v, uint64_t size);
 VEC_H_EXTERN void  vpushsf_(void** v, char* fmt, ...);
-VEC_H_EXTERN void  vpushn_(void** v, uint32_t n, uint32_t size, void* thing);
-// VEC_H_EXTERN void* vunshift_(void** v, uint32_t size);
+VEC_H_EXTERN void  vpushn_(void** v, uint64_t n, uint64_t size, void* thing);
+VEC_H_EXTERN void* vunshift_(void** v, uint64_t size);
 VEC_H_EXTERN char* vfmt(char* str, ...);
 
 #ifndef VEC_H_MORE_MACROS
-	VEC_H_EXTERN void* vpop_(void* v, uint32_t size);
+	VEC_H_EXTERN void* vpop_(void* v, uint64_t size);
 	VEC_H_EXTERN void* vempty(void* v);
 	VEC_H_EXTERN void  vfree(void* v);
 #endif
 
+// What the push macros use. When there's room it's a compare and an add right where it's called, and only growing
+// calls into vpush_.
+static inline void* vpush_inline_(void** v, uint64_t size) {
+	struct vecdata_* data = _DATA(*v);
+	if(data->cap - data->used < size) return vpush_(v, size);
+	data->used += size;
+	return data->data + data->used - size;
+}
+
 #endif
 
 #ifdef VEC_H_IMPLEMENTATION
@@ -159,7 +183,7 @@ VEC_H_EXTERN char* vfmt(char* str, ...);
 #include <stdio.h>
 
 #ifndef VEC_H_OVERLOAD_ALLOCATORS
-	VEC_H_EXTERN void* vnewn(uint32_t n) {
+	VEC_H_EXTERN void* vnewn(uint64_t n) {
 		struct vecdata_* v = VEC_H_CALLOC(1, sizeof(struct vecdata_) + n * sizeof(char));
 		v->cap = n;
 		return v + 1;
@@ -180,15 +204,15 @@ VEC_H_EXTERN void* vcat(void* a, void* b) {
 }
 
 VEC_H_EXTERN char vcmp(void* a, void* b) {
-	uint32_t len = _DATA(a)->used;
+	uint64_t len = _DATA(a)->used;
 	if(len != _DATA(b)->used) return 1;
-	for(uint32_t idx = 0; idx < len; idx ++)
+	for(uint64_t idx = 0; idx < len; idx ++)
 		if(((char*)a)[idx] != ((char*)b)[idx]) return 1;
 	return 0;
 }
 
 VEC_H_EXTERN char* strtov(char* s) {
-	uint32_t len = strlen(s);
+	uint64_t len = strlen(s);
 	struct vecdata_* v = VEC_H_CALLOC(1, len + sizeof(struct vecdata_));
 	v->used = v->cap = len;
 	v += 1;
@@ -197,7 +221,7 @@ VEC_H_EXTERN char* strtov(char* s) {
 }
 
 VEC_H_EXTERN char* vtostr(void* v) {
-	uint32_t len = _DATA(v)->used;
+	uint64_t len = _DATA(v)->used;
 	char* str = malloc(len + 1);
 	memcpy(str, v, len);
 	str[len] = 0;
@@ -206,7 +230,7 @@ VEC_H_EXTERN char* vtostr(void* v) {
 
 #ifndef VEC_H_MORE_MACROS
 	VEC_H_EXTERN void* vempty(void* v) { _DATA(v)->used = 0; return v; }
-	VEC_H_EXTERN void* vpop_(void* v, uint32_t size) { _DATA(v)->used -= size; return _DATA(v)->data + _DATA(v)->used; }
+	VEC_H_EXTERN void* vpop_(void* v, uint64_t size) { _DATA(v)->used -= size; return _DATA(v)->data + _DATA(v)->used; }
 	VEC_H_EXTERN void vfree(void* v) { VEC_H_FREE(_DATA(v)); }
 #endif
 
@@ -215,10 +239,10 @@ VEC_H_EXTERN char* vtostr(void* v) {
 // Reallocs more size for the array, hopefully without moves
 #ifndef VEC_H_OVERLOAD_ALLOCATORS
 	#define VEC_H_REALLOC_FUNC alloc_
-	static inline void* alloc_(struct vecdata_* data, uint32_t size) {
+	static inline void* alloc_(struct vecdata_* data, uint64_t size) {
 		data->used += size;
 		if(data->cap < data->used) {
-			data->cap = data->used + (data->used >> 2) + 16;
+			data->cap = VEC_H_GROW(data->used);
 			return (struct vecdata_*)VEC_H_REALLOC(data, sizeof(struct vecdata_) + data->cap) + 1;
 		}
 		return data + 1;
@@ -235,42 +259,49 @@ VEC_H_EXTERN char* vtostr(void* v) {
 	#define VEC_INTERNAL_PUSH_NAME vpush__
 #endif
 
-static inline void* VEC_INTERNAL_PUSH_NAME(void** v, uint32_t size) {
+static inline void* VEC_INTERNAL_PUSH_NAME(void** v, uint64_t size) {
 	struct vecdata_* data = _DATA(*v = VEC_H_REALLOC_FUNC(_DATA(*v), size));
 	return data->data + data->used - size;
 }
 
 #ifndef VEC_H_STATIC_INLINE
-	VEC_H_EXTERN void* vpush_(void** v, uint32_t size) { return VEC_INTERNAL_PUSH_NAME(v, size); }
+	VEC_H_EXTERN void* vpush_(void** v, uint64_t size) { return VEC_INTERNAL_PUSH_NAME(v, size); }
 #endif
 
+VEC_H_EXTERN void vreserve_(void** v, uint64_t size) {
+	if(_DATA(*v)->cap - _DATA(*v)->used >= size) return;
+	*v = VEC_H_REALLOC_FUNC(_DATA(*v), size);
+	_DATA(*v)->used -= size;
+}
+
 // Gets length of formatted string to allocate from vector first, and then basically writes to the ptr returned by push
 VEC_H_EXTERN void vpushsf_(void** v, char* fmt, ...) {
 	va_list args;
 	va_start(args, fmt);
 	va_list args2;
 	va_start(args2, fmt);
-	uint32_t len = vsnprintf(NULL, 0, fmt, args);
+	uint64_t len = vsnprintf(NULL, 0, fmt, args);
 	vsnprintf(VEC_INTERNAL_PUSH_NAME(v, len), len, fmt, args2);
 	va_end(args);
 	va_end(args2);
 }
 
-VEC_H_EXTERN void vpushn_(void** v, uint32_t n, uint32_t size, void* thing) {
+VEC_H_EXTERN void vpushn_(void** v, uint64_t n, uint64_t size, void* thing) {
 	char* place = VEC_INTERNAL_PUSH_NAME(v, n * size);
-	if(size == 1) memset(place, *((char*) thing), size);
-	else for(uint32_t i = 0; i < n; i ++) memcpy(place + size * i, thing, size);
+	if(size == 1) memset(place, *((char*) thing), n);
+	else for(uint64_t i = 0; i < n; i ++) memcpy(place + size * i, thing, size);
 }
 
 // Adds an element at the start of the vector, ALSO CHANGES PTR
-VEC_H_EXTERN void* vunshift_(void** v, uint32_t size) {
-	memmove((char*) (*v = alloc_(_DATA(*v), size)) + size, *v, _DATA(*v)->used);
+VEC_H_EXTERN void* vunshift_(void** v, uint64_t size) {
+	*v = VEC_H_REALLOC_FUNC(_DATA(*v), size);
+	memmove((char*) *v + size, *v, _DATA(*v)->used - size);
 	return *v;
 }
 
 // Deletes data from the middle of the array
-VEC_H_EXTERN void vremove_(void* v, uint32_t size, uint32_t pos) {
-	memmove(_DATA(v) + pos, _DATA(v) + pos + size, _DATA(v)->used - pos - size);
+VEC_H_EXTERN void vremove_(void* v, uint64_t size, uint64_t pos) {
+	memmove((char*) v + pos, (char*) v + pos + size, _DATA(v)->used - pos - size);
 	_DATA(v)->used -= size;
 }
 
@@ -281,8 +312,8 @@ VEC_H_EXTERN char* vfmt(char* str, ...) {
 	va_list args, args2;
 	va_start(args, str);
 	va_copy(args2, args);
-	uint32_t len = vsnprintf(NULL, 0, str, args) + 1;
-	if(len - _DATA(fmtstr)->used > 0)
+	uint64_t len = vsnprintf(NULL, 0, str, args) + 1;
+	if(len > _DATA(fmtstr)->used)
 		VEC_INTERNAL_PUSH_NAME((void**) &fmtstr, len - _DATA(fmtstr)->used);
 	vsnprintf(fmtstr, len, str, args2);
 	va_end(args);
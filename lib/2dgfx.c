@@ -96,10 +96,10 @@ Current Tasks:
 				- [ ] Subpixel Antialiasing
 					- Shader side if possible
 				- [x] Dynamic loading of different font sizes and fonts in one combined texture atlas.
-			- [ ] Glyph based loading and rendering.
-			- [ ] Font Fallbacks
-				- gfx_register_fallbacks(int num, { "fallback1", "fallback2" })
-			- [ ] Libature Integration (https://github.com/lite-xl/lite-xl/blob/f837c83e552a45773a2371370855c4b1f8395f9b/src/renderer.c#L127)
+			- [x] Glyph based loading and rendering.
+			- [x] Font Fallbacks
+				- gfx_register_fallbacks(face, num, (gfx_face[]) { fallback1, fallback2 })
+			- [x] Libature Integration (https://github.com/lite-xl/lite-xl/blob/f837c83e552a45773a2371370855c4b1f8395f9b/src/renderer.c#L127)
 			- Side Projects:
 				- [ ] SDF Based font renderer [IF POSSIBLE, there are way too many drawbacks for it to be an option right NOW].
 				- [ ] Not using Freetype, but rendering fonts natively.
@@ -129,14 +129,26 @@ Current Tasks:
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_TRUETYPE_TABLES_H
+#include FT_TRUETYPE_TAGS_H
+#include FT_ADVANCES_H
+#include FT_SIZES_H
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
+// Native glyph rasterizer, for faces that have it turned on with gfx_font_native_raster
+#define RASTER_H_STATIC_INLINE
+#include <raster.h>
+
 #define HASH_H_IMPLEMENTATION
 #define HASH_H_CUSTOM_HASHER
 #include <hash.h>
 
+// Draw lists get submitted from any thread
+#define CVEC_H_STATIC_INLINE
+#include <cvec.h>
+
 #define XXH_STATIC_LINKING_ONLY   /* access advanced declarations */
 #define XXH_INLINE_ALL
 #define XXH_NO_XXH3
@@ -146,6 +158,9 @@ Current Tasks:
 #include <math.h>
 #include <linmath.h>
 
+// Ligatures and other GSUB features
+#include "../deps/extern/libatures/libatures.h"
+
 #include "2dgfx.h"
 
 
@@ -208,13 +223,68 @@ typedef double f64;
 		#pragma comment(lib, "advapi32.lib")
 	#endif
 	#undef TEXT
+
+	typedef HANDLE gfx_thread;
+	#define GFX_THREAD_FUNC(name, arg) DWORD WINAPI name(LPVOID arg)
+	#define gfx_thread_start(t, fn, arg) (*(t) = CreateThread(NULL, 0, (fn), (arg), 0, NULL))
+	#define gfx_thread_join(t) (WaitForSingleObject((t), INFINITE), CloseHandle(t))
+	static inline u32 gfx_cpu_count() { SYSTEM_INFO info; GetSystemInfo(&info); return info.dwNumberOfProcessors; }
+
+	typedef CRITICAL_SECTION gfx_lock;
+	typedef CONDITION_VARIABLE gfx_cond;
+	#define gfx_lock_init(l) InitializeCriticalSection(l)
+	#define gfx_lock_take(l) EnterCriticalSection(l)
+	#define gfx_lock_give(l) LeaveCriticalSection(l)
+	#define gfx_lock_free(l) DeleteCriticalSection(l)
+	#define gfx_cond_init(c) InitializeConditionVariable(c)
+	#define gfx_cond_wait(c, l) SleepConditionVariableCS((c), (l), INFINITE)
+	#define gfx_cond_wake(c) WakeAllConditionVariable(c)
+	#define gfx_cond_wake_one(c) WakeConditionVariable(c)
+	#define gfx_cond_free(c) ((void) (c))
+
+	typedef SRWLOCK gfx_rwlock;
+	#define gfx_rwlock_init(l) InitializeSRWLock(l)
+	#define gfx_rwlock_take_read(l) AcquireSRWLockShared(l)
+	#define gfx_rwlock_give_read(l) ReleaseSRWLockShared(l)
+	#define gfx_rwlock_take_write(l) AcquireSRWLockExclusive(l)
+	#define gfx_rwlock_give_write(l) ReleaseSRWLockExclusive(l)
+	#define gfx_rwlock_free(l) ((void) (l))
 #else
 	#include <unistd.h>
+	#include <pthread.h>
+
+	typedef pthread_t gfx_thread;
+	#define GFX_THREAD_FUNC(name, arg) void* name(void* arg)
+	#define gfx_thread_start(t, fn, arg) pthread_create((t), NULL, (fn), (arg))
+	#define gfx_thread_join(t) pthread_join((t), NULL)
+	static inline u32 gfx_cpu_count() { long n = sysconf(_SC_NPROCESSORS_ONLN); return n > 0 ? n : 1; }
+
+	typedef pthread_mutex_t gfx_lock;
+	typedef pthread_cond_t gfx_cond;
+	#define gfx_lock_init(l) pthread_mutex_init((l), NULL)
+	#define gfx_lock_take(l) pthread_mutex_lock(l)
+	#define gfx_lock_give(l) pthread_mutex_unlock(l)
+	#define gfx_lock_free(l) pthread_mutex_destroy(l)
+	#define gfx_cond_init(c) pthread_cond_init((c), NULL)
+	#define gfx_cond_wait(c, l) pthread_cond_wait((c), (l))
+	#define gfx_cond_wake(c) pthread_cond_broadcast(c)
+	#define gfx_cond_wake_one(c) pthread_cond_signal(c)
+	#define gfx_cond_free(c) pthread_cond_destroy(c)
+
+	typedef pthread_rwlock_t gfx_rwlock;
+	#define gfx_rwlock_init(l) pthread_rwlock_init((l), NULL)
+	#define gfx_rwlock_take_read(l) pthread_rwlock_rdlock(l)
+	#define gfx_rwlock_give_read(l) pthread_rwlock_unlock(l)
+	#define gfx_rwlock_take_write(l) pthread_rwlock_wrlock(l)
+	#define gfx_rwlock_give_write(l) pthread_rwlock_unlock(l)
+	#define gfx_rwlock_free(l) pthread_rwlock_destroy(l)
 #endif
+#include <stdatomic.h>
 
 #define GFX_DEBUG
 #ifdef GFX_DEBUG
 	// #define TRACY_ENABLE
+	// #define GFX_TRACE
 	#include <stdarg.h>
 	#define STB_IMAGE_WRITE_IMPLEMENTATION
 	#include <stb/stb_image_write.h>
@@ -339,19 +409,55 @@ typedef double f64;
 		free(ptr);
 	}
 
-	#define VEC_H_CALLOC tracy_calloc
-	#define VEC_H_REALLOC tracy_realloc
-	#define VEC_H_FREE tracy_free
-
-	#define VEC_H_IMPLEMENTATION
 	#include <vec.h>
 
 	#define GFX_MALLOC tracy_malloc
 	#define GFX_CALLOC tracy_calloc
 	#define GFX_REALLOC tracy_realloc
 	#define GFX_FREE tracy_free
+#elif defined GFX_TRACE
+
+	// The built in tracer, see Tracing. Zones are timed with the TSC where there is one, which only takes a few cycles
+	// to read, and end up as an event in the thread's ring.
+	#include <signal.h>
+	#include <time.h>
+	#if defined __x86_64__ || defined __i386__
+		#include <x86intrin.h>
+		#define gfx_trace_now() __rdtsc()
+	#elif defined _M_X64 || defined _M_IX86
+		#include <intrin.h>
+		#define gfx_trace_now() __rdtsc()
+	#else
+		#define gfx_trace_now() gfx_trace_clock()
+	#endif
+	static u64 gfx_trace_clock();
+	static void gfx_trace_zone(const char* name, u64 start);
+	static void gfx_trace_frame();
+	static void gfx_trace_gpu_init();
+	static void gfx_trace_gpu_begin(const char* name);
+	static void gfx_trace_gpu_end();
+	static void gfx_trace_gpu_collect();
+
+	#define PROFILER_FRAME_MARK gfx_trace_frame();
+	#define PROFILER_ZONE_START const u64 gfx_zone_start = gfx_trace_now();
+	#define PROFILER_ZONE_END gfx_trace_zone(__func__, gfx_zone_start);
+	#define PROFILER_GPU_INIT() gfx_trace_gpu_init();
+	#define PROFILER_GPU_ZONE_START(zone_name) gfx_trace_gpu_begin(zone_name);
+	#define PROFILER_GPU_ZONE_END() gfx_trace_gpu_end();
+	#define PROFILER_GPU_QUERIES_COLLECT() gfx_trace_gpu_collect();
+
+	#ifndef GFX_TRACE_EVENTS
+		#define GFX_TRACE_EVENTS (1 << 16) // Per thread, the oldest get overwritten
+	#endif
+	#define GFX_TRACE_GPU_ZONES 1024 // Per context waiting on their queries, zones past that don't get timed
+	#define GFX_TRACE_GPU_DEPTH 16   // GPU zones inside each other, deeper ones don't get timed
+
+	#include <vec.h>
+	#define GFX_CALLOC calloc
+	#define GFX_MALLOC malloc
+	#define GFX_REALLOC realloc
+	#define GFX_FREE free
 #else
-	#define VEC_H_IMPLEMENTATION
 	#include <vec.h>
 	// #define PROFILER_CALL(...)
 	#define PROFILER_FRAME_MARK
@@ -364,6 +470,7 @@ typedef double f64;
 	#define GFX_CALLOC calloc
 	#define GFX_MALLOC malloc
 	#define GFX_REALLOC realloc
+	#define GFX_FREE free
 #endif
 
 
@@ -378,6 +485,21 @@ typedef struct gfx_typeface       gfx_typeface;
 typedef struct gfx_drawbuf        gfx_drawbuf;
 typedef struct gfx_vtx_buf        gfx_vtx_buf;
 typedef struct gfx_char           gfx_char;
+typedef struct gfx_shaped         gfx_shaped;
+typedef struct gfx_chain          gfx_chain;
+typedef struct gfx_kerning        gfx_kerning;
+typedef struct gfx_metrics        gfx_metrics;
+typedef struct gfx_line           gfx_line;
+typedef struct gfx_layout         gfx_layout;
+typedef struct gfx_text_slot      gfx_text_slot;
+typedef struct gfx_drawlist       gfx_drawlist;
+typedef struct gfx_raster         gfx_raster;
+typedef struct gfx_raster_job     gfx_raster_job;
+typedef struct gfx_raster_thread  gfx_raster_thread;
+typedef struct gfx_worker         gfx_worker;
+typedef struct gfx_outline        gfx_outline;
+typedef struct gfx_arena          gfx_arena;
+typedef struct gfx_packet         gfx_packet;
 typedef union  gfx_char_ident     gfx_char_ident;
 typedef union  gfx_color          gfx_color;
 
@@ -399,18 +521,19 @@ enum gfx_drawobj {
 	OBJ_ELLIPSE = 3, OBJ_TRI = 4
 };
 
+// 16 bytes, so the low codepoint tables stay small and four fit in a cache line.
 struct gfx_char {
-	gfx_vector_mini place;   // Place in texture atlas
+	u16 uv_x, uv_y;          // Place in the atlas in vertex UV units, as if the atlas had already grown to GFX_ATLAS_MAX_SIZE
 	gfx_vector_mini size;    // w, h of char texture
 	gfx_vector_mini bearing; // Refer to freetype docs on this, but I need to keep in track of it.
 	u16 advance;             // How far this character moves forward the text cursor
-	gfx_atlas_hnd atlas;     // Index of the atlas the character is located in
-	u32 c;                   // The character(unicode)
+	u8 atlas;                // Index of the atlas the character is located in
+	bool loaded;             // Always set in chars, only set in the low codepoint tables once the glyph is copied in
 };
 
 union gfx_char_ident {
 	struct {
-		FT_ULong c;
+		u32 glyph;
 		u32 size;
 	};
 	u64 full;
@@ -418,6 +541,126 @@ union gfx_char_ident {
 #define GFX_CHAR_EQUAL(a, b) (a.full == b.full)
 #define GFX_CHAR_HASH(a) (ht_int64_hash_func(a.full))
 
+// A string that has gone through the face's GSUB chain, cached by the hash of the string.
+struct gfx_shaped {
+	LBT_Glyph* glyphs; // Vector<LBT_Glyph>, lines are separated by GFX_SHAPED_NEWLINE
+	u32 last_used;     // Frame this was last drawn on, so stale strings can be evicted
+};
+#define GFX_SHAPED_NEWLINE 0xFFFF
+#define GFX_SHAPED_FALLBACK 0xFFFE // Followed by the fallback's handle in the face's chain and the glyph in that face
+#define GFX_SHAPED_MAX_AGE 120 // Frames a shaped string survives without being drawn
+
+// One chain per (script, lang, features) combination that was ever enabled on a face.
+struct gfx_chain {
+	u64 hash;
+	LBT_Chain* chain;
+};
+
+// A face's kerning pairs scaled to one font size, in pixels.
+struct gfx_kerning {
+	u32 size;
+	ht(gfx_kern, u32, i16) pairs;
+};
+#define GFX_KERN_PAIR(left, right) ((u32) (left) << 16 | (u16) (right))
+#define GFX_KERN_MAX_CODEPOINT 0x24F // Pairs are only precomputed between glyphs of Basic Latin through Latin Extended-B
+
+// Codepoint coverage is a two level bitset: 256 codepoint pages, and only the pages a face has anything in get bits.
+#define GFX_COVER_PAGES (0x110000 >> 8)
+#define GFX_COVER_WORDS (256 / 64)
+
+// Advances of a face at one rasterized size, so text can be measured without loading any bitmaps.
+struct gfx_metrics {
+	u32 size;
+	struct { u16 glyph, advance; } ascii[128]; // Filled in up front, by codepoint
+	ht(gfx_adv, u32, u16) glyphs;              // Everything else, by glyph index, as it gets measured
+};
+
+// One line of a text_box() layout, as a range of bytes in its string.
+struct gfx_line {
+	u32 start, end;
+	f32 width;
+};
+
+// The lines text_box() broke a string into, cached by the string's address so boxes that are drawn every frame don't
+// get laid out every frame.
+struct gfx_layout {
+	char* text;      // Vector<char>, copy of the text the lines were made for, to find what changed
+	gfx_line* lines; // Vector<gfx_line>
+	gfx_face face;
+	u32 size;
+	short w;
+	bool wrap;
+	u32 last_used;   // Frame this was last drawn on, so layouts of strings that are gone can be evicted
+};
+#define GFX_LAYOUT_MAX_AGE 120
+
+// A glyph FreeType rendered, before it's in an atlas.
+struct gfx_raster {
+	u8* pixels;
+	u16 w, h;
+	i16 left, top;
+	u16 advance;
+};
+
+// A pool thread's FreeType state for a context, kept between batches.
+struct gfx_raster_thread {
+	FT_Library lib;
+	FT_Face* faces; // Vector<FT_Face>, by gfx_face, opened the first time the thread gets a job for them
+	FT_Face sized;  // Face FT_Set_Pixel_Sizes was last called on, and at what size
+	u32 size;
+	raster_canvas canvas;
+};
+
+// A batch of glyphs of one face and size, split up between the job pool's threads.
+struct gfx_raster_job {
+	gfx_face tf;
+	const u8* data;   // The font file, so pool threads can open the face themselves
+	size_t data_len;
+	FT_Face face;     // The context's own face, only used by the thread that started the job
+	u32 size;
+	bool native;      // Rasterize with raster.h instead of FreeType
+	const u32* glyphs;
+	gfx_raster* results;
+	gfx_raster_thread* threads; // ctx->raster
+	gfx_raster_thread self;     // For the thread that started the job, with the context's canvas
+};
+#define GFX_RASTER_MIN_BATCH 8  // Misses per thread it takes for threads to be worth it
+#define GFX_RASTER_KEY(fallback, glyph) ((u32) (fallback) << 16 | (glyph))
+
+#define GFX_FT_SIZES 8 // FT_Size objects kept per face, the least recently used one gets replaced
+
+#define GFX_LOW_CODEPOINTS 0x250 // Latin through Latin Extended-B, looked up by codepoint without the cmap or chars
+#define GFX_LOW_TABLES 8         // Sizes with a low codepoint table per face, the least recently used one gets reused
+
+#define GFX_FRAME_ARENA_SIZE (64 * 1024) // First block of the frame arena, it grows to whatever a frame needs
+#define GFX_ARENA_ALIGN 16
+
+// A glyph that gets drawn straight from its curves by the fragment shader, see gfx_font_outlines.
+struct gfx_outline {
+	u32 header;  // Texel in ctx->share->curves with the glyph's bounding box, followed by the texel range of its curves
+	f32 advance; // In ems
+	bool empty;  // Nothing to draw, like spaces
+};
+#define GFX_TEX_SLOTS 30           // Texture units for atlases and images, the last two hold the outline glyph buffers
+#define GFX_OUTLINE_GLYPHS_SLOT 30 // This draw's outline glyphs: x, y, pixels per em, header texel
+#define GFX_OUTLINE_SLOT 31        // Every outline glyph's curves. Vertices of outline glyphs use it as their tex_slot.
+
+#define GFX_GPU_TIMERS 4 // Frames a GPU timer query can be in flight for before frames stop getting timed
+
+#define GFX_F64_LEN 332 // Bytes gfx_write_f64 can need, for -DBL_MAX with 20 decimals and a NUL
+
+// Bump allocator for memory that only has to last until the end of the frame, like the scratch vectors glyph loads
+// use. gfx_frame() frees all of it at once.
+struct gfx_arena {
+	struct gfx_arena_block {
+		struct gfx_arena_block* prev;
+		size_t used, cap;
+		_Alignas(GFX_ARENA_ALIGN) u8 data[];
+	}* block;
+	void* last; // Start of the newest allocation, which can still grow or be freed in place
+	u32 allocs; // Since the last reset
+};
+
 
 // To draw a shape:
 // Need to set:
@@ -475,15 +718,152 @@ struct gfx_drawbuf {
 	gfx_vector maxdrawbufsize;
 };
 
-struct gfx_ctx {
-	GLFWwindow* window; // GLFW Window
-	u32 width, height;
-	gfx_color curcol;   // Current color
-	vec4 stroke;        // Current stroke
-	gfx_settings settings;
-#ifdef _WIN32
-	HKEY key;
+// Text that keeps its glyph quads between frames, see gfx_textslot_new. Every codepoint has an entry in chars and four
+// vertices in verts, which are left zeroed for codepoints without a quad (spaces, newlines and glyphs that failed).
+struct gfx_text_slot {
+	char* text; // Vector<char>, what the quads were made for, to find what changed
+	struct gfx_slot_char {
+		u32 byte;          // Where the codepoint starts in text
+		u16 glyph;         // What the next glyph kerns against, 0 for fallbacks and newlines
+		bool quad;
+		f32 x, left, after; // Pen at the glyph after kerning, its bearing scaled, and the pen after its advance
+	}* chars;              // Vector
+	struct gfx_vtx_buf* verts;
+	struct gfx_slot_atlas {
+		u8 atlas;
+		gfx_slot_hnd slot;
+	}* atlases; // Vector, the texture slots the verts point at, which have to be the same when they're drawn
+	gfx_face face;
+	u32 size;
+	u32 raster;  // Size the glyphs were rasterized at, 0 when the quads have to be remade
+	u32 growths; // ctx->share->atlas_growths when the quads were made, atlases growing changes their UVs
+	short x, y;
+	bool used;
+};
+
+// Draws recorded on any thread, see gfx_drawlist_new. Shapes are finished vertices already, images wait for the merge to
+// get a texture slot, and text keeps copies of its glyphs from the low codepoint tables. Text with a glyph that wasn't
+// in one gets drawn by text() at the merge instead, from the copy of the string.
+struct gfx_drawlist {
+	struct gfx_ctx* ctx;
+	struct gfx_drawitem {
+		enum gfx_drawitem_type: u8 { GFX_ITEM_QUAD, GFX_ITEM_IMAGE, GFX_ITEM_TEXT } type;
+		union {
+			struct gfx_vtx_buf quad[4];
+			struct { gfx_img img; short x, y, w, h; } image;
+			struct {
+				gfx_face face;
+				u32 size, raster;
+				u32 str, len;      // Bytes in strs
+				u32 glyph, glyphs; // Range in glyphs
+				short x, y;
+				bool laid_out;     // Every glyph was cached, otherwise there aren't any
+			} text;
+		};
+	}* items; // Vector
+	struct gfx_drawglyph {
+		gfx_char ch;
+		f32 x;
+		short y;
+	}* glyphs;  // Vector
+	char* strs; // Vector
+	gfx_color col;
+	gfx_face face;
+	u32 size;
+	i32 layer;
+	u32 made; // When it was made, for lists on the same layer
+};
+
+// See gfx_job_submit. Internal ones live on the stack of whoever waits for them.
+struct gfx_job {
+	void (*fn)(void* arg);
+	void* arg;
+	_Atomic bool done;
+};
+
+#ifndef GFX_JOB_THREADS
+	#define GFX_JOB_THREADS 0 // Threads in a context's job pool, 0 for one per core besides the one making the context
 #endif
+#define GFX_JOB_THREADS_MAX 64
+#define GFX_JOB_DEQUE 1024    // Jobs a pool thread can have queued itself, ones past that get run right away
+
+// A pool thread. The jobs it submits go onto the bottom of its deque, where it takes its next job from too, and threads
+// that run out of jobs steal from the top (a Chase-Lev deque).
+struct gfx_worker {
+	gfx_jobs* jobs;
+	u32 index;
+	gfx_thread thread;
+	_Atomic i64 top, bottom;
+	gfx_job* _Atomic deque[GFX_JOB_DEQUE];
+};
+
+// A work stealing job pool, see gfx_job_submit.
+struct gfx_jobs {
+	gfx_worker* workers;
+	u32 n;
+	_Atomic i32 queued;   // Jobs in a deque or the inbox, counted just before they go in
+	_Atomic u32 sleeping; // Pool threads waiting on wake
+	_Atomic u32 waiting;  // Threads waiting on done
+
+	// Jobs from threads outside the pool, which don't have a deque, go in the inbox
+	gfx_lock lock;
+	gfx_cond wake, done;
+	gfx_job** inbox; // Vector, the jobs from inbox_at on haven't been taken
+	u32 inbox_at;
+	_Atomic u32 inboxed;
+
+	_Atomic u32 users; // Contexts using the pool, the last one to be freed frees it
+	bool quit;         // Under lock, wakes the pool's threads to exit once there's nothing left to do
+};
+
+// A frame for the render thread, see gfx_settings.render_thread. It has the draw buffers the frame was built in, and
+// everything the frame did that has to happen on the GL context, in the order it happened.
+struct gfx_packet {
+	struct gfx_vtx_buf* shp; // Vectors, swapped with the context's draw buffers when the frame is handed over
+	u32* idx;
+	f32* glyphs;             // Outline glyphs, see ctx->gl.outlines
+	f32* curves;             // Vector, outline curves that are new since the frame before
+
+	struct gfx_render_cmd {
+		enum gfx_render_op: u8 {
+			GFX_OP_SLOT,    // Makes tex the active texture slot
+			GFX_OP_TEX_NEW, // Makes texture tex and binds it, pixellated in flag
+			GFX_OP_BIND,    // Binds texture tex to the active slot
+			GFX_OP_UPLOAD,  // Replaces the bound texture's pixels, pixellated in flag
+			GFX_OP_PATCH,   // Replaces pixels of the bound texture in x, y, w, h
+			GFX_OP_DRAW,    // Draws w indices starting at x
+			GFX_OP_RESIZE,  // Screen size changed to w, h
+			GFX_OP_VSYNC    // Vsync on or off from flag
+		} op;
+		bool flag;
+		u16 format;
+		u32 tex;
+		u32 x, y, w, h;
+		u64 data; // Where the pixels of UPLOAD and PATCH start in data
+	}* cmds;      // Vector
+	u8* data;     // Vector, copies of the pixels the commands upload
+
+	// From glfwGetTime()
+	double handed;    // gfx_frame() handed the packet over
+	double started;   // The render thread started on it
+	double submitted; // Everything was uploaded and drawn
+	double presented; // Swapping the buffers returned
+	f32 gpu;          // Milliseconds, the render thread's newest GPU timer result when it presented
+};
+
+// Everything contexts made with gfx_settings.share have in common: textures and what's in them, fonts with their glyph
+// caches, and the shader. Their GL contexts share objects, so the GL ids are good in all of them. A thread holds the
+// lock the whole time it uses one of the contexts, from gfx_ctx_set() until it sets another one, except while
+// gfx_frame() waits for the swap.
+struct gfx_share {
+	gfx_lock lock;
+	u32 contexts;
+	u32 uploads; // Times a context changed what's in a texture, so the others know to bind theirs again
+
+	FT_Library ft;
+	GLuint progid;
+	GLuint* tex_ids; // Vector, GL textures by gfx_tex_id
+	f32* curves;     // Vector<f32>, 4 per texel, every glyph's curves as quadratics in ems: (p0, p1), (p2, unused)
 
 	struct gfx_atlas {
 		struct gfx_atlas_added {
@@ -495,6 +875,7 @@ struct gfx_ctx {
 		bool uploaded;
 		u16 format;
 		u32 tex_id;
+		u64 used; // Pixels taken up by everything added
 		struct gfx_atlas_node {
 			gfx_vector_mini p; // Place
 			gfx_vector_mini s; // Size
@@ -502,6 +883,7 @@ struct gfx_ctx {
 			bool filled;
 		}* tree; // Array of trees, one tree per layer
 	}* atlases;
+	u32 atlas_growths; // Times any atlas has grown, which changes the UVs of everything in it
 
 	struct gfx_internal_image {
 		gfx_atlas_hnd atlas_hnd; // -1
@@ -510,6 +892,76 @@ struct gfx_ctx {
 		gfx_vector_mini place;
 	}* images;
 
+	struct gfx_typeface {
+		const char* name; // Copy of the path it was loaded from
+		FT_Face face;
+		u8* data;         // The font file, which face and the pool threads' faces are opened from
+		size_t data_len;
+		u32 space_width;
+		u32 space_glyph;
+
+		// Fallbacks, searched in order for codepoints that aren't in the face's cmap
+		gfx_face* fallbacks; // Vector<gfx_face>
+		u16* cover_pages;    // GFX_COVER_PAGES handles into cover_bits, 0 when the face has nothing in the page
+		u64* cover_bits;     // Vector<u64>, GFX_COVER_WORDS per page
+		ht(gfx_char, gfx_char_ident, gfx_char) chars;
+
+		// Shaping, only used when features are enabled with gfx_font_features
+		LBT_ChainCreator* lbt;
+		gfx_chain* chains;  // Vector<gfx_chain>
+		u32 chain_hnd;      // Active chain, 0 means no shaping
+		ht(gfx_shaped, u64, gfx_shaped) shaped;
+
+		// Kerning, read once at load time in font units and scaled once per size
+		struct ht_gfx_kern_t kern;
+		u64* kern_left;          // Vector<u64>, bitset of the glyphs that are on the left of a pair
+		gfx_kerning* kernings;   // Vector<gfx_kerning>
+
+		gfx_metrics* metrics;    // Vector<gfx_metrics>, one per rasterized size that was measured
+
+		// Sizes FreeType has already scaled the face to, so switching between them doesn't redo the scaling and hinting setup
+		struct gfx_ft_size {
+			u32 size;
+			u32 last_used;
+			FT_Size ft;
+		} sizes[GFX_FT_SIZES];
+		u32 active_size, size_tick;
+
+		// The face's own glyphs for codepoints under GFX_LOW_CODEPOINTS, by codepoint, for the last few sizes text() drew.
+		// Copies of what's in chars, made the first time text() finds them there.
+		u16* low_glyphs; // GFX_LOW_CODEPOINTS glyph indices, 0 when the face doesn't have it and fallbacks get checked
+		struct gfx_low_table {
+			u32 size;
+			u32 last_used;
+			gfx_char* chars; // GFX_LOW_CODEPOINTS of them
+		} low[GFX_LOW_TABLES];
+		u32 low_tick;
+
+		bool native_raster; // Outlines get rasterized by raster.h instead of FreeType
+
+		bool draw_outlines; // Glyphs get drawn from their curves instead of atlases, at any size
+		ht(gfx_outline, u32, gfx_outline) outlines;
+	}* fonts;
+
+	// Draw lists read the fonts, the low codepoint tables in them and kerning from any thread. They take this to read,
+	// and whoever holds the lock takes it to change any of that. Reads under the lock don't need it.
+	gfx_rwlock fonts_lock;
+};
+
+struct gfx_ctx {
+	GLFWwindow* window; // GLFW Window
+	u32 width, height;
+	gfx_color curcol;   // Current color
+	vec4 stroke;        // Current stroke
+	gfx_settings settings;
+#ifdef _WIN32
+	HKEY key;
+#endif
+	struct gfx_share* share;
+	u32 uploads;         // share->uploads as of the last time this context had the lock
+	_Atomic u64 resized; // Framebuffer size from the thread polling events, width << 32 | height, 0 once it's applied
+
+	// This context's view of the share's textures, see gfx_tex
 	struct gfx_texture {
 		GLuint id;
 		gfx_slot_hnd slot;
@@ -517,26 +969,102 @@ struct gfx_ctx {
 
 	// OpenGL related variables.
 	struct {
-		GLuint progid, varrid, vbufid, idxbufid;
+		GLuint varrid, vbufid, idxbufid;
 		GLuint curtex;
 		gfx_drawbuf drawbuf;
 		ht(gfx_uni, char*, GLint) uniforms;
 		gfx_tex_hnd slots[32];
 		gfx_slot_hnd slot_bound;
+
+		// GL_TIME_ELAPSED queries around each frame's drawing. Frames only get timed while a query is free.
+		struct {
+			GLuint ids[GFX_GPU_TIMERS];
+			u32 begun, read; // Queries started and read back, ids are used in a ring by them
+			bool running;
+			f32 last;        // Newest result, in milliseconds
+		} timer;
+
+		// Buffer textures the shaders draw outline glyphs from
+		struct {
+			GLuint curve_buf, curve_tex, glyph_buf, glyph_tex;
+			u32 uploaded; // Floats of curves that are on the GPU already
+			u32 capacity; // Floats the GPU's buffer has room for
+			f32* glyphs;  // Vector<f32>, 4 per outline glyph drawn since the last draw call
+		} outlines;
 	} gl;
 
 	struct {
-		struct gfx_typeface {
-			const char* name;
-			FT_Face face;
-			u32 space_width;
-			gfx_face fallback;
-			ht(gfx_char, gfx_char_ident, gfx_char) chars;
-		}* store;
 		gfx_face cur;
-		u32 size, lh;
+		u32 size;
+		f32 lh; // Line height as a multiple of the font size
+
+		// Size buckets, see gfx_font_buckets. A ratio of 0 rasterizes every size exactly.
+		f32 bucket_ratio;
+		u32 bucket_min;
+
+		ht(gfx_layout, u64, gfx_layout) layouts;
+		gfx_text_slot* slots; // Vector, by gfx_textslot
+		raster_canvas canvas; // Accumulation buffer for glyphs rasterized natively on this thread
 	} font;
 
+	gfx_jobs* jobs;
+	gfx_raster_thread* raster; // By pool thread
+
+	gfx_stats stats;
+	gfx_stats history[GFX_STATS_HISTORY]; // Ring of the stats of the last frames, by frame.recorded
+
+	// The fps counter's text, written again whenever the fps is recalculated
+	struct {
+		char fps[GFX_F64_LEN + 4], spread[3 * (6 + GFX_F64_LEN) + 3];
+		u32 len, spread_len;
+	} counter;
+
+	// The render thread, which owns the GL context while it runs. GL objects and the parts of ctx->gl that only exist
+	// for them (program, buffers, uniforms, outline buffers) are then only touched by it, and everything else that would
+	// call GL records a command into the packet instead.
+	struct {
+		bool on;
+		gfx_thread thread;
+		gfx_packet packets[2];
+		u32 recording;  // Packet the frame being built records into, the other one is the render thread's
+		u32 drawn;      // Indices already covered by a GFX_OP_DRAW this frame
+		u32 curves;     // Floats of outline curves that were already sent
+
+		// Shared, under lock
+		gfx_lock lock;
+		gfx_cond cond;
+		gfx_packet* pending; // Handed over and not presented yet
+		bool quit;
+
+		// The render thread's own
+		GLuint* tex_ids;     // Vector, GL textures by gfx_tex_id
+		f32* outline_curves; // Vector, copy of ctx->share->curves so they can be uploaded again after growing
+		gfx_slot_hnd slot;   // Active texture slot
+		u32 presented;       // Frames, for collecting GPU profiler queries every so often
+	} render;
+
+	// Draw lists, see gfx_drawlist_new
+	struct {
+		cvec queue; // gfx_drawlist*, submitted since the last merge
+		u32 made;
+	} lists;
+
+#ifdef GFX_TRACE
+	// The tracer's GPU zones, timed by a pair of timestamp queries each. Only touched by the thread with the GL context.
+	struct {
+		struct gfx_gpu_zone {
+			const char* name;
+			bool ended;
+		} zones[GFX_TRACE_GPU_ZONES];          // Ring, by begun and read
+		GLuint ids[GFX_TRACE_GPU_ZONES * 2];  // Begin and end query of each zone
+		u32 begun, read;
+		u32 open[GFX_TRACE_GPU_DEPTH], depth; // Zones that began and haven't ended, UINT32_MAX for untimed ones
+		i64 gpu_base;                         // A GPU timestamp, and the ticks at the same time
+		u64 ticks_base;
+		struct gfx_trace_ring* ring;
+	} trace;
+#endif
+
 	struct {
 		double x, y;
 		struct {
@@ -554,6 +1082,17 @@ struct gfx_ctx {
 		double last;
 		double frametime;
 		u32 count;
+		gfx_arena arena;
+		u32 heap_allocs; // Vector allocations and reallocations that went to the heap this frame
+
+		// For the stats, see gfx_stats_record
+		double built;    // When the frame was drawn or handed to the render thread
+		u32 glyph_loads; // stats.glyph_loads when the frame started
+		u32 recorded;    // Frames in the history so far
+		struct {
+			u32 draw_calls, flushes, vertices, indices;
+			u64 upload_bytes;
+		} counts;        // This frame's so far
 	} frame;
 
 	struct {
@@ -565,10 +1104,153 @@ struct gfx_ctx {
 };
 
 static _Thread_local struct gfx_ctx* ctx = NULL;
+static _Thread_local bool gfx_render_side = false; // Render threads share the context of the thread building frames
 
 ht_impl(gfx_char, gfx_char_ident, gfx_char, GFX_CHAR_HASH, GFX_CHAR_EQUAL);
+ht_impl(gfx_shaped, u64, gfx_shaped, ht_int64_hash_func, ht_int64_hash_equal);
+ht_impl(gfx_kern, u32, i16, ht_int_hash_func2, ht_int_hash_equal);
+ht_impl(gfx_adv, u32, u16, ht_int_hash_func2, ht_int_hash_equal);
+ht_impl(gfx_layout, u64, gfx_layout, ht_int64_hash_func, ht_int64_hash_equal);
+ht_impl(gfx_outline, u32, gfx_outline, ht_int_hash_func2, ht_int_hash_equal);
 ht_impl_str(gfx_uni, GLint);
 
+
+// ------ Frame Arena ------ //
+
+static struct gfx_arena_block* gfx_arena_block(struct gfx_arena_block* prev, size_t cap) {
+	struct gfx_arena_block* block = GFX_MALLOC(sizeof(struct gfx_arena_block) + cap);
+	*block = (struct gfx_arena_block) { .prev = prev, .cap = cap };
+	return block;
+}
+
+#define GFX_ARENA_ROUND(size) (((size) + GFX_ARENA_ALIGN - 1) & ~(size_t) (GFX_ARENA_ALIGN - 1))
+
+static void* gfx_arena_alloc(gfx_arena* arena, size_t size) {
+	struct gfx_arena_block* block = arena->block;
+	if(!block || block->used + size > block->cap) {
+		// A new block instead of a realloc, since everything already handed out has to stay where it is
+		size_t cap = block ? block->cap * 2 : GFX_FRAME_ARENA_SIZE;
+		while(cap < size) cap *= 2;
+		block = arena->block = gfx_arena_block(block, cap);
+	}
+	arena->last = block->data + block->used;
+	block->used += GFX_ARENA_ROUND(size);
+	arena->allocs ++;
+	return arena->last;
+}
+
+// Grows an allocation, in place if nothing came after it
+static void* gfx_arena_grow(gfx_arena* arena, void* ptr, size_t old, size_t size) {
+	struct gfx_arena_block* block = arena->block;
+	if(ptr == arena->last && (u8*) ptr - block->data + size <= block->cap) {
+		block->used = (u8*) ptr - block->data + GFX_ARENA_ROUND(size);
+		return ptr;
+	}
+	return memcpy(gfx_arena_alloc(arena, size), ptr, old);
+}
+
+// Only the newest allocation actually gets freed, everything else waits for the reset
+static void gfx_arena_free(gfx_arena* arena, void* ptr) {
+	if(ptr != arena->last) return;
+	arena->block->used = (u8*) ptr - arena->block->data;
+	arena->last = NULL;
+}
+
+static bool gfx_arena_owns(const gfx_arena* arena, const void* ptr) {
+	for(struct gfx_arena_block* block = arena->block; block; block = block->prev)
+		if((uintptr_t) ptr - (uintptr_t) block->data < block->cap) return true;
+	return false;
+}
+
+static size_t gfx_arena_used(const gfx_arena* arena) {
+	size_t used = 0;
+	for(struct gfx_arena_block* block = arena->block; block; block = block->prev) used += block->used;
+	return used;
+}
+
+// Gives every block back, for when the context goes away
+static void gfx_arena_destroy(gfx_arena* arena) {
+	while(arena->block) {
+		struct gfx_arena_block* prev = arena->block->prev;
+		GFX_FREE(arena->block);
+		arena->block = prev;
+	}
+	arena->last = NULL;
+}
+
+// Frees everything at once. A frame that needed more than one block gets one big enough for all of them next time.
+static void gfx_arena_reset(gfx_arena* arena) {
+	struct gfx_arena_block* block = arena->block;
+	if(!block) return;
+	if(block->prev) {
+		size_t cap = 0;
+		while(block) {
+			struct gfx_arena_block* prev = block->prev;
+			cap += block->cap;
+			GFX_FREE(block);
+			block = prev;
+		}
+		arena->block = gfx_arena_block(NULL, cap);
+	}
+	arena->block->used = 0;
+	arena->last = NULL;
+	arena->allocs = 0;
+}
+
+// Scratch memory that's gone after the next gfx_frame()
+static void* gfx_frame_alloc(size_t size) {
+	return gfx_arena_alloc(&ctx->frame.arena, size);
+}
+
+// A vector in the frame arena. Pushes are pointer bumps, and vfree() is free since the memory goes with the frame
+// anyway. It can't be kept past the next gfx_frame().
+static void* gfx_frame_vnew() {
+	struct vecdata_* v = gfx_frame_alloc(sizeof(struct vecdata_) + 64);
+	*v = (struct vecdata_) { .cap = 64 };
+	return v + 1;
+}
+
+// vec.h's allocators. Vectors from vnew() are on the heap like they always were, but growing or freeing one from
+// gfx_frame_vnew() stays in the arena. Threads without a context only ever have heap vectors, and so does the render
+// thread, since the arena and its counters belong to the thread building frames.
+static inline bool gfx_builds_frames() { return ctx && !gfx_render_side; }
+
+void* vnewn(uint64_t n) {
+	struct vecdata_* v = GFX_CALLOC(1, sizeof(struct vecdata_) + n);
+	v->cap = n;
+	if(gfx_builds_frames()) ctx->frame.heap_allocs ++;
+	return v + 1;
+}
+
+void* vnew() { return vnewn(16); }
+
+static void* gfx_vec_grow(struct vecdata_* data, uint64_t size) {
+	data->used += size;
+	if(data->cap >= data->used) return data + 1;
+	if(gfx_builds_frames() && gfx_arena_owns(&ctx->frame.arena, data)) {
+		// Doubles, since moving leaves the old copy behind in the arena
+		u64 old = data->cap;
+		data->cap = data->used * 2;
+		return (struct vecdata_*) gfx_arena_grow(&ctx->frame.arena, data, sizeof(struct vecdata_) + old, sizeof(struct vecdata_) + data->cap) + 1;
+	}
+	data->cap = VEC_H_GROW(data->used);
+	if(gfx_builds_frames()) ctx->frame.heap_allocs ++;
+	return (struct vecdata_*) GFX_REALLOC(data, sizeof(struct vecdata_) + data->cap) + 1;
+}
+
+static void gfx_vec_free(void* data) {
+	if(gfx_builds_frames() && gfx_arena_owns(&ctx->frame.arena, data)) gfx_arena_free(&ctx->frame.arena, data);
+	else GFX_FREE(data);
+}
+
+#define VEC_H_OVERLOAD_ALLOCATORS
+#define VEC_H_REALLOC_FUNC gfx_vec_grow
+#define VEC_H_CALLOC GFX_CALLOC
+#define VEC_H_REALLOC GFX_REALLOC
+#define VEC_H_FREE gfx_vec_free
+#define VEC_H_IMPLEMENTATION
+#include <vec.h>
+
 // -------------------------------- OpenGL Helper Functions + Data -------------------------------- //
 
 #define TEXT 0
@@ -588,9 +1270,13 @@ static struct {
 		layout (location = 1) in uvec4 info;
 
 		uniform vec2 u_screen;
+		uniform samplerBuffer u_glyphs; // Outline glyphs this frame: x, y, pixels per em, texel of the glyph in u_curves
+		uniform samplerBuffer u_curves; // Every outline glyph: bounding box, curve range, then the curves in ems
 
 		out vec2 v_uv;
 		out vec4 v_col;
+		out vec2 v_em;
+		flat out uvec2 v_curves;
 		flat out uvec4 v_info;
 		flat out uvec2 debug_uv;
 		flat out uint v_type;
@@ -620,6 +1306,21 @@ static struct {
 				v_info = info;
 				debug_uv = uvec2(uv_x, uv_y);
 				v_uv = vec2(float(uv_x) / 16383.0, float(uv_y) / 8191.0);
+
+				// Outline glyphs use the uv bits for which glyph this is and which corner of it. The quad is placed from the
+				// glyph's exact position here, since vertex positions are whole pixels.
+				if (tex_id == uint(31)) {
+					uint key = (uv_x << 13) | uv_y;
+					vec4 glyph = texelFetch(u_glyphs, int(key >> 2));
+					vec4 box = texelFetch(u_curves, int(glyph.w));
+					vec2 pad = vec2(1.0 / glyph.z);
+					v_em = mix(box.xy - pad, box.zw + pad, vec2(float(key & uint(1)), float((key >> 1) & uint(1))));
+					v_curves = uvec2(texelFetch(u_curves, int(glyph.w) + 1).xy);
+					v_type = type;
+					vec2 screen = vec2(glyph.x + v_em.x * glyph.z, glyph.y - v_em.y * glyph.z);
+					gl_Position = vec4(screen.x / u_screen.x * 2 - 1.0, -screen.y / u_screen.y * 2 + 1.0, 1.0, 1.0);
+					return;
+				}
 			} else {
 			  v_uv = data[gl_VertexID % 3];
 			  v_col = col;
@@ -638,12 +1339,15 @@ static struct {
 
 		in vec2 v_uv;
 		in vec4 v_col;
+		in vec2 v_em;
+		flat in uvec2 v_curves;
 		flat in uint v_type;
 		flat in uint v_tex_id;
 		// in vec2 v_pos;
 		// in float v_idx;
 
 		uniform sampler2D u_tex[32];
+		uniform samplerBuffer u_curves;
 		// uniform vec2 u_tex_size[32];
 		vec4 text;
 
@@ -654,8 +1358,59 @@ static struct {
 		// 	return min(max(d.x,d.y),0.0) + length(max(d,0.0)) - rad;
 		// }
 
+		// Which of a quadratic's two roots cross the ray going right from the pixel, from the signs of the curve's y values.
+		// Looking it up this way counts curves that only touch the ray, and ones that meet at endpoints, exactly once.
+		// From the Slug algorithm: https://jcgt.org/published/0006/02/02/
+		uint root_code(float y1, float y2, float y3) {
+			uint shift = (floatBitsToUint(y1) >> 31) | ((floatBitsToUint(y2) >> 30) & uint(2)) | ((floatBitsToUint(y3) >> 29) & uint(4));
+			return (uint(0x2E74) >> shift) & uint(0x0101);
+		}
+
+		// Where the curve crosses y = 0 (or x = 0 when the coordinates come in swapped), for both roots
+		vec2 solve_roots(vec4 p12, vec2 p3) {
+			vec2 a = p12.xy - p12.zw * 2.0 + p3;
+			vec2 b = p12.xy - p12.zw;
+			float d = sqrt(max(b.y * b.y - a.y * p12.y, 0.0));
+			float t1 = (b.y - d) / a.y;
+			float t2 = (b.y + d) / a.y;
+			if (abs(a.y) < 1.0 / 65536.0) t1 = t2 = p12.y * 0.5 / b.y;
+			return vec2((a.x * t1 - b.x * 2.0) * t1 + p12.x, (a.x * t2 - b.x * 2.0) * t2 + p12.x);
+		}
+
+		// Coverage of the pixel by the glyph's curves, from a ray cast right and one cast up, each antialiased over a pixel.
+		float outline_coverage() {
+			vec2 ppe = 1.0 / fwidth(v_em); // Pixels per em
+			float xcov = 0.0, ycov = 0.0, xwgt = 0.0, ywgt = 0.0;
+			for (uint i = v_curves.x; i < v_curves.x + v_curves.y; i += uint(2)) {
+				vec4 p12 = texelFetch(u_curves, int(i)) - v_em.xyxy;
+				vec2 p3 = texelFetch(u_curves, int(i) + 1).xy - v_em;
+
+				uint code = root_code(p12.y, p12.w, p3.y);
+				if (code != uint(0)) {
+					vec2 r = solve_roots(p12, p3) * ppe.x;
+					if ((code & uint(1)) != uint(0)) { xcov += clamp(r.x + 0.5, 0.0, 1.0); xwgt = max(xwgt, clamp(1.0 - abs(r.x) * 2.0, 0.0, 1.0)); }
+					if (code > uint(1)) { xcov -= clamp(r.y + 0.5, 0.0, 1.0); xwgt = max(xwgt, clamp(1.0 - abs(r.y) * 2.0, 0.0, 1.0)); }
+				}
+
+				code = root_code(p12.x, p12.z, p3.x);
+				if (code != uint(0)) {
+					vec2 r = solve_roots(p12.yxwz, p3.yx) * ppe.y;
+					if ((code & uint(1)) != uint(0)) { ycov -= clamp(r.x + 0.5, 0.0, 1.0); ywgt = max(ywgt, clamp(1.0 - abs(r.x) * 2.0, 0.0, 1.0)); }
+					if (code > uint(1)) { ycov += clamp(r.y + 0.5, 0.0, 1.0); ywgt = max(ywgt, clamp(1.0 - abs(r.y) * 2.0, 0.0, 1.0)); }
+				}
+			}
+
+			// Each ray is only accurate near edges it crosses, so they're weighted by how close their nearest crossing is
+			float cov = max(abs(xcov * xwgt + ycov * ywgt) / max(xwgt + ywgt, 1.0 / 65536.0), min(abs(xcov), abs(ycov)));
+			return clamp(cov, 0.0, 1.0);
+		}
+
 		void main() {
 			if (v_type == uint(3)) {
+				if (v_tex_id == uint(31)) {
+					color = vec4(1.0, 1.0, 1.0, outline_coverage());
+					return;
+				}
 			  text = texture(u_tex[v_tex_id], v_uv);
 			  color = text;
 				return;
@@ -742,6 +1497,10 @@ static inline GLuint gfx_shaderprog(const char* vert, const char* frag) {
 	return program;
 }
 
+// With a render thread, GL calls the frame makes get recorded into the packet it's building instead, see ctx->render
+static inline gfx_packet* gfx_recording() { return ctx->render.packets + ctx->render.recording; }
+#define gfx_record(...) vpush(gfx_recording()->cmds, { __VA_ARGS__ })
+
 // ----------------------------------- Small Font Atlas Library ----------------------------------- //
 
 // Algorithm's concept picked up from: https://blackpawn.com/texts/lightmaps/default.html
@@ -826,6 +1585,9 @@ static inline u32 gfx_align(u32 n, u32 a) { return (n + a - 1) & ~(a - 1); }
 #ifndef max
 #define max(a, b) ((a) > (b) ? (a) : (b))
 #endif
+#ifndef min
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#endif
 
 static inline u32 gfx_totalarea(gfx_atlas_added* boxes /* Vector<gfx_atlas_added> */) {
 	u32 total = 0;
@@ -847,7 +1609,7 @@ size_t gfx_read(char const* file, char** buf) {
 	rewind(fp);
 
 	*buf = GFX_MALLOC(len * sizeof(char) + 1);
-	*buf[len] = '\0';
+	(*buf)[len] = '\0';
 	fread(*buf, 1, len, fp);
 	fclose(fp);
 
@@ -912,7 +1674,7 @@ void gfx_store_cleanup() {
 static inline GLint gfx_uloc(char* name) {
 	GLint* v = hget(gfx_uni, ctx->gl.uniforms, name);
 	if(!v) {
-  	u32 id = glGetUniformLocation(ctx->gl.progid, name);
+  	u32 id = glGetUniformLocation(ctx->share->progid, name);
 	  *hput(gfx_uni, ctx->gl.uniforms, name) = id;
 		return id;
 	}
@@ -958,25 +1720,30 @@ gfx_vector gfx_screen_dims() {
 // Creates a projection in proportion to the screen coordinates
 void gfx_updatescreencoords(u32 width, u32 height) {
 	ctx->width = width; ctx->height = height;
-	gfx_uset2f("u_screen", (vec2) { width, height });
+	if(ctx->render.on) gfx_record(.op = GFX_OP_RESIZE, .w = width, .h = height);
+	else gfx_uset2f("u_screen", (vec2) { width, height });
 }
 
+// Callbacks come in on the thread polling events, which doesn't have to be the one using the window's context, so they
+// find the context through the window.
 void gfx_mousebuttoncallback(GLFWwindow* window, int button, int action, int mods) {
-	if (on_mouse_button) on_mouse_button((gfx_vector) { ctx->mouse.x, ctx->mouse.y }, button, action == GLFW_PRESS, mods);
+	struct gfx_ctx* c = glfwGetWindowUserPointer(window);
+	if (on_mouse_button) on_mouse_button((gfx_vector) { c->mouse.x, c->mouse.y }, button, action == GLFW_PRESS, mods);
 	if (action == GLFW_PRESS) {
-		ctx->mouse.pressed = true;
-		glfwGetCursorPos(window, &ctx->mouse.press.x, &ctx->mouse.press.y);
-	} else ctx->mouse.pressed = false;
+		c->mouse.pressed = true;
+		glfwGetCursorPos(window, &c->mouse.press.x, &c->mouse.press.y);
+	} else c->mouse.pressed = false;
 }
 
 void gfx_cursorposcallback(GLFWwindow* window, double xpos, double ypos) {
-	ctx->mouse.x = xpos;
-	ctx->mouse.y = ypos;
-	if(on_mouse_move) on_mouse_move((gfx_vector) { ctx->mouse.x, ctx->mouse.y });
-	if(ctx->mouse.pressed) {
+	struct gfx_ctx* c = glfwGetWindowUserPointer(window);
+	c->mouse.x = xpos;
+	c->mouse.y = ypos;
+	if(on_mouse_move) on_mouse_move((gfx_vector) { c->mouse.x, c->mouse.y });
+	if(c->mouse.pressed) {
 		int wxpos, wypos;
 		glfwGetWindowPos(window, &wxpos, &wypos);
-		glfwSetWindowPos(window, (int) (xpos - ctx->mouse.press.x) + wxpos, (int) (ypos - ctx->mouse.press.y) + wypos);
+		glfwSetWindowPos(window, (int) (xpos - c->mouse.press.x) + wxpos, (int) (ypos - c->mouse.press.y) + wypos);
 	}
 }
 
@@ -985,18 +1752,251 @@ void gfx_keycallback(GLFWwindow* window, int key, int scancode, int action, int
 	else if (action == GLFW_PRESS && key == GLFW_KEY_ESCAPE) glfwSetWindowShouldClose(window, 1);
 }
 
+// The context's own thread picks the size up in gfx_frame(), since it's the one that can change the viewport
+#define GFX_RESIZED (1ull << 63)
 void gfx_framebuffersizecallback(GLFWwindow* window, int width, int height) {
-	glViewport(0, 0, width, height);
-	gfx_updatescreencoords(width, height);
+	struct gfx_ctx* c = glfwGetWindowUserPointer(window);
+	atomic_store(&c->resized, GFX_RESIZED | (u64) width << 32 | (u32) height);
 }
 
 void gfx_windowposcallback(GLFWwindow* window, int xpos, int ypos) {
 	if(on_window_move) on_window_move((gfx_vector) { .x = xpos, .y = ypos });
 
-	if(!ctx->settings.dont_store_settings) {
+	struct gfx_ctx* c = glfwGetWindowUserPointer(window), *cur = ctx;
+	if(!c->settings.dont_store_settings) {
+		ctx = c; // The store is per context
 		gfx_store_set(GFX_TYPE_INT, "pos_x", &(u32) { xpos }, sizeof(u32));
 		gfx_store_set(GFX_TYPE_INT, "pos_y", &(u32) { ypos }, sizeof(u32));
+		ctx = cur;
+	}
+}
+
+// ------------------------------------------ Job System ------------------------------------------ //
+
+static _Thread_local gfx_worker* gfx_self = NULL; // The pool thread this is, if it's one
+
+// Only the worker the deque belongs to pushes and pops, at the bottom.
+static bool gfx_deque_push(gfx_worker* w, gfx_job* job) {
+	i64 b = atomic_load_explicit(&w->bottom, memory_order_relaxed);
+	i64 t = atomic_load_explicit(&w->top, memory_order_acquire);
+	if(b - t >= GFX_JOB_DEQUE) return false;
+	atomic_store_explicit(w->deque + (b & (GFX_JOB_DEQUE - 1)), job, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+	return true;
+}
+
+static gfx_job* gfx_deque_pop(gfx_worker* w) {
+	i64 b = atomic_load_explicit(&w->bottom, memory_order_relaxed) - 1;
+	atomic_store_explicit(&w->bottom, b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	i64 t = atomic_load_explicit(&w->top, memory_order_relaxed);
+	if(t > b) {
+		atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+		return NULL;
+	}
+
+	// The last job, which a thief could be taking at the same time
+	gfx_job* job = atomic_load_explicit(w->deque + (b & (GFX_JOB_DEQUE - 1)), memory_order_relaxed);
+	if(t == b) {
+		if(!atomic_compare_exchange_strong_explicit(&w->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) job = NULL;
+		atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+	}
+	return job;
+}
+
+// Any other thread takes from the top. NULL when it's empty or another thread got there first.
+static gfx_job* gfx_deque_steal(gfx_worker* w) {
+	i64 t = atomic_load_explicit(&w->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	i64 b = atomic_load_explicit(&w->bottom, memory_order_acquire);
+	if(t >= b) return NULL;
+	gfx_job* job = atomic_load_explicit(w->deque + (t & (GFX_JOB_DEQUE - 1)), memory_order_relaxed);
+	return atomic_compare_exchange_strong_explicit(&w->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed) ? job : NULL;
+}
+
+// Pool threads take from their own deque first, then the inbox, then steal starting from the thread after them.
+static gfx_job* gfx_job_find(gfx_jobs* jobs) {
+	gfx_job* job = gfx_self ? gfx_deque_pop(gfx_self) : NULL;
+	if(!job && atomic_load(&jobs->inboxed)) {
+		gfx_lock_take(&jobs->lock);
+		if(jobs->inbox_at < vlen(jobs->inbox)) {
+			job = jobs->inbox[jobs->inbox_at ++];
+			atomic_fetch_sub(&jobs->inboxed, 1);
+			if(jobs->inbox_at == vlen(jobs->inbox)) vempty(jobs->inbox), jobs->inbox_at = 0;
+		}
+		gfx_lock_give(&jobs->lock);
+	}
+	for(u32 i = 0, from = gfx_self ? gfx_self->index + 1 : 0; !job && i < jobs->n; i ++) {
+		gfx_worker* victim = jobs->workers + (from + i) % jobs->n;
+		if(victim != gfx_self) job = gfx_deque_steal(victim);
+	}
+	if(job) atomic_fetch_sub(&jobs->queued, 1);
+	return job;
+}
+
+static void gfx_job_run(gfx_jobs* jobs, gfx_job* job) {
+	job->fn(job->arg);
+
+	// The job can be freed as soon as it's done, so it's not touched after
+	atomic_store(&job->done, true);
+	if(atomic_load(&jobs->waiting)) {
+		gfx_lock_take(&jobs->lock);
+		gfx_cond_wake(&jobs->done);
+		gfx_lock_give(&jobs->lock);
+	}
+}
+
+// Jobs get counted before they go in, and sleepers count themselves before checking for jobs, so either the sleeper sees
+// the job or this sees the sleeper. Threads waiting on a job get woken too, pool threads among them could take it.
+static void gfx_job_push(gfx_jobs* jobs, gfx_job* job) {
+	atomic_fetch_add(&jobs->queued, 1);
+	if(gfx_self && gfx_self->jobs == jobs) {
+		if(!gfx_deque_push(gfx_self, job)) {
+			atomic_fetch_sub(&jobs->queued, 1);
+			gfx_job_run(jobs, job);
+			return;
+		}
+	} else {
+		gfx_lock_take(&jobs->lock);
+		vpush(jobs->inbox, job);
+		atomic_fetch_add(&jobs->inboxed, 1);
+		gfx_lock_give(&jobs->lock);
+	}
+
+	if(atomic_load(&jobs->sleeping) || atomic_load(&jobs->waiting)) {
+		gfx_lock_take(&jobs->lock);
+		gfx_cond_wake_one(&jobs->wake);
+		if(atomic_load(&jobs->waiting)) gfx_cond_wake(&jobs->done);
+		gfx_lock_give(&jobs->lock);
+	}
+}
+
+// Pool threads run other jobs while they wait, so jobs waiting on jobs can't use up the pool. Other threads sleep.
+static void gfx_job_join(gfx_jobs* jobs, gfx_job* job) {
+	while(!atomic_load(&job->done)) {
+		gfx_job* other = gfx_self ? gfx_job_find(jobs) : NULL;
+		if(other) {
+			gfx_job_run(jobs, other);
+			continue;
+		}
+		gfx_lock_take(&jobs->lock);
+		atomic_fetch_add(&jobs->waiting, 1);
+		while(!atomic_load(&job->done) && !(gfx_self && atomic_load(&jobs->queued) > 0)) gfx_cond_wait(&jobs->done, &jobs->lock);
+		atomic_fetch_sub(&jobs->waiting, 1);
+		gfx_lock_give(&jobs->lock);
+	}
+}
+
+static GFX_THREAD_FUNC(gfx_worker_main, arg) {
+	gfx_self = arg;
+	gfx_jobs* jobs = gfx_self->jobs;
+	while(true) {
+		gfx_job* job = gfx_job_find(jobs);
+		if(job) {
+			gfx_job_run(jobs, job);
+			continue;
+		}
+
+		// Nothing to do, so it sleeps instead of spinning until something gets pushed or the pool gets freed
+		gfx_lock_take(&jobs->lock);
+		atomic_fetch_add(&jobs->sleeping, 1);
+		while(atomic_load(&jobs->queued) <= 0 && !jobs->quit) gfx_cond_wait(&jobs->wake, &jobs->lock);
+		atomic_fetch_sub(&jobs->sleeping, 1);
+		bool quit = jobs->quit && atomic_load(&jobs->queued) <= 0;
+		gfx_lock_give(&jobs->lock);
+		if(quit) break;
+	}
+	return 0;
+}
+
+// Makes a pool with a thread per core besides the one calling, or GFX_JOB_THREADS of them. Always at least one, so
+// threads outside the pool can sleep while they wait.
+static gfx_jobs* gfx_jobs_new() {
+	u32 n = GFX_JOB_THREADS ? GFX_JOB_THREADS : gfx_cpu_count() - 1;
+	n = max(1, min(n, GFX_JOB_THREADS_MAX));
+	gfx_jobs* jobs = GFX_CALLOC(1, sizeof(gfx_jobs));
+	jobs->workers = GFX_CALLOC(n, sizeof(gfx_worker));
+	jobs->n = n;
+	jobs->inbox = vnew();
+	gfx_lock_init(&jobs->lock);
+	gfx_cond_init(&jobs->wake);
+	gfx_cond_init(&jobs->done);
+	for(u32 i = 0; i < n; i ++) {
+		jobs->workers[i].jobs = jobs;
+		jobs->workers[i].index = i;
+		gfx_thread_start(&jobs->workers[i].thread, gfx_worker_main, jobs->workers + i);
+	}
+	info("Started %d job threads", n);
+	return jobs;
+}
+
+// Wakes the pool's threads up to exit and waits for them. Every job has to have been waited on already.
+static void gfx_jobs_free(gfx_jobs* jobs) {
+	gfx_lock_take(&jobs->lock);
+	jobs->quit = true;
+	gfx_cond_wake(&jobs->wake);
+	gfx_lock_give(&jobs->lock);
+	for(u32 i = 0; i < jobs->n; i ++) gfx_thread_join(jobs->workers[i].thread);
+
+	gfx_lock_free(&jobs->lock);
+	gfx_cond_free(&jobs->wake);
+	gfx_cond_free(&jobs->done);
+	vfree(jobs->inbox);
+	GFX_FREE(jobs->workers);
+	GFX_FREE(jobs);
+	info("Stopped the job threads");
+}
+
+static inline gfx_jobs* gfx_current_jobs() { return gfx_self ? gfx_self->jobs : ctx->jobs; }
+
+gfx_jobs* gfx_get_jobs() { return ctx->jobs; }
+
+gfx_job* gfx_job_submit(void (*fn)(void* arg), void* arg) {
+	gfx_job* job = GFX_MALLOC(sizeof(gfx_job));
+	job->fn = fn;
+	job->arg = arg;
+	atomic_init(&job->done, false);
+	gfx_job_push(gfx_current_jobs(), job);
+	return job;
+}
+
+void gfx_job_wait(gfx_job* job) {
+	gfx_job_join(gfx_current_jobs(), job);
+	GFX_FREE(job);
+}
+
+// A parallel for's helper jobs all take grain sized pieces until there are none left.
+struct gfx_for {
+	void (*fn)(void* arg, u32 from, u32 to);
+	void* arg;
+	u32 n, grain;
+	_Atomic u32 next;
+};
+
+static void gfx_for_run(void* arg) {
+	struct gfx_for* f = arg;
+	for(u32 from; (from = atomic_fetch_add(&f->next, f->grain)) < f->n;)
+		f->fn(f->arg, from, f->n - from > f->grain ? from + f->grain : f->n);
+}
+
+void gfx_parallel_for(u32 n, u32 grain, void (*fn)(void* arg, u32 from, u32 to), void* arg) {
+	if(!n) return;
+	if(!grain) grain = 1;
+	gfx_jobs* jobs = gfx_current_jobs();
+	struct gfx_for f = { .fn = fn, .arg = arg, .n = n, .grain = grain };
+
+	// The calling thread takes pieces too, so helpers only go out for the pieces past its first
+	u32 helpers = min((n - 1) / grain, jobs->n);
+	gfx_job helper[GFX_JOB_THREADS_MAX];
+	for(u32 i = 0; i < helpers; i ++) {
+		helper[i].fn = gfx_for_run;
+		helper[i].arg = &f;
+		atomic_init(&helper[i].done, false);
+		gfx_job_push(jobs, helper + i);
 	}
+	gfx_for_run(&f);
+	for(u32 i = 0; i < helpers; i ++) gfx_job_join(jobs, helper + i);
 }
 
 // --------------------------------------- Setup Functions --------------------------------------- //
@@ -1007,13 +2007,64 @@ char const *const default_fonts[] = {
 #endif
 };
 
-FT_Library ft = NULL;
+static bool gfx_glfw_up = false;                // Set by the first gfx_init()
+static _Thread_local bool gfx_polls = false;     // The thread that called it first, which GLFW only lets poll events
+static _Thread_local struct gfx_share* gfx_held; // Share group whose lock the thread has
+
+static void gfx_upload_atlases();
+static inline gfx_texture* gfx_tex(gfx_tex_id tex_id);
+
+// Lets go of the share group's lock. Other contexts in the group only see what this one changed in textures once it's
+// flushed, and they don't have its GL context to upload its atlas additions with, so it does both first.
+static void gfx_share_leave() {
+	struct gfx_share* s = gfx_held;
+	if(!s) return;
+	if(ctx && ctx->share == s) {
+		if(s->contexts > 1 && !ctx->render.on) {
+			gfx_upload_atlases();
+			glFlush();
+		}
+		ctx->uploads = s->uploads;
+	}
+	gfx_held = NULL;
+	gfx_lock_give(&s->lock);
+}
 
+// Takes the lock of ctx's share group, for a thread that's about to use ctx with its GL context current. GL only
+// promises that a context sees another's changes to a texture once it binds it again, so if anything got uploaded
+// since this context last had the lock, everything in its slots gets bound again.
+static void gfx_share_enter() {
+	struct gfx_share* s = ctx->share;
+	if(gfx_held == s) return;
+	gfx_lock_take(&s->lock);
+	gfx_held = s;
+	if(ctx->uploads == s->uploads || ctx->render.on) return;
+	ctx->uploads = s->uploads;
+	for(u32 i = 0; i < GFX_TEX_SLOTS; i ++) {
+		if(!ctx->gl.slots[i]) continue;
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, gfx_tex(ctx->gl.slots[i] - 1)->id);
+	}
+	if(ctx->gl.slot_bound) glActiveTexture(GL_TEXTURE0 + ctx->gl.slot_bound - 1);
+}
 
+// Contexts that share can each be used from their own thread, but a thread has to let go of one with gfx_ctx_set(NULL)
+// before another thread can set it.
 void gfx_ctx_set(struct gfx_ctx* c) {
+	gfx_share_leave();
 	ctx = c;
+	if(!c) {
+		glfwMakeContextCurrent(NULL);
+		return;
+	}
+	if(c->render.on) { // Its render thread has the GL context, with all of this already bound
+		gfx_share_enter();
+		return;
+	}
+	glfwMakeContextCurrent(c->window);
+	gfx_share_enter();
 	glBindVertexArray(c->gl.varrid);
-	glUseProgram(c->gl.progid);
+	glUseProgram(c->share->progid);
 }
 
 // Toggling Fullscreen:
@@ -1030,19 +2081,52 @@ static gfx_settings default_settings = {
 	.fps_recalc_delta = 0.1f,
 };
 
+// Undoes what a gfx_init that failed got done. GLFW only gets terminated and the share group only freed by the call that
+// started them, so a window failing to join a group leaves the windows already in it alone.
+static struct gfx_ctx* gfx_init_abort(struct gfx_ctx* old_ctx, GLFWwindow* window, bool started_glfw) {
+	struct gfx_share* share = ctx->share;
+	gfx_held = NULL;
+	gfx_lock_give(&share->lock);
+	if(!share->contexts) {
+		gfx_lock_free(&share->lock);
+		GFX_FREE(share);
+	}
+	if(window) glfwDestroyWindow(window);
+	GFX_FREE(ctx);
+	ctx = NULL;
+	if(started_glfw) {
+		glfwTerminate();
+		gfx_glfw_up = gfx_polls = false;
+	}
+	else gfx_ctx_set(old_ctx);
+	return NULL;
+}
+
 struct gfx_ctx* gfx_init(const char* title, gfx_settings* settings) {
 	GLFWwindow* window;
 	DEBUG_MODE(glfwSetErrorCallback(glfwErrorHandler))
 	CHECK_CALL(!glfwInit(), return NULL, "Couldn't initialize glfw3.");
+	bool started_glfw = !gfx_glfw_up;
+	if(started_glfw) gfx_glfw_up = gfx_polls = true;
 
 	if(!title || !title[0]) title = "2DGFX No Title Provided";
 	if(!settings) settings = &default_settings;
 	if(!settings->app_name || !settings->app_name[0]) settings->app_name = title;
+	CHECK_CALL(settings->share && settings->share->render.on, return NULL, "Can't share with a context while it has a render thread.");
 
 	struct gfx_ctx* old_ctx = ctx;
+	gfx_share_leave(); // The new context is the current one from here on
 	ctx = GFX_CALLOC(1, sizeof(struct gfx_ctx));
 	memcpy(&ctx->settings, settings, sizeof(gfx_settings));
 
+	// The group's lock is taken before the window is made, so nothing uses what it shares while its context joins
+	if(settings->share) ctx->share = settings->share->share;
+	else {
+		ctx->share = GFX_CALLOC(1, sizeof(struct gfx_share));
+		gfx_lock_init(&ctx->share->lock);
+	}
+	gfx_share_enter();
+
 	int width = settings->width, height = settings->height, pos_x = INT_MAX, pos_y = INT_MAX;
 	if(!settings->dont_store_settings) {
 		u32 len = sizeof(u32);
@@ -1073,9 +2157,10 @@ struct gfx_ctx* gfx_init(const char* title, gfx_settings* settings) {
 
 
 	// Create a windowed mode window and its OpenGL context
-	CHECK_CALL(!(window = glfwCreateWindow(width, height, title, NULL, NULL)),
-		glfwTerminate(); free(ctx); ctx = old_ctx; return NULL, "Couldn't initialize GLFW window.");
+	CHECK_CALL(!(window = glfwCreateWindow(width, height, title, NULL, settings->share ? settings->share->window : NULL)),
+		return gfx_init_abort(old_ctx, NULL, started_glfw), "Couldn't initialize GLFW window.");
 	glfwMakeContextCurrent(window);
+	glfwSetWindowUserPointer(window, ctx);
 
 	// GLFW input callbacks
 	glfwSetMouseButtonCallback(window, gfx_mousebuttoncallback);
@@ -1089,7 +2174,7 @@ struct gfx_ctx* gfx_init(const char* title, gfx_settings* settings) {
 	// glfwSwapInterval(1);
 
 	GLenum err;
-	CHECK_CALL((err = glewInit()), glfwTerminate(); free(ctx); ctx = old_ctx; return NULL, "GLEW initialization failed: %s", glewGetErrorString(err));
+	CHECK_CALL((err = glewInit()), return gfx_init_abort(old_ctx, window, started_glfw), "GLEW initialization failed: %s", glewGetErrorString(err));
 
 	PROFILER_GPU_INIT()
 
@@ -1104,14 +2189,28 @@ struct gfx_ctx* gfx_init(const char* title, gfx_settings* settings) {
 	// glEnable(GL_DEPTH_TEST);
 
 	// Fills application context struct
-	ctx->gl.progid = gfx_shaderprog(default_shaders.vert, default_shaders.frag);
-	glGenVertexArrays(1, &ctx->gl.varrid);
+	struct gfx_share* share = ctx->share;
+	if(!share->contexts) {
+		share->progid = gfx_shaderprog(default_shaders.vert, default_shaders.frag);
+		share->tex_ids = vnew();
+		share->atlases = vnew();
+		share->fonts = vnew();
+		share->curves = vnew();
+		gfx_rwlock_init(&share->fonts_lock);
+	}
+	share->contexts ++;
+	glGenVertexArrays(1, &ctx->gl.varrid); // Vertex arrays and buffers aren't shared
 	ctx->textures = vnew();
-	ctx->atlases = vnew();
-	ctx->font.store = vnew();
+	ctx->font.slots = vnew();
+	cvec_init(&ctx->lists.queue, sizeof(gfx_drawlist*), 256);
+	ctx->jobs = settings->jobs ? settings->jobs : settings->share ? settings->share->jobs : gfx_jobs_new();
+	atomic_fetch_add(&ctx->jobs->users, 1);
+	ctx->raster = GFX_CALLOC(ctx->jobs->n, sizeof(gfx_raster_thread));
 	ctx->gl.drawbuf.shp = vnew();
 	ctx->gl.drawbuf.idx = vnew();
+	ctx->gl.outlines.glyphs = vnew();
 	ctx->font.size = 48;
+	ctx->font.lh = 1;
 	ctx->window = window;
 
 	// for(int i = 0; i < sizeof(ctx->gl.slots) / sizeof(ctx->gl.slots[0]); i ++)
@@ -1128,7 +2227,12 @@ struct gfx_ctx* gfx_init(const char* title, gfx_settings* settings) {
 
 void gfx_setting_set(enum gfx_setting_name setting, void *const value) {
 	switch(setting) {
-		case GFX_SETTING_VSYNC: glfwSwapInterval(ctx->settings.vsync = *(bool*)value); break;
+		case GFX_SETTING_VSYNC:
+			ctx->settings.vsync = *(bool*)value;
+			if(ctx->render.on) gfx_record(.op = GFX_OP_VSYNC, .flag = ctx->settings.vsync);
+			else glfwSwapInterval(ctx->settings.vsync);
+			break;
+		case GFX_SETTING_RENDER_THREAD: ctx->settings.render_thread = *(bool*)value; break; // Takes effect in gfx_frame()
 		case GFX_SETTING_NO_RESIZE: glfwSetWindowAttrib(ctx->window, GLFW_RESIZABLE, ctx->settings.no_resize = *(bool*)value); break;
 		case GFX_SETTING_NO_DECORATIONS: glfwSetWindowAttrib(ctx->window, GLFW_DECORATED, ctx->settings.no_decorations = *(bool*)value); break;
 		case GFX_SETTING_TRANSPARENT: glfwSetWindowAttrib(ctx->window, GLFW_TRANSPARENT_FRAMEBUFFER, ctx->settings.transparent = *(bool*)value); break;
@@ -1143,25 +2247,77 @@ void gfx_setting_set(enum gfx_setting_name setting, void *const value) {
 
 
 static void draw();
+static void gfx_render_handoff();
+static void gfx_render_start();
+static void gfx_render_stop();
+static void gfx_shaped_evict();
+static void gfx_layouts_evict();
+static void gfx_drawlists_merge();
+static void gfx_gpu_timer_begin();
+static f32 gfx_gpu_timer_end();
+static void gfx_stats_record();
 bool gfx_frame() {
 	PROFILER_ZONE_START
 	if(ctx->frame.count > 0) {
-		draw();
-		PROFILER_GPU_ZONE_START("swapbuffers")
-		glfwSwapBuffers(ctx->window);
-		PROFILER_GPU_ZONE_END()
-		if(ctx->frame.count % 50 == 0)
-			PROFILER_GPU_QUERIES_COLLECT()
-		glfwPollEvents();
+		gfx_drawlists_merge();
+		ctx->frame.counts.flushes = ctx->frame.counts.draw_calls; // Every draw call so far came before the frame's own
+		if(ctx->render.on) {
+			ctx->frame.built = glfwGetTime();
+			gfx_render_handoff();
+		}
+		else {
+			draw();
+			ctx->stats.gpu_ms = gfx_gpu_timer_end();
+			ctx->frame.built = glfwGetTime();
+
+			// Other contexts in the share group get to build their frames while this one waits on the swap
+			gfx_share_leave();
+			PROFILER_GPU_ZONE_START("swapbuffers")
+			glfwSwapBuffers(ctx->window);
+			PROFILER_GPU_ZONE_END()
+			if(ctx->frame.count % 50 == 0) {
+				PROFILER_GPU_QUERIES_COLLECT()
+			}
+			gfx_share_enter();
+		}
+		if(gfx_polls) glfwPollEvents();
 	}
 	PROFILER_FRAME_MARK
-	PROFILER_GPU_ZONE_START("GLClear")
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	PROFILER_GPU_ZONE_END()
+
+	u64 resized = atomic_exchange(&ctx->resized, 0);
+	if(resized) {
+		u32 width = resized >> 32 & INT32_MAX, height = (u32) resized;
+		if(!ctx->render.on) glViewport(0, 0, width, height); // Otherwise the render thread does it when it gets the resize
+		gfx_updatescreencoords(width, height);
+	}
+
+	// The render thread starts and stops between frames, when nothing is half recorded. It stops when the window closes,
+	// so the GL context is back on this thread for whatever comes after. Contexts that share don't get one, they each
+	// need their GL context on the thread that has the group's lock.
+	bool threaded = ctx->settings.render_thread && ctx->share->contexts == 1 && !glfwWindowShouldClose(ctx->window);
+	if(threaded && !ctx->render.on) gfx_render_start();
+	else if(!threaded && ctx->render.on) gfx_render_stop();
+
+	// The render thread clears before it draws each frame
+	if(!ctx->render.on) {
+		PROFILER_GPU_ZONE_START("GLClear")
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		PROFILER_GPU_ZONE_END()
+		gfx_gpu_timer_begin();
+	}
+	if(ctx->frame.count > 0) ctx->stats.cpu_ms = (ctx->frame.built - ctx->frame.start) * 1000;
 	ctx->frame.count ++;
+	ctx->stats.frame_allocs = ctx->frame.arena.allocs;
+	ctx->stats.frame_arena_bytes = gfx_arena_used(&ctx->frame.arena);
+	ctx->stats.frame_heap_allocs = ctx->frame.heap_allocs;
+	ctx->frame.heap_allocs = 0;
+	gfx_arena_reset(&ctx->frame.arena);
+	if(ctx->frame.count % GFX_SHAPED_MAX_AGE == 0) gfx_shaped_evict();
+	if(ctx->frame.count % GFX_LAYOUT_MAX_AGE == 0) gfx_layouts_evict();
 	ctx->frame.start = glfwGetTime();
 	ctx->frame.delta = ctx->frame.start - ctx->frame.last;
 	ctx->frame.last  = ctx->frame.start;
+	if(ctx->frame.count > 1) gfx_stats_record();
 
 	PROFILER_ZONE_END
 	if (glfwWindowShouldClose(ctx->window)) {
@@ -1175,6 +2331,129 @@ void gfx_quit() {
 	glfwSetWindowShouldClose(ctx->window, 1);
 }
 
+// Frees everything the share group's last context leaves behind, with that context's GL context still current.
+static void gfx_share_free(struct gfx_share* s) {
+	for(u32 i = 0; i < vlen(s->fonts); i ++) {
+		gfx_typeface* face = s->fonts + i;
+		hdestroy(gfx_char, face->chars);
+		for(ht_int_t j = 0; j < face->shaped.n_buckets; j ++)
+			if(hexist(face->shaped, j)) vfree(hval(face->shaped, j).glyphs);
+		hdestroy(gfx_shaped, face->shaped);
+		if(face->chains) {
+			for(u32 j = 0; j < vlen(face->chains); j ++) LBT_destroy_chain(face->chains[j].chain);
+			vfree(face->chains);
+		}
+		if(face->lbt) LBT_destroy(face->lbt);
+		hdestroy(gfx_kern, face->kern);
+		if(face->kern_left) vfree(face->kern_left);
+		if(face->kernings) {
+			for(u32 j = 0; j < vlen(face->kernings); j ++) hdestroy(gfx_kern, face->kernings[j].pairs);
+			vfree(face->kernings);
+		}
+		if(face->metrics) {
+			for(u32 j = 0; j < vlen(face->metrics); j ++) hdestroy(gfx_adv, face->metrics[j].glyphs);
+			vfree(face->metrics);
+		}
+		for(u32 j = 0; j < GFX_LOW_TABLES; j ++) GFX_FREE(face->low[j].chars);
+		GFX_FREE(face->low_glyphs);
+		GFX_FREE(face->cover_pages);
+		if(face->cover_bits) vfree(face->cover_bits);
+		if(face->fallbacks) vfree(face->fallbacks);
+		hdestroy(gfx_outline, face->outlines);
+		FT_Done_Face(face->face);
+		GFX_FREE(face->data);
+		GFX_FREE((char*) face->name);
+	}
+	if(s->fonts) vfree(s->fonts);
+
+	for(u32 i = 0; i < vlen(s->atlases); i ++) {
+		GFX_FREE(s->atlases[i].buf);
+		vfree(s->atlases[i].added);
+		vfree(s->atlases[i].tree);
+	}
+	if(s->atlases) vfree(s->atlases);
+	if(s->images) vfree(s->images);
+	if(s->tex_ids) {
+		glDeleteTextures(vlen(s->tex_ids), s->tex_ids);
+		vfree(s->tex_ids);
+	}
+	if(s->curves) vfree(s->curves);
+	glDeleteProgram(s->progid);
+	if(s->ft) FT_Done_FreeType(s->ft);
+	gfx_rwlock_free(&s->fonts_lock);
+	gfx_lock_free(&s->lock);
+	GFX_FREE(s);
+}
+
+// Closes the context's window and frees everything it has, its text slots included. Draw lists recorded for it have to
+// be freed before it. The job pool and the share group go with the last context that uses them.
+void gfx_ctx_free(struct gfx_ctx* c) {
+	if(!c) return;
+	gfx_ctx_set(c);
+	if(ctx->render.on) gfx_render_stop();
+	struct gfx_share* share = ctx->share;
+
+	for(u32 i = 0; i < vlen(ctx->font.slots); i ++) gfx_textslot_free(i);
+	vfree(ctx->font.slots);
+	for(ht_int_t i = 0; i < ctx->font.layouts.n_buckets; i ++) {
+		if(!hexist(ctx->font.layouts, i)) continue;
+		vfree(hval(ctx->font.layouts, i).text);
+		vfree(hval(ctx->font.layouts, i).lines);
+	}
+	hdestroy(gfx_layout, ctx->font.layouts);
+	raster_free(&ctx->font.canvas);
+
+	// Pool threads only touch their state during a job, and every job is done by now
+	for(u32 i = 0; i < ctx->jobs->n; i ++) {
+		gfx_raster_thread* thread = ctx->raster + i;
+		if(thread->faces) {
+			for(u32 j = 0; j < vlen(thread->faces); j ++) if(thread->faces[j]) FT_Done_Face(thread->faces[j]);
+			vfree(thread->faces);
+		}
+		if(thread->lib) FT_Done_FreeType(thread->lib);
+		raster_free(&thread->canvas);
+	}
+	GFX_FREE(ctx->raster);
+	if(atomic_fetch_sub(&ctx->jobs->users, 1) == 1) gfx_jobs_free(ctx->jobs);
+
+	// GL objects that aren't shared go with the window, the rest have to be deleted
+	typeof(ctx->gl.outlines)* o = &ctx->gl.outlines;
+	glDeleteBuffers(1, &ctx->gl.vbufid);
+	glDeleteBuffers(1, &ctx->gl.idxbufid);
+	glDeleteBuffers(1, &o->curve_buf);
+	glDeleteBuffers(1, &o->glyph_buf);
+	glDeleteTextures(1, &o->curve_tex);
+	glDeleteTextures(1, &o->glyph_tex);
+	vfree(o->glyphs);
+	vfree(ctx->textures);
+	vfree(ctx->gl.drawbuf.shp);
+	vfree(ctx->gl.drawbuf.idx);
+	hdestroy(gfx_uni, ctx->gl.uniforms);
+	cvec_free(&ctx->lists.queue);
+	gfx_arena_destroy(&ctx->frame.arena);
+#ifdef _WIN32
+	if(ctx->key) RegCloseKey(ctx->key);
+#endif
+
+	// Nothing else can be using the share group once its last context is gone. Otherwise what this context added to the
+	// atlases goes up first, like it does whenever it lets go of the group.
+	if(share->contexts == 1) {
+		gfx_held = NULL;
+		gfx_lock_give(&share->lock);
+		gfx_share_free(share);
+	}
+	else {
+		gfx_upload_atlases();
+		glFlush();
+		share->contexts --;
+		gfx_share_leave();
+	}
+	glfwMakeContextCurrent(NULL);
+	glfwDestroyWindow(ctx->window);
+	GFX_FREE(ctx);
+	ctx = NULL;
+}
+
 bool gfx_fps_changed() {
 	return ctx->frame.start - ctx->frame.lastfpscalc >= ctx->settings.fps_recalc_delta;
 }
@@ -1189,14 +2468,136 @@ double gfx_fps() {
 	return ctx->frame.lastfpsnum;
 }
 
-void gfx_default_fps_counter() {
-	static char fps[24] = {0};
-	const u32 oldfontsize = ctx->font.size;
-	if(gfx_fps_changed())
-		snprintf(fps, 23, "%.2f fps", gfx_fps());
-	font_size(20);
-	text(fps, ctx->width - 150, ctx->height - 10);
-	font_size(oldfontsize);
+gfx_stats gfx_get_stats() {
+	gfx_stats stats = ctx->stats;
+	stats.atlases = vlen(ctx->share->atlases);
+	stats.atlas_bytes = 0;
+	u64 used = 0, area = 0;
+	for(u32 i = 0; i < vlen(ctx->share->atlases); i ++) {
+		gfx_atlas* atlas = ctx->share->atlases + i;
+		stats.atlas_bytes += (u64) GFX_ATLAS_START_SIZE * atlas->growth_factor * GFX_ATLAS_W(atlas);
+		used += atlas->used;
+		area += (u64) GFX_ATLAS_START_SIZE * atlas->growth_factor * GFX_ATLAS_START_SIZE * atlas->growth_factor;
+	}
+	stats.atlas_occupancy = area ? (f32) used / area : 0;
+	stats.glyphs = 0;
+	for(u32 i = 0; i < vlen(ctx->share->fonts); i ++) stats.glyphs += ctx->share->fonts[i].chars.size;
+	return stats;
+}
+
+// Fills in the counters of the frame that just ended and keeps its stats in the history
+static void gfx_stats_record() {
+	typeof(ctx->frame.counts)* counts = &ctx->frame.counts;
+	gfx_stats* stats = &ctx->stats;
+	stats->frame_ms = ctx->frame.delta * 1000;
+	stats->draw_calls = counts->draw_calls;
+	stats->flushes = counts->flushes;
+	stats->vertices = counts->vertices;
+	stats->indices = counts->indices;
+	stats->upload_bytes = counts->upload_bytes;
+	stats->frame_glyph_loads = stats->glyph_loads - ctx->frame.glyph_loads;
+	ctx->frame.glyph_loads = stats->glyph_loads;
+	*counts = (typeof(*counts)) {0};
+	ctx->history[ctx->frame.recorded ++ % GFX_STATS_HISTORY] = gfx_get_stats();
+}
+
+const gfx_stats* gfx_get_frame_stats(u32 ago) {
+	if(ago >= min(ctx->frame.recorded, GFX_STATS_HISTORY)) return NULL;
+	return ctx->history + (ctx->frame.recorded - 1 - ago) % GFX_STATS_HISTORY;
+}
+
+static int gfx_f32_cmp(const void* a, const void* b) {
+	return (*(const f32*) a > *(const f32*) b) - (*(const f32*) a < *(const f32*) b);
+}
+
+// Sorts the times to pick them out
+static gfx_percentiles gfx_percentiles_of(f32* times, u32 n) {
+	if(!n) return (gfx_percentiles) {0};
+	qsort(times, n, sizeof(f32), gfx_f32_cmp);
+	return (gfx_percentiles) { times[(n - 1) * 50 / 100], times[(n - 1) * 95 / 100], times[(n - 1) * 99 / 100], times[n - 1] };
+}
+
+gfx_frame_history gfx_get_frame_history() {
+	u32 n = min(ctx->frame.recorded, GFX_STATS_HISTORY);
+	f32 frame[GFX_STATS_HISTORY], cpu[GFX_STATS_HISTORY], gpu[GFX_STATS_HISTORY];
+	for(u32 i = 0; i < n; i ++) {
+		frame[i] = ctx->history[i].frame_ms;
+		cpu[i] = ctx->history[i].cpu_ms;
+		gpu[i] = ctx->history[i].gpu_ms;
+	}
+	return (gfx_frame_history) {
+		.frames = n,
+		.frame_ms = gfx_percentiles_of(frame, n),
+		.cpu_ms = gfx_percentiles_of(cpu, n),
+		.gpu_ms = gfx_percentiles_of(gpu, n)
+	};
+}
+
+u32 gfx_frame_vertices(u32 first, gfx_vertex* out, u32 max) {
+	u32 n = vlen(ctx->gl.drawbuf.shp);
+	if(first >= n) return 0;
+	for(u32 i = 0; i < n - first && i < max; i ++) {
+		struct gfx_vtx_buf* v = ctx->gl.drawbuf.shp + first + i;
+		out[i] = (gfx_vertex) { .x = v->x, .y = v->y, .type = v->type, .data = v->col.full };
+	}
+	return n - first;
+}
+
+static void gfx_text(const char* str, u32 len, short x, short y);
+static u32 gfx_write_f64(char* buf, f64 v, u32 precision);
+
+#define GFX_GRAPH_H 60       // Pixels
+#define GFX_GRAPH_MS 33.333f // Frame time at the top of the graph, anything longer gets cut off
+#define GFX_GRAPH_BAR(ms) ((short) (min((ms), GFX_GRAPH_MS) * GFX_GRAPH_H / GFX_GRAPH_MS))
+
+// A bar per frame in the history, newest on the right. The whole bar is the frame's time, green under 60 fps worth,
+// yellow under 30 and red over, and its darker bottom part is the CPU's share. The line is 60 fps.
+void gfx_default_fps_counter() {
+	typeof(ctx->counter)* c = &ctx->counter;
+	const u32 oldfontsize = ctx->font.size;
+	const gfx_color oldcol = ctx->curcol;
+	if(gfx_fps_changed()) {
+		c->len = gfx_write_f64(c->fps, gfx_fps(), 2);
+		memcpy(c->fps + c->len, " fps", 4);
+		c->len += 4;
+
+		gfx_percentiles p = gfx_get_frame_history().frame_ms;
+		const char* labels[] = { "p50 ", "  p95 ", "  p99 " };
+		f32 values[] = { p.p50, p.p95, p.p99 };
+		c->spread_len = 0;
+		for(u32 i = 0; i < 3; i ++) {
+			memcpy(c->spread + c->spread_len, labels[i], strlen(labels[i]));
+			c->spread_len += strlen(labels[i]);
+			c->spread_len += gfx_write_f64(c->spread + c->spread_len, values[i], 1);
+		}
+		memcpy(c->spread + c->spread_len, " ms", 3);
+		c->spread_len += 3;
+	}
+
+	short x = ctx->width - GFX_STATS_HISTORY - 10, y = ctx->height - 40 - GFX_GRAPH_H;
+	fill(0, 0, 0, 160);
+	rect(x, y, GFX_STATS_HISTORY, GFX_GRAPH_H);
+	u32 n = min(ctx->frame.recorded, GFX_STATS_HISTORY);
+	for(u32 i = 0; i < n; i ++) {
+		const gfx_stats* s = gfx_get_frame_stats(n - 1 - i);
+		short bar = GFX_GRAPH_BAR(s->frame_ms), cpu = min(GFX_GRAPH_BAR(s->cpu_ms), bar), at = x + GFX_STATS_HISTORY - n + i;
+		u8 r = s->frame_ms > 16.7f ? 230 : 80, g = s->frame_ms > 33.4f ? 60 : 200;
+		fill(r, g, 80, 255);
+		rect(at, y + GFX_GRAPH_H - bar, 1, bar - cpu);
+		fill(r / 2, g / 2, 40, 255);
+		rect(at, y + GFX_GRAPH_H - cpu, 1, cpu);
+	}
+	fill(255, 255, 255, 90);
+	rect(x, y + GFX_GRAPH_H - GFX_GRAPH_BAR(16.667f), GFX_STATS_HISTORY, 1);
+	ctx->curcol = oldcol;
+
+	if(vlen(ctx->share->fonts)) {
+		font_size(14);
+		gfx_text(c->spread, c->spread_len, x, y - 6);
+		font_size(20);
+		gfx_text(c->fps, c->len, ctx->width - 150, ctx->height - 10);
+	}
+	font_size(oldfontsize);
 }
 
 
@@ -1237,40 +2638,119 @@ static inline void gfx_draw_setup() {
 		// { GL_UNSIGNED_SHORT, 2, true,  false }, // Texture X, Texture Y
 		{ GL_UNSIGNED_BYTE,  4, false, true }  // Color (RGBA)
 	});
-	gfx_usetiv("u_tex", (int[]) { 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31 }, 32);
+	// The last two units hold buffer textures, and samplers of different types can't share a unit
+	gfx_usetiv("u_tex", (int[]) { 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,0,0 }, 32);
+	gfx_useti("u_glyphs", GFX_OUTLINE_GLYPHS_SLOT);
+	gfx_useti("u_curves", GFX_OUTLINE_SLOT);
 }
 
-static void gfx_update_atlas(gfx_atlas* atlas);
-static inline void gfx_make_tex_active(gfx_tex_id tex_id);
-static inline void draw() {
-	u32 slen = vlen(ctx->gl.drawbuf.shp);
-	u32 ilen = vlen(ctx->gl.drawbuf.idx);
-	if(!slen) return;
+// Uploads the curves of outline glyphs that are new since the last draw, and where this draw's outline glyphs go. The
+// active texture slot gets set back to bound after.
+static void gfx_upload_outlines(const f32* curves, const f32* glyphs, gfx_slot_hnd bound) {
 	PROFILER_ZONE_START
-	PROFILER_GPU_ZONE_START("draw")
+	typeof(ctx->gl.outlines)* o = &ctx->gl.outlines;
+	if(!o->curve_buf) {
+		glGenBuffers(1, &o->curve_buf);
+		glGenBuffers(1, &o->glyph_buf);
+		glGenTextures(1, &o->curve_tex);
+		glGenTextures(1, &o->glyph_tex);
+
+		// Nothing else ever binds to these units, so the textures stay there
+		glActiveTexture(GL_TEXTURE0 + GFX_OUTLINE_SLOT);
+		glBindTexture(GL_TEXTURE_BUFFER, o->curve_tex);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, o->curve_buf);
+		glActiveTexture(GL_TEXTURE0 + GFX_OUTLINE_GLYPHS_SLOT);
+		glBindTexture(GL_TEXTURE_BUFFER, o->glyph_tex);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, o->glyph_buf);
+		if(bound) glActiveTexture(GL_TEXTURE0 + bound - 1);
+	}
 
-	// Upload all texture atlas updates
-	for(u32 i = 0; i < vlen(ctx->atlases); i ++) {
-		gfx_atlas* atlas = ctx->atlases + i;
-		if(vlen(atlas->added)) {
-			gfx_make_tex_active(atlas->tex_id);
-			gfx_update_atlas(atlas);
-		}
+	// Curves only ever get appended, so usually only the new glyphs go up
+	u32 len = vlen(curves);
+	glBindBuffer(GL_TEXTURE_BUFFER, o->curve_buf);
+	if(len > o->capacity) {
+		o->capacity = max(len, o->capacity * 2);
+		glBufferData(GL_TEXTURE_BUFFER, o->capacity * sizeof(f32), NULL, GL_STATIC_DRAW);
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, len * sizeof(f32), curves);
 	}
+	else if(len > o->uploaded) glBufferSubData(GL_TEXTURE_BUFFER, o->uploaded * sizeof(f32), (len - o->uploaded) * sizeof(f32), curves + o->uploaded);
+	o->uploaded = len;
+
+	glBindBuffer(GL_TEXTURE_BUFFER, o->glyph_buf);
+	glBufferData(GL_TEXTURE_BUFFER, vlen(glyphs) * sizeof(f32), glyphs, GL_STREAM_DRAW);
+	PROFILER_ZONE_END
+}
 
+static void gfx_upload_drawbuf(const struct gfx_vtx_buf* shp, u32 slen, const u32* idx, u32 ilen) {
 	if(!ctx->gl.vbufid) gfx_draw_setup();
 
 	// Vertex buffer upload
 	if(ctx->gl.drawbuf.maxdrawbufsize.w < slen) {
-		glBufferData(GL_ARRAY_BUFFER, slen * sizeof(*ctx->gl.drawbuf.shp), ctx->gl.drawbuf.shp, GL_DYNAMIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, slen * sizeof(*shp), shp, GL_DYNAMIC_DRAW);
 		ctx->gl.drawbuf.maxdrawbufsize.w = slen;
-	} else glBufferSubData(GL_ARRAY_BUFFER, 0, slen * sizeof(*ctx->gl.drawbuf.shp), ctx->gl.drawbuf.shp);
+	} else glBufferSubData(GL_ARRAY_BUFFER, 0, slen * sizeof(*shp), shp);
 
 	// Element array buffer upload
 	if(ctx->gl.drawbuf.maxdrawbufsize.h < ilen) {
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, ilen * sizeof(*ctx->gl.drawbuf.idx), ctx->gl.drawbuf.idx, GL_DYNAMIC_DRAW);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, ilen * sizeof(*idx), idx, GL_DYNAMIC_DRAW);
 		ctx->gl.drawbuf.maxdrawbufsize.h = ilen;
-	} else glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, ilen * sizeof(*ctx->gl.drawbuf.idx), ctx->gl.drawbuf.idx);
+	} else glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, ilen * sizeof(*idx), idx);
+}
+
+static void gfx_update_atlas(gfx_atlas* atlas);
+static inline void gfx_make_tex_active(gfx_tex_id tex_id);
+static inline void gfx_bind_slot(gfx_slot_hnd slot);
+
+// Uploads all texture atlas updates
+static void gfx_upload_atlases() {
+	for(u32 i = 0; i < vlen(ctx->share->atlases); i ++) {
+		gfx_atlas* atlas = ctx->share->atlases + i;
+		if(!vlen(atlas->added)) continue;
+		gfx_texture* tex = gfx_tex(atlas->tex_id);
+		if(tex->slot || ctx->render.on) {
+			gfx_make_tex_active(atlas->tex_id);
+			gfx_update_atlas(atlas);
+			continue;
+		}
+
+		// Another context in the share group filled it and this one hasn't drawn from it, so it's only bound for the upload
+		if(!ctx->gl.slot_bound) gfx_bind_slot(1);
+		gfx_tex_hnd in_slot = ctx->gl.slots[ctx->gl.slot_bound - 1];
+		glBindTexture(GL_TEXTURE_2D, tex->id);
+		gfx_update_atlas(atlas);
+		glBindTexture(GL_TEXTURE_2D, in_slot ? gfx_tex(in_slot - 1)->id : 0);
+	}
+}
+
+static inline void draw() {
+	u32 slen = vlen(ctx->gl.drawbuf.shp);
+	u32 ilen = vlen(ctx->gl.drawbuf.idx);
+	if(!slen || (ctx->render.on && ilen == ctx->render.drawn)) return;
+	PROFILER_ZONE_START
+
+	gfx_upload_atlases();
+	typeof(ctx->frame.counts)* counts = &ctx->frame.counts;
+	counts->draw_calls ++;
+
+	// With a render thread the draw call only gets recorded. The buffers aren't emptied, they go over whole with the
+	// frame, so the indices already point at the right vertices and outline glyphs. They're counted when they go over.
+	if(ctx->render.on) {
+		gfx_record(.op = GFX_OP_DRAW, .x = ctx->render.drawn, .w = ilen - ctx->render.drawn);
+		ctx->render.drawn = ilen;
+		PROFILER_ZONE_END
+		return;
+	}
+
+	u32 glyphs = vlen(ctx->gl.outlines.glyphs), curves = glyphs ? vlen(ctx->share->curves) - ctx->gl.outlines.uploaded : 0;
+	counts->vertices += slen;
+	counts->indices += ilen;
+	counts->upload_bytes += (u64) slen * sizeof(struct gfx_vtx_buf) + ilen * sizeof(u32) + (glyphs + curves) * sizeof(f32);
+
+	PROFILER_GPU_ZONE_START("draw")
+	if(!ctx->gl.vbufid) gfx_draw_setup();
+	if(ctx->share->contexts > 1) gfx_uset2f("u_screen", (vec2) { ctx->width, ctx->height }); // Uniforms live in the shared program
+	if(glyphs) gfx_upload_outlines(ctx->share->curves, ctx->gl.outlines.glyphs, ctx->gl.slot_bound);
+	gfx_upload_drawbuf(ctx->gl.drawbuf.shp, slen, ctx->gl.drawbuf.idx, ilen);
 
 	// Draw call
 	glDrawElements(GL_TRIANGLES, ilen, GL_UNSIGNED_INT, NULL);
@@ -1278,11 +2758,232 @@ static inline void draw() {
 	// Reset draw buffers and Z axis
 	vempty(ctx->gl.drawbuf.shp);
 	vempty(ctx->gl.drawbuf.idx);
+	vempty(ctx->gl.outlines.glyphs);
 	// ctx->gl.drawbuf.idxstart = vlen(ctx->gl.drawbuf.idx);
 	PROFILER_GPU_ZONE_END()
 	PROFILER_ZONE_END
 }
 
+// Times the GPU's work on a frame, from right after it's cleared to right before it's presented. Only ever on the
+// thread with the GL context.
+static void gfx_gpu_timer_begin() {
+	typeof(ctx->gl.timer)* t = &ctx->gl.timer;
+	if(!t->ids[0]) glGenQueries(GFX_GPU_TIMERS, t->ids);
+	if(t->begun - t->read == GFX_GPU_TIMERS) return; // None have come back yet, so this frame goes without
+	glBeginQuery(GL_TIME_ELAPSED, t->ids[t->begun % GFX_GPU_TIMERS]);
+	t->running = true;
+}
+
+// Returns the newest result, reading whatever came back without waiting for the rest
+static f32 gfx_gpu_timer_end() {
+	typeof(ctx->gl.timer)* t = &ctx->gl.timer;
+	if(t->running) {
+		glEndQuery(GL_TIME_ELAPSED);
+		t->running = false;
+		t->begun ++;
+	}
+	for(; t->read != t->begun; t->read ++) {
+		GLuint id = t->ids[t->read % GFX_GPU_TIMERS];
+		GLint ready = 0;
+		glGetQueryObjectiv(id, GL_QUERY_RESULT_AVAILABLE, &ready);
+		if(!ready) break;
+		GLuint64 ns;
+		glGetQueryObjectui64v(id, GL_QUERY_RESULT, &ns);
+		t->last = ns / 1e6;
+	}
+	return t->last;
+}
+
+// ------ Render Thread ------ //
+
+static void gfx_tex_image(const u8* buf, u32 w, u32 h, GLenum format, bool pixellated);
+static void gfx_tex_params(bool pixellated);
+
+// Does everything the frame recorded, in order, then presents it. Only ever runs on the render thread.
+static void gfx_render_packet(gfx_packet* p) {
+	PROFILER_ZONE_START
+	typeof(ctx->render)* r = &ctx->render;
+	p->started = glfwGetTime();
+	PROFILER_GPU_ZONE_START("GLClear")
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	PROFILER_GPU_ZONE_END()
+	gfx_gpu_timer_begin();
+
+	// Every draw call of the frame draws out of the same buffers
+	PROFILER_GPU_ZONE_START("draw")
+	if(!ctx->gl.vbufid) gfx_draw_setup();
+	vpushv(r->outline_curves, p->curves);
+	if(vlen(p->glyphs)) gfx_upload_outlines(r->outline_curves, p->glyphs, r->slot);
+	if(vlen(p->idx)) gfx_upload_drawbuf(p->shp, vlen(p->shp), p->idx, vlen(p->idx));
+
+	for(u32 i = 0; i < vlen(p->cmds); i ++) {
+		struct gfx_render_cmd* cmd = p->cmds + i;
+		switch(cmd->op) {
+			case GFX_OP_SLOT: glActiveTexture(GL_TEXTURE0 + (r->slot = cmd->tex) - 1); break;
+			case GFX_OP_TEX_NEW:
+				while(vlen(r->tex_ids) <= cmd->tex) vpush(r->tex_ids, 0);
+				glGenTextures(1, r->tex_ids + cmd->tex);
+				glBindTexture(GL_TEXTURE_2D, r->tex_ids[cmd->tex]);
+				gfx_tex_params(cmd->flag);
+				break;
+			case GFX_OP_BIND: glBindTexture(GL_TEXTURE_2D, r->tex_ids[cmd->tex]); break;
+			case GFX_OP_UPLOAD: gfx_tex_image(p->data + cmd->data, cmd->w, cmd->h, cmd->format, cmd->flag); break;
+			case GFX_OP_PATCH:
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+				glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+				glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+				glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+				glTexSubImage2D(GL_TEXTURE_2D, 0, cmd->x, cmd->y, cmd->w, cmd->h, cmd->format, GL_UNSIGNED_BYTE, p->data + cmd->data);
+				break;
+			case GFX_OP_DRAW: glDrawElements(GL_TRIANGLES, cmd->w, GL_UNSIGNED_INT, (const void*) ((uintptr_t) cmd->x * sizeof(u32))); break;
+			case GFX_OP_RESIZE:
+				glViewport(0, 0, cmd->w, cmd->h);
+				gfx_uset2f("u_screen", (vec2) { cmd->w, cmd->h });
+				break;
+			case GFX_OP_VSYNC: glfwSwapInterval(cmd->flag); break;
+		}
+	}
+	PROFILER_GPU_ZONE_END()
+	p->gpu = gfx_gpu_timer_end();
+	p->submitted = glfwGetTime();
+
+	PROFILER_GPU_ZONE_START("swapbuffers")
+	glfwSwapBuffers(ctx->window);
+	PROFILER_GPU_ZONE_END()
+	p->presented = glfwGetTime();
+	if(++ r->presented % 50 == 0) {
+		PROFILER_GPU_QUERIES_COLLECT()
+	}
+	PROFILER_ZONE_END
+}
+
+static GFX_THREAD_FUNC(gfx_render_worker, arg) {
+	gfx_render_side = true;
+	ctx = arg; // The program and vertex array are still bound in the GL context, so nothing gets set up again
+	glfwMakeContextCurrent(ctx->window);
+
+	typeof(ctx->render)* r = &ctx->render;
+	for(;;) {
+		gfx_lock_take(&r->lock);
+		while(!r->pending && !r->quit) gfx_cond_wait(&r->cond, &r->lock);
+		gfx_packet* p = r->pending;
+		gfx_lock_give(&r->lock);
+		if(!p) break;
+
+		gfx_render_packet(p);
+
+		gfx_lock_take(&r->lock);
+		r->pending = NULL;
+		gfx_cond_wake(&r->cond);
+		gfx_lock_give(&r->lock);
+	}
+
+	glfwMakeContextCurrent(NULL);
+	return 0;
+}
+
+// Moves the GL context to a new render thread. Only called between frames, when the draw buffers are empty.
+static void gfx_render_start() {
+	typeof(ctx->render)* r = &ctx->render;
+	for(u32 i = 0; i < 2; i ++)
+		r->packets[i] = (gfx_packet) { .shp = vnew(), .idx = vnew(), .glyphs = vnew(), .curves = vnew(), .cmds = vnew(), .data = vnew() };
+	r->recording = r->drawn = 0;
+	r->pending = NULL;
+	r->quit = false;
+
+	// What the render thread keeps of its own starts out as what this thread had
+	r->tex_ids = vnew();
+	vpushv(r->tex_ids, ctx->share->tex_ids);
+	r->outline_curves = vnew();
+	vpushv(r->outline_curves, ctx->share->curves);
+	r->curves = vlen(ctx->share->curves);
+	r->slot = ctx->gl.slot_bound;
+
+	gfx_lock_init(&r->lock);
+	gfx_cond_init(&r->cond);
+	glfwMakeContextCurrent(NULL); // A context can only be current on one thread
+	r->on = true;
+	gfx_thread_start(&r->thread, gfx_render_worker, ctx);
+	info("Started the render thread");
+}
+
+// Waits for the frame the render thread has, and takes the GL context back
+static void gfx_render_stop() {
+	typeof(ctx->render)* r = &ctx->render;
+	gfx_lock_take(&r->lock);
+	r->quit = true;
+	gfx_cond_wake(&r->cond);
+	gfx_lock_give(&r->lock);
+	gfx_thread_join(r->thread);
+	gfx_lock_free(&r->lock);
+	gfx_cond_free(&r->cond);
+	glfwMakeContextCurrent(ctx->window);
+	r->on = false;
+
+	// Textures the render thread made
+	for(u32 i = 0; i < vlen(r->tex_ids); i ++) ctx->share->tex_ids[i] = gfx_tex(i)->id = r->tex_ids[i];
+	vfree(r->tex_ids);
+	vfree(r->outline_curves);
+	for(u32 i = 0; i < 2; i ++) {
+		gfx_packet* p = r->packets + i;
+		vfree(p->shp), vfree(p->idx), vfree(p->glyphs), vfree(p->curves), vfree(p->cmds), vfree(p->data);
+	}
+	info("Stopped the render thread");
+}
+
+// Hands the frame over to the render thread, and takes back the buffers of the frame before the last one to build the
+// next one in. Only waits when the render thread is still on the last frame.
+static void gfx_render_handoff() {
+	PROFILER_ZONE_START
+	typeof(ctx->render)* r = &ctx->render;
+	draw(); // Records the last draw call and the atlas patches that go with it
+	gfx_packet* p = gfx_recording();
+	typeof(ctx->frame.counts)* counts = &ctx->frame.counts;
+	counts->vertices += vlen(ctx->gl.drawbuf.shp);
+	counts->indices += vlen(ctx->gl.drawbuf.idx);
+	counts->upload_bytes += (u64) vlen(ctx->gl.drawbuf.shp) * sizeof(struct gfx_vtx_buf) + vlen(ctx->gl.drawbuf.idx) * sizeof(u32) +
+		(vlen(ctx->gl.outlines.glyphs) + vlen(ctx->share->curves) - r->curves) * sizeof(f32);
+
+	#define GFX_SWAP(a, b) do { typeof(a) tmp = a; a = b; b = tmp; } while(0)
+	GFX_SWAP(p->shp, ctx->gl.drawbuf.shp);
+	GFX_SWAP(p->idx, ctx->gl.drawbuf.idx);
+	GFX_SWAP(p->glyphs, ctx->gl.outlines.glyphs);
+	#undef GFX_SWAP
+	vempty(ctx->gl.drawbuf.shp);
+	vempty(ctx->gl.drawbuf.idx);
+	vempty(ctx->gl.outlines.glyphs);
+	r->drawn = 0;
+
+	// Curves only get appended, so the render thread only needs the new ones
+	u32 curves = vlen(ctx->share->curves);
+	memcpy(vpush_uninit(p->curves, curves - r->curves), ctx->share->curves + r->curves, (curves - r->curves) * sizeof(f32));
+	r->curves = curves;
+
+	double waited = glfwGetTime();
+	gfx_lock_take(&r->lock);
+	while(r->pending) gfx_cond_wait(&r->cond, &r->lock);
+	p->handed = glfwGetTime();
+	r->pending = p;
+	gfx_cond_wake(&r->cond);
+	gfx_lock_give(&r->lock);
+
+	// The other packet is the frame before, which the render thread is done with now
+	gfx_packet* done = r->packets + !r->recording;
+	if(done->presented) {
+		ctx->stats.render_wait = (p->handed - waited) * 1000;
+		ctx->stats.render_submit = (done->submitted - done->started) * 1000;
+		ctx->stats.render_swap = (done->presented - done->submitted) * 1000;
+		ctx->stats.render_latency = (done->presented - done->handed) * 1000;
+		ctx->stats.render_overlap = max(0, min(done->presented, waited) - done->started) * 1000;
+		ctx->stats.gpu_ms = done->gpu;
+	}
+	vempty(done->cmds);
+	vempty(done->data);
+	vempty(done->curves);
+	r->recording = !r->recording;
+	PROFILER_ZONE_END
+}
+
 
 
 void fill(u8 r, u8 g, u8 b, u8 a) {
@@ -1464,59 +3165,91 @@ void background(u8 r, u8 g, u8 b, u8 a) {
  * - 
  */
 
-static inline void gfx_bind_slot(gfx_slot_hnd slot) { if(slot) glActiveTexture(GL_TEXTURE0 + (ctx->gl.slot_bound = slot) - 1); }
+static inline void gfx_bind_slot(gfx_slot_hnd slot) {
+	if(!slot) return;
+	ctx->gl.slot_bound = slot;
+	if(ctx->render.on) gfx_record(.op = GFX_OP_SLOT, .tex = slot);
+	else glActiveTexture(GL_TEXTURE0 + slot - 1);
+}
+// The context's slot for a texture, with the GL id from the share. Textures other contexts in the share group made show
+// up the first time this one uses them.
+static inline gfx_texture* gfx_tex(gfx_tex_id tex_id) {
+	while(vlen(ctx->textures) <= tex_id) vpush(ctx->textures, { .id = ctx->share->tex_ids[vlen(ctx->textures)] });
+	return ctx->textures + tex_id;
+}
 static inline void gfx_bind_tex(gfx_tex_id tex) {
-	if(ctx->textures[tex].slot == ctx->gl.slot_bound) return;
+	if(gfx_tex(tex)->slot == ctx->gl.slot_bound) return;
 
 	if(ctx->gl.slots[ctx->gl.slot_bound - 1])
 		ctx->textures[ctx->gl.slots[ctx->gl.slot_bound - 1] - 1].slot = 0;
 
 	ctx->gl.slots[ctx->gl.slot_bound - 1] = tex + 1;
 	ctx->textures[tex].slot = ctx->gl.slot_bound;
-	glBindTexture(GL_TEXTURE_2D, ctx->textures[tex].id);
+	if(ctx->render.on) gfx_record(.op = GFX_OP_BIND, .tex = tex);
+	else glBindTexture(GL_TEXTURE_2D, ctx->textures[tex].id);
 	info("Bound texture #%d to slot #%d", tex, ctx->textures[tex].slot);
 }
 static inline gfx_slot_hnd gfx_find_empty_slot() {
-	for(int i = 0; i < sizeof(ctx->gl.slots) / sizeof(ctx->gl.slots[0]); i ++)
+	for(int i = 0; i < GFX_TEX_SLOTS; i ++)
 		if(!ctx->gl.slots[i]) return i + 1;
 	return 0;
 }
 static inline void gfx_make_tex_active(gfx_tex_id tex_id) {
-	gfx_slot_hnd slot = ctx->textures[tex_id].slot;
+	gfx_slot_hnd slot = gfx_tex(tex_id)->slot;
 	gfx_assert(slot, "Slot bound to texture #%d is invalid.", tex_id);
 	gfx_bind_slot(slot);
 }
 
-static void gfx_tex_upload(u8* buf, u32 w, u32 h, GLenum format, bool pixellated) {
+static void gfx_tex_image(const u8* buf, u32 w, u32 h, GLenum format, bool pixellated) {
 	glPixelStorei(GL_UNPACK_ALIGNMENT, gfx_glsizeof(format));
 	glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, buf);
 
 	// We just don't need mipmaps for fonts so we do this for normal images
 	if(!pixellated) glGenerateMipmap(GL_TEXTURE_2D); // CALL AFTER UPLOAD
-	info("Uploaded texture (%dx%d) to slot #%d", w, h, ctx->gl.slot_bound);
 }
 
-static gfx_tex_id gfx_tex_push(bool pixellated) {
-	gfx_bind_slot(gfx_find_empty_slot());
-
-	vpush(ctx->textures, {});
-	gfx_tex_id tex_id = vlen(ctx->textures) - 1;
-	glGenTextures(1, &ctx->textures[tex_id].id);
-	gfx_bind_tex(tex_id);
+static void gfx_tex_upload(u8* buf, u32 w, u32 h, GLenum format, bool pixellated) {
+	if(ctx->render.on) {
+		// buf can change or be freed before the render thread gets to it, so it uploads a copy
+		gfx_packet* p = gfx_recording();
+		u64 at = vlen(p->data), size = (u64) w * h * gfx_glsizeof(format);
+		memcpy(vpush_uninit(p->data, size), buf, size);
+		gfx_record(.op = GFX_OP_UPLOAD, .flag = pixellated, .format = format, .w = w, .h = h, .data = at);
+	}
+	else gfx_tex_image(buf, w, h, format, pixellated);
+	ctx->share->uploads ++;
+	ctx->frame.counts.upload_bytes += (u64) w * h * gfx_glsizeof(format);
+	info("Uploaded texture (%dx%d) to slot #%d", w, h, ctx->gl.slot_bound);
+}
 
-	// Sets default params
+// Sets default params
+static void gfx_tex_params(bool pixellated) {
 	GLenum minmagfilter = pixellated ? GL_NEAREST : GL_LINEAR;
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minmagfilter);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, minmagfilter);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	if(!pixellated) glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+}
+
+static gfx_tex_id gfx_tex_push(bool pixellated) {
+	gfx_bind_slot(gfx_find_empty_slot());
+
+	gfx_tex_id tex_id = vlen(ctx->share->tex_ids);
+	vpush(ctx->share->tex_ids, 0);
+
+	// The render thread makes the texture, binds it and sets its params all at once, so binding it again is a no-op. Its
+	// id only comes back here when the render thread stops.
+	if(ctx->render.on) gfx_record(.op = GFX_OP_TEX_NEW, .flag = pixellated, .tex = tex_id);
+	else glGenTextures(1, ctx->share->tex_ids + tex_id);
+	gfx_bind_tex(tex_id);
+	if(!ctx->render.on) gfx_tex_params(pixellated);
 
 	return tex_id;
 }
 
 static gfx_slot_hnd gfx_make_tex_available_for_draw(gfx_tex_id tex_id) {
-  gfx_texture* tex = &ctx->textures[tex_id];
+  gfx_texture* tex = gfx_tex(tex_id);
   if(!tex->slot) {
 		tex->slot = gfx_find_empty_slot();
 		if(!tex->slot) { draw(); tex->slot = 1; /* find_empty_slot will always return 1 here. */ }
@@ -1544,14 +3277,14 @@ static gfx_atlas* gfx_atlases_add(GLenum format, bool pixellated, gfx_vector_min
 	gfx_atlas* atlas = NULL;
 	struct gfx_atlas_node* maybe = NULL;
 
-	for(int i = 0; i < vlen(ctx->atlases) && !growth; i ++)
-		if(ctx->atlases[i].format == format)
-			growth = gfx_atlas_try_insert((atlas = ctx->atlases + i), size, &maybe);
+	for(u32 i = 0; i < vlen(ctx->share->atlases) && !growth; i ++)
+		if(ctx->share->atlases[i].format == format)
+			growth = gfx_atlas_try_insert((atlas = ctx->share->atlases + i), size, &maybe);
 
 	if(!growth) {
 		gfx_atlas_node* tree = vnew();
 		vpush(tree, { .s = { USHRT_MAX, USHRT_MAX } });
-		vpush(ctx->atlases, {
+		vpush(ctx->share->atlases, {
 			.format = format,
 			.tree = tree,
 			.tex_id = gfx_tex_push(pixellated),
@@ -1559,11 +3292,11 @@ static gfx_atlas* gfx_atlases_add(GLenum format, bool pixellated, gfx_vector_min
 			.growth_factor = 1
 		});
 
-		atlas = vlast(ctx->atlases);
+		atlas = vlast(ctx->share->atlases);
 		gfx_assert(gfx_atlas_try_insert(atlas, size, &maybe), "Somehow couldn't find space to insert into the atlas, object probably too big (%dx%d).", size->x, size->y);
 
 		atlas->buf = GFX_MALLOC(GFX_ATLAS_START_SIZE * GFX_ATLAS_START_SIZE * gfx_glsizeof(format) * sizeof(u8) * atlas->growth_factor);
-		info("Generating new atlas #%d", vlen(ctx->atlases));
+		info("Generating new atlas #%d", vlen(ctx->share->atlases));
 
 	} else if(growth > 1) {
 		u8* new_buf = GFX_MALLOC(GFX_ATLAS_START_SIZE * GFX_ATLAS_START_SIZE * gfx_glsizeof(format) * sizeof(u8) * atlas->growth_factor);
@@ -1575,58 +3308,73 @@ static gfx_atlas* gfx_atlases_add(GLenum format, bool pixellated, gfx_vector_min
 
 		free(atlas->buf);
 		atlas->buf = new_buf;
+		ctx->share->atlas_growths ++;
 	}
 
 	vpush(atlas->added, { maybe->p, maybe->s });
+	atlas->used += (u32) maybe->s.w * maybe->s.h;
 
 	*ret_pos = maybe->p;
 	PROFILER_ZONE_END
 	return atlas;
 }
 
+// Copies a rect that was added to the atlas into buf, rows next to each other
+static void gfx_atlas_copy(gfx_atlas* atlas, gfx_atlas_added* added, u8* buf) {
+	u32 row = added->size.w * gfx_glsizeof(atlas->format);
+	for(int j = 0; j < added->size.h; j ++)
+		memcpy(buf + j * row, atlas->buf + (added->place.y + j) * GFX_ATLAS_W(atlas) + added->place.x * gfx_glsizeof(atlas->format), row);
+}
+
 // Assumes texture is bound
 static void gfx_update_atlas(gfx_atlas* atlas) {
-	static _Thread_local char* buf = NULL;
-	static _Thread_local int buf_size = 0;
+	static _Thread_local u8* buf = NULL;
+	static _Thread_local u32 buf_size = 0;
 	PROFILER_ZONE_START
-	PROFILER_GPU_ZONE_START("update_atlas")
 
 	u32 len = vlen(atlas->added);
 	if(!atlas->uploaded || len > 10 && gfx_totalarea(atlas->added) > GFX_ATLAS_W(atlas) * atlas->growth_factor * atlas->growth_factor * GFX_ATLAS_START_SIZE / 3) {
 		gfx_tex_upload(atlas->buf, GFX_ATLAS_W(atlas), GFX_ATLAS_START_SIZE * atlas->growth_factor, atlas->format, false);
 		atlas->uploaded = true;
-		vempty(atlas->added);
-		PROFILER_ZONE_END
-		return;
 	}
 
-	if(!buf) buf = GFX_MALLOC(GFX_ATLAS_START_SIZE * GFX_ATLAS_START_SIZE * gfx_glsizeof(atlas->format) * sizeof(u8) * atlas->growth_factor);
-
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
-	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
-
-	for(u32 i = 0; i < len; i ++) {
-		gfx_atlas_added* added = atlas->added + i;
-
-		if(buf_size < added->size.w * added->size.h * gfx_glsizeof(atlas->format)) {
-			buf_size = added->size.w * added->size.h * gfx_glsizeof(atlas->format);
-			buf = GFX_REALLOC(buf, buf_size);
+	// The render thread gets the patches as copies, since the atlas keeps changing while it uploads them
+	else if(ctx->render.on) {
+		gfx_packet* p = gfx_recording();
+		ctx->frame.counts.upload_bytes += (u64) gfx_totalarea(atlas->added) * gfx_glsizeof(atlas->format);
+		for(u32 i = 0; i < len; i ++) {
+			gfx_atlas_added* added = atlas->added + i;
+			u64 at = vlen(p->data);
+			gfx_atlas_copy(atlas, added, vpush_uninit(p->data, added->size.w * added->size.h * gfx_glsizeof(atlas->format)));
+			gfx_record(.op = GFX_OP_PATCH, .format = atlas->format, .x = added->place.x, .y = added->place.y, .w = added->size.w, .h = added->size.h, .data = at);
 		}
+	}
 
-		for(int j = 0; j < added->size.h; j ++)
-			memcpy(buf + j * added->size.w * gfx_glsizeof(atlas->format), atlas->buf + (added->place.y + j) * GFX_ATLAS_W(atlas) + added->place.x * gfx_glsizeof(atlas->format),
-						 added->size.w * gfx_glsizeof(atlas->format));
-
-		glTexSubImage2D(GL_TEXTURE_2D, 0, added->place.x, added->place.y, added->size.w, added->size.h, atlas->format, GL_UNSIGNED_BYTE, buf);
-		// info("Uploaded to atlas #%d at (%d, %d) (%dx%d)", atlas - ctx->atlases, added->place.x, added->place.y, added->size.w, added->size.h);
+	else {
+		PROFILER_GPU_ZONE_START("update_atlas")
+		ctx->frame.counts.upload_bytes += (u64) gfx_totalarea(atlas->added) * gfx_glsizeof(atlas->format);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+		for(u32 i = 0; i < len; i ++) {
+			gfx_atlas_added* added = atlas->added + i;
+			if(buf_size < added->size.w * added->size.h * gfx_glsizeof(atlas->format)) {
+				buf_size = added->size.w * added->size.h * gfx_glsizeof(atlas->format);
+				buf = GFX_REALLOC(buf, buf_size);
+			}
+			gfx_atlas_copy(atlas, added, buf);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, added->place.x, added->place.y, added->size.w, added->size.h, atlas->format, GL_UNSIGNED_BYTE, buf);
+			// info("Uploaded to atlas #%d at (%d, %d) (%dx%d)", atlas - ctx->share->atlases, added->place.x, added->place.y, added->size.w, added->size.h);
+		}
+		PROFILER_GPU_ZONE_END()
 	}
 
 	// stbi_write_png("bitmap.png", atlas->growth_factor * GFX_ATLAS_START_SIZE, atlas->growth_factor * GFX_ATLAS_START_SIZE, 1, atlas->buf, GFX_ATLAS_W(atlas));
 
 	vempty(atlas->added);
-	PROFILER_GPU_ZONE_END()
+	ctx->share->uploads ++;
 	PROFILER_ZONE_END
 }
 
@@ -1664,7 +3412,7 @@ gfx_img gfx_load_img_rgba(u8* t, int width, int height) {
 		for(int i = 0; i < height; i ++)
 			memcpy(atlas->buf + img.place.x * gfx_glsizeof(atlas->format) + img.place.y * GFX_ATLAS_W(atlas), t, width * gfx_glsizeof(atlas->format));
 
-		img.atlas_hnd = atlas - ctx->atlases + 1;
+		img.atlas_hnd = atlas - ctx->share->atlases + 1;
 	}
 
 	// Otherwise just upload it straight to the GPU
@@ -1678,9 +3426,9 @@ gfx_img gfx_load_img_rgba(u8* t, int width, int height) {
 	gfx_assert(img.tex_hnd || img.atlas_hnd, "Critical error loading image (%dx%d) for some reason.", width, height);
 	stbi_image_free(t);
 
-	if(!ctx->images) ctx->images = vnew();
-	vpush(ctx->images, img);
-	return vlen(ctx->images) - 1;
+	if(!ctx->share->images) ctx->share->images = vnew();
+	vpush(ctx->share->images, img);
+	return vlen(ctx->share->images) - 1;
 }
 
 
@@ -1706,8 +3454,8 @@ void image(gfx_img img_id, short x, short y, short w, short h) {
 	if(img_id < 0) return;
 	PROFILER_ZONE_START
 
-	gfx_internal_image* img = ctx->images + img_id;
-	GLuint tex_id = img->tex_hnd ? img->tex_hnd - 1 : ctx->atlases[img->atlas_hnd - 1].tex_id;
+	gfx_internal_image* img = ctx->share->images + img_id;
+	GLuint tex_id = img->tex_hnd ? img->tex_hnd - 1 : ctx->share->atlases[img->atlas_hnd - 1].tex_id;
 	// gfx_vector_mini tcoords[4] = {
 	// 	{ .w = 0,        .h = 0,        },
 	// 	{ .w = UV_X_MAX, .h = 0,        },
@@ -1719,7 +3467,7 @@ void image(gfx_img img_id, short x, short y, short w, short h) {
 
 	// This code is for when Images automatically get allocated to atlases. It should work right now but complicates things so it's disabled.
 	// if(img->atlas_hnd) {
-	// 	gfx_atlas* atlas = ctx->atlases + img->atlas_hnd - 1;
+	// 	gfx_atlas* atlas = ctx->share->atlases + img->atlas_hnd - 1;
 	// 	tcoords[0] = (gfx_vector_mini) { .w = img->place.x,               .h = img->place.y };
 	// 	tcoords[1] = (gfx_vector_mini) { .w = img->place.x + img->size.w, .h = img->place.y };
 	// 	tcoords[2] = (gfx_vector_mini) { .w = img->place.x + img->size.w, .h = img->place.y + img->size.h };
@@ -1738,7 +3486,7 @@ void image(gfx_img img_id, short x, short y, short w, short h) {
 	PROFILER_ZONE_END
 }
 
-gfx_vector_mini* const isize(gfx_img img) { return &ctx->images[img].size; }
+gfx_vector_mini* const isize(gfx_img img) { return &ctx->share->images[img].size; }
 
 
 
@@ -1751,172 +3499,2079 @@ gfx_vector_mini* const isize(gfx_img img) { return &ctx->images[img].size; }
 
 // ------------------------------------ Text Drawing Functions ------------------------------------ //
 
+// Reads one codepoint and moves past it. The string is only read, since the same text gets read again to measure and lay it out.
 static inline FT_ULong gfx_readutf8(u8** str) {
 	if(**str == 0) return 0;
-	FT_ULong code_point = 0;
+	u8 lead = *(*str)++;
+	int len = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
 
-	int len =
-		**str > 0x80 ?
-			(**str & 0xE0) == 0xE0 ? 2 :
-				(**str & 0xC0) == 0xC0 ? 1 : 3
-		: 0;
-
-	if(len > 0) **str <<= len + 2, **str >>= len + 2;
-	code_point += *(*str)++;
-	while (len--) code_point = code_point << 6 | (*(*str)++ & 0x3F);
+	FT_ULong code_point = len ? lead & 0x3F >> len : lead;
+	while (len-- && **str) code_point = code_point << 6 | (*(*str)++ & 0x3F);
 	return code_point;
 }
 
-static gfx_char* gfx_load_char(gfx_face tf, FT_ULong c) {
-	PROFILER_ZONE_START
-	gfx_typeface* face = ctx->font.store + tf;
-	CHECK_CALL(FT_Set_Pixel_Sizes(face->face, 0, ctx->font.size * 4.0f / 3.0f), PROFILER_ZONE_END; return NULL, "Couldn't set size");
-	CHECK_CALL(FT_Load_Char(face->face, c, FT_LOAD_RENDER), PROFILER_ZONE_END; return NULL, "Couldn't load char '%c' (%X)", c, c);
+// Makes FreeType render the face at a size, activating the size's own FT_Size if it's one of the recently used ones.
+static bool gfx_use_size(gfx_typeface* face, u32 size) {
+	if(face->active_size == size) return true;
+	struct gfx_ft_size* use = face->sizes;
+	for(u32 i = 0; i < GFX_FT_SIZES; i ++) {
+		if(face->sizes[i].ft && face->sizes[i].size == size) { use = face->sizes + i; break; }
+		if(face->sizes[i].last_used < use->last_used) use = face->sizes + i;
+	}
+
+	if(!use->ft || use->size != size) {
+		if(use->ft) FT_Done_Size(use->ft);
+		use->size = size;
+		CHECK_CALL(FT_New_Size(face->face, &use->ft), use->ft = NULL; return false, "Couldn't create a size for '%s'", face->name);
+		CHECK_CALL(FT_Activate_Size(use->ft), return false, "Couldn't activate size");
+		CHECK_CALL(FT_Set_Pixel_Sizes(face->face, 0, size * 4.0f / 3.0f), return false, "Couldn't set size");
+	}
+	else CHECK_CALL(FT_Activate_Size(use->ft), return false, "Couldn't activate size");
+
+	use->last_used = ++ face->size_tick;
+	face->active_size = size;
+	return true;
+}
+
+// The face's low codepoint table for a size, emptying the least recently used one when the size doesn't have one yet.
+static struct gfx_low_table* gfx_low_table(gfx_typeface* face, u32 size) {
+	struct gfx_low_table* use = face->low;
+	for(u32 i = 0; i < GFX_LOW_TABLES; i ++) {
+		if(face->low[i].chars && face->low[i].size == size) { use = face->low + i; goto found; }
+		if(face->low[i].last_used < use->last_used) use = face->low + i;
+	}
+	// Draw lists could be reading the one that gets reused
+	gfx_rwlock_take_write(&ctx->share->fonts_lock);
+	if(!use->chars) use->chars = GFX_MALLOC(GFX_LOW_CODEPOINTS * sizeof(gfx_char));
+	memset(use->chars, 0, GFX_LOW_CODEPOINTS * sizeof(gfx_char));
+	use->size = size;
+	gfx_rwlock_give_write(&ctx->share->fonts_lock);
+
+found:
+	use->last_used = ++ face->low_tick;
+	return use;
+}
+
+// Copies a glyph from chars into a low codepoint table, which draw lists can be reading.
+static inline void gfx_low_fill(gfx_char* low, const gfx_char* ch) {
+	gfx_rwlock_take_write(&ctx->share->fonts_lock);
+	*low = *ch;
+	gfx_rwlock_give_write(&ctx->share->fonts_lock);
+}
 
-	int width = face->face->glyph->bitmap.width;
-	int height = face->face->glyph->bitmap.rows;
+// Puts a rendered glyph's bitmap into an atlas and the face's cache.
+static gfx_char* gfx_insert_glyph(gfx_face tf, u32 glyph, u32 size, const gfx_raster* r) {
+	gfx_typeface* face = ctx->share->fonts + tf;
 
 	// Tries to add the character, resizing the whole texture until it's done
 	gfx_vector_mini pos;
-	gfx_vector_mini size = { width, height };
-	gfx_atlas* atlas = gfx_atlases_add(GL_RED, true, &size, &pos);
-	// info("Loaded character '%c' (%X) at (%d, %d) in atlas #%d", c, c, pos.x, pos.y, atlas - ctx->atlases);
+	gfx_vector_mini bsize = { r->w, r->h };
+	gfx_atlas* atlas = gfx_atlases_add(GL_RED, true, &bsize, &pos);
 
 	// Writes the character's pixels to the atlas buffer.
 	u8* insertsurface = atlas->buf + pos.x + pos.y * (GFX_ATLAS_START_SIZE * atlas->growth_factor);
-	for(int i = 0; i < height; i ++)
-		memcpy(insertsurface + i * (GFX_ATLAS_START_SIZE * atlas->growth_factor), face->face->glyph->bitmap.buffer + i * width, width);
+	for(int i = 0; i < r->h; i ++)
+		memcpy(insertsurface + i * (GFX_ATLAS_START_SIZE * atlas->growth_factor), r->pixels + i * r->w, r->w);
 
+	ctx->stats.glyph_loads ++;
 	gfx_char* inserted;
-	*(inserted = hput(gfx_char, face->chars, { c, ctx->font.size })) = (gfx_char) {
-		.c = c, .size = size,
-		.bearing = {
-			.x = face->face->glyph->bitmap_left,
-			.y = face->face->glyph->bitmap_top
-		},
-		.advance = (face->face->glyph->advance.x >> 6),
-		.place = pos,
-		.atlas = atlas - ctx->atlases,
+	*(inserted = hput(gfx_char, face->chars, { glyph, size })) = (gfx_char) {
+		.uv_x = roundf(pos.x * (UV_X_MAX / (f32) GFX_ATLAS_MAX_SIZE)),
+		.uv_y = roundf(pos.y * (UV_Y_MAX / (f32) GFX_ATLAS_MAX_SIZE)),
+		.size = bsize,
+		.bearing = { .x = r->left, .y = r->top },
+		.advance = r->advance,
+		.atlas = atlas - ctx->share->atlases,
+		.loaded = true
+	};
+	return inserted;
+}
+
+// Rasterizes the glyph FreeType loaded into the slot, with raster.h when native is on and the glyph is an outline. The
+// pixels belong to the slot or the canvas, so they're only good until the next glyph.
+static bool gfx_render_slot(FT_GlyphSlot slot, raster_canvas* canvas, bool native, gfx_raster* r) {
+	if(native && slot->format == FT_GLYPH_FORMAT_OUTLINE) {
+		if(!raster_ft_outline(canvas, &slot->outline)) return false;
+		*r = (gfx_raster) {
+			.pixels = raster_end(canvas), .w = canvas->w, .h = canvas->h,
+			.left = canvas->left, .top = canvas->top, .advance = slot->advance.x >> 6
+		};
+		return true;
+	}
+
+	if(FT_Render_Glyph(slot, FT_RENDER_MODE_NORMAL)) return false;
+	*r = (gfx_raster) {
+		.pixels = slot->bitmap.buffer, .w = slot->bitmap.width, .h = slot->bitmap.rows,
+		.left = slot->bitmap_left, .top = slot->bitmap_top, .advance = slot->advance.x >> 6
 	};
+	return true;
+}
+
+// Loads a glyph by its index in the face, NOT its codepoint. Use FT_Get_Char_Index to convert codepoints first.
+static gfx_char* gfx_load_glyph(gfx_face tf, u32 glyph, u32 size) {
+	PROFILER_ZONE_START
+	gfx_typeface* face = ctx->share->fonts + tf;
+	if(!gfx_use_size(face, size)) { PROFILER_ZONE_END; return NULL; }
+	CHECK_CALL(FT_Load_Glyph(face->face, glyph, FT_LOAD_DEFAULT), PROFILER_ZONE_END; return NULL, "Couldn't load glyph #%d", glyph);
+
+	gfx_raster r;
+	CHECK_CALL(!gfx_render_slot(face->face->glyph, &ctx->font.canvas, face->native_raster, &r), PROFILER_ZONE_END; return NULL, "Couldn't render glyph #%d", glyph);
+	gfx_char* inserted = gfx_insert_glyph(tf, glyph, size, &r);
 	PROFILER_ZONE_END
 	return inserted;
 }
 
-gfx_face gfx_load_font(const char* file) {
+// Rasterizes glyphs [from, to) of the job. Every pool thread has its own FT_Face, since faces can't be shared between
+// threads, so this never touches ctx (which is thread local anyway).
+static void gfx_raster_glyphs(void* arg, u32 from, u32 to) {
+	gfx_raster_job* job = arg;
+
+	// The thread that started the job uses the context's own face, which is already at the right size
+	gfx_raster_thread* thread = gfx_self ? job->threads + gfx_self->index : &job->self;
+	FT_Face face = job->face;
+	if(gfx_self) {
+		CHECK_CALL(!thread->lib && FT_Init_FreeType(&thread->lib), thread->lib = NULL; return, "Couldn't initialize freetype for a pool thread");
+		if(!thread->faces) thread->faces = vnew();
+		while(vlen(thread->faces) <= (u32) job->tf) vpush(thread->faces, NULL);
+		if(!thread->faces[job->tf] && FT_New_Memory_Face(thread->lib, job->data, job->data_len, 0, thread->faces + job->tf)) thread->faces[job->tf] = NULL;
+		face = thread->faces[job->tf];
+		if(!face) return;
+		if(thread->sized != face || thread->size != job->size) {
+			if(FT_Set_Pixel_Sizes(face, 0, job->size * 4.0f / 3.0f)) return;
+			thread->sized = face;
+			thread->size = job->size;
+		}
+	}
+
+	for(u32 i = from; i < to; i ++) {
+		gfx_raster rendered;
+		if(FT_Load_Glyph(face, job->glyphs[i], FT_LOAD_DEFAULT) || !gfx_render_slot(face->glyph, &thread->canvas, job->native, &rendered)) continue;
+		gfx_raster* r = job->results + i;
+		*r = rendered;
+		r->pixels = GFX_MALLOC(r->w * r->h + 1);
+		memcpy(r->pixels, rendered.pixels, r->w * r->h);
+	}
+}
+
+static int gfx_u32_cmp(const void* a, const void* b) { return (*(u32*) a > *(u32*) b) - (*(u32*) a < *(u32*) b); }
+
+// Rasterizes every glyph in the list that isn't cached yet. Big batches are split between the job pool and the calling
+// thread, and the bitmaps all go into the atlases at the end.
+static void gfx_load_glyphs(gfx_face tf, const u32* glyphs, u32 n, u32 size) {
+	gfx_typeface* face = ctx->share->fonts + tf;
+
+	// Drops glyphs that are already there, and duplicates once they're sorted next to each other
+	u32* missing = gfx_frame_vnew();
+	for(u32 i = 0; i < n; i ++)
+		if(!hget(gfx_char, face->chars, { glyphs[i], size })) vpush(missing, glyphs[i]);
+	qsort(missing, vlen(missing), sizeof(u32), gfx_u32_cmp);
+	u32 unique = 0;
+	for(u32 i = 0; i < vlen(missing); i ++)
+		if(!unique || missing[unique - 1] != missing[i]) missing[unique ++] = missing[i];
+	vpopto(missing, unique);
+
+	if(vlen(missing) < GFX_RASTER_MIN_BATCH) {
+		for(u32 i = 0; i < vlen(missing); i ++) gfx_load_glyph(tf, missing[i], size);
+		vfree(missing);
+		return;
+	}
+
 	PROFILER_ZONE_START
-	gfx_typeface new = {
-		.name = file,
-		.chars = {0},
-		.face = NULL
+	if(!gfx_use_size(face, size)) { vfree(missing); PROFILER_ZONE_END; return; }
+	gfx_raster* results = gfx_frame_alloc(vlen(missing) * sizeof(gfx_raster));
+	memset(results, 0, vlen(missing) * sizeof(gfx_raster));
+	gfx_raster_job job = {
+		.tf = tf, .data = face->data, .data_len = face->data_len, .face = face->face, .size = size, .native = face->native_raster,
+		.glyphs = missing, .results = results,
+		.threads = ctx->raster, .self = { .canvas = ctx->font.canvas }
 	};
 
-	// Loads the freetype library.
-	if(!ft) CHECK_CALL(FT_Init_FreeType(&ft), return -1, "Couldn't initialize freetype");
+	// Pool threads only get pieces of a few glyphs, any less isn't worth it
+	gfx_parallel_for(vlen(missing), GFX_RASTER_MIN_BATCH, gfx_raster_glyphs, &job);
+	ctx->font.canvas = job.self.canvas;
 
-	// Loads the new face in using the library
-	CHECK_CALL(FT_New_Face(ft, file, 0, (FT_Face*) &new.face), return -1, "Couldn't load font '%s'", file);
-	CHECK_CALL(FT_Set_Pixel_Sizes(new.face, 0, RENDERING_FONT_SIZE()), return -1, "Couldn't set size");
+	// Atlases aren't thread safe, so everything goes in from here
+	for(u32 i = 0; i < vlen(missing); i ++) {
+		if(!job.results[i].pixels) continue;
+		gfx_insert_glyph(tf, missing[i], size, job.results + i);
+		GFX_FREE(job.results[i].pixels);
+	}
+	vfree(missing);
+	PROFILER_ZONE_END
+}
 
-	// Adds space_width
-	CHECK_CALL(FT_Load_Char(new.face, ' ', FT_LOAD_RENDER), return -1, "Couldn't load the Space Character ( )");
-	new.space_width = new.face->glyph->advance.x >> 6;
+// Rasterizes the rest of a run of glyphs at once, when drawing it runs into one that isn't cached. Keys are
+// GFX_RASTER_KEY(fallback handle, glyph), so glyphs from fallback faces get loaded with their own face.
+static void gfx_load_run(gfx_face tf, const u32* keys, u32 n, u32 size) {
+	gfx_typeface* face = ctx->share->fonts + tf;
+	u32* glyphs = gfx_frame_vnew();
+	for(u32 fb = 0; fb <= vlen(face->fallbacks); fb ++) {
+		vempty(glyphs);
+		for(u32 i = 0; i < n; i ++)
+			if(keys[i] >> 16 == fb) vpush(glyphs, keys[i] & 0xFFFF);
+		if(vlen(glyphs)) gfx_load_glyphs(fb ? face->fallbacks[fb - 1] : tf, glyphs, vlen(glyphs), size);
+	}
+	vfree(glyphs);
+}
 
-	// Stores the font
-	vpush(ctx->font.store, new);
-	info("Loaded font '%s'", new.name);
-	PROFILER_ZONE_END
-	return vlen(ctx->font.store) - 1;
+// The size glyphs really get rasterized at. With buckets on, sizes round up to the next min * ratio^n so nearby sizes
+// share bitmaps, and the quads get scaled down to the requested size. Rounding up means glyphs only ever get minified.
+static inline u32 gfx_font_bucket_of(const typeof(ctx->font)* font, u32 size) {
+	if(font->bucket_ratio <= 1.0f || size <= font->bucket_min) return size;
+	f32 bucket = font->bucket_min;
+	while(bucket < size) bucket = ceilf(bucket * font->bucket_ratio);
+	return bucket;
 }
+static inline u32 gfx_font_bucket(u32 size) { return gfx_font_bucket_of(&ctx->font, size); }
 
+// How far down each line of text goes, in pixels.
+static inline short gfx_line_advance_of(const typeof(ctx->font)* font, u32 size) { return font->lh * size * 4 / 3; }
+static inline short gfx_line_advance(u32 size) { return gfx_line_advance_of(&ctx->font, size); }
 
-void font_size(u32 size) { if(size) ctx->font.size = size; }
-void line_height(f32 h) { ctx->font.lh = h; }
-void font(gfx_face face, u32 size) {
-	if(face >= 0 && face != ctx->font.cur)
-		ctx->font.cur = face;
-	if(size > 0) ctx->font.size = size;
+// Gets a glyph from the cache, loading it in if it's not there.
+static inline gfx_char* gfx_get_glyph(gfx_face tf, u32 glyph, u32 size) {
+	gfx_char* ch = hget(gfx_char, ctx->share->fonts[tf].chars, { glyph, size });
+	return ch ? ch : gfx_load_glyph(tf, glyph, size);
 }
-void text(const char* str, short x, short y) {
-	if(!vlen(ctx->font.store)) return;
-	PROFILER_ZONE_START
 
-	gfx_typeface* face = ctx->font.store + ctx->font.cur;
+// Big endian reads for the OpenType tables FreeType doesn't parse for us.
+static inline u16 gfx_be16(const u8* p) { return p[0] << 8 | p[1]; }
+static inline u32 gfx_be32(const u8* p) { return (u32) p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]; }
+
+// Index of a glyph in an OpenType Coverage table, -1 if it isn't covered.
+static int gfx_ot_coverage(const u8* cov, u16 glyph) {
+	u16 format = gfx_be16(cov), n = gfx_be16(cov + 2);
+	for(int lo = 0, hi = n - 1; lo <= hi;) {
+		int mid = (lo + hi) / 2;
+		const u8* rec = cov + 4 + mid * (format == 1 ? 2 : 6);
+		if(format == 1 && gfx_be16(rec) == glyph) return mid;
+		if(format == 2 && glyph >= gfx_be16(rec) && glyph <= gfx_be16(rec + 2)) return gfx_be16(rec + 4) + glyph - gfx_be16(rec);
+		if(format != 1 && format != 2) break;
+		if(glyph < gfx_be16(rec)) hi = mid - 1;
+		else lo = mid + 1;
+	}
+	return -1;
+}
 
-	FT_ULong point;
-	short curx = x, cury = y;
-	short realx, realy, w, h;
-	u16 tx, ty, tw, th;
-	while ((point = gfx_readutf8((u8**) &str))) {
+// Class of a glyph in an OpenType ClassDef table. Glyphs that aren't listed are class 0.
+static u16 gfx_ot_class(const u8* cd, u16 glyph) {
+	if(gfx_be16(cd) == 1) {
+		u16 start = gfx_be16(cd + 2), n = gfx_be16(cd + 4);
+		return glyph >= start && glyph < start + n ? gfx_be16(cd + 6 + (glyph - start) * 2) : 0;
+	}
+	if(gfx_be16(cd) == 2) {
+		for(int lo = 0, hi = gfx_be16(cd + 2) - 1; lo <= hi;) {
+			int mid = (lo + hi) / 2;
+			const u8* rec = cd + 4 + mid * 6;
+			if(glyph < gfx_be16(rec)) hi = mid - 1;
+			else if(glyph > gfx_be16(rec + 2)) lo = mid + 1;
+			else return gfx_be16(rec + 4);
+		}
+	}
+	return 0;
+}
 
-		// Newlines in five lines :D
-		if (point == '\n') {
-			cury += ctx->font.lh * ctx->font.size * 4 / 3;
-			curx = x;
-			continue;
+// ValueRecords only contain the fields in their format, each 2 bytes. XAdvance (0x4) comes after XPlacement and YPlacement.
+static inline u32 gfx_ot_value_size(u16 format) { u32 n = 0; for(; format; format >>= 1) n += format & 1; return n * 2; }
+static inline i16 gfx_ot_x_advance(const u8* rec, u16 format) { return format & 4 ? (i16) gfx_be16(rec + gfx_ot_value_size(format & 3)) : 0; }
+
+static void gfx_add_kern(gfx_typeface* face, u16 left, u16 right, i16 units) {
+	if(!units) return;
+	i16* cur = hget(gfx_kern, face->kern, GFX_KERN_PAIR(left, right));
+	if(cur) *cur += units;
+	else *hput(gfx_kern, face->kern, GFX_KERN_PAIR(left, right)) = units;
+	face->kern_left[left >> 6] |= 1ull << (left & 63);
+}
+
+// Adds up a PairPos lookup's adjustments between all the glyphs. Only the first subtable that has a pair counts for it.
+static void gfx_load_pairpos(gfx_typeface* face, const u8* lookup, const u16* glyphs, u8* decided) {
+	u16 type = gfx_be16(lookup), subtables = gfx_be16(lookup + 4);
+	u32 n = vlen(glyphs);
+
+	for(u32 a = 0; a < n; a ++) {
+		memset(decided, 0, n);
+		for(u16 s = 0; s < subtables; s ++) {
+			const u8* sub = lookup + gfx_be16(lookup + 6 + s * 2);
+
+			// Extension lookups just point to the real subtable
+			if(type == 9) {
+				if(gfx_be16(sub + 2) != 2) continue;
+				sub += gfx_be32(sub + 4);
+			}
+			else if(type != 2) return;
+
+			int cov = gfx_ot_coverage(sub + gfx_be16(sub + 2), glyphs[a]);
+			if(cov < 0) continue;
+			u16 vf1 = gfx_be16(sub + 4);
+			u32 rec_size = gfx_ot_value_size(vf1) + gfx_ot_value_size(gfx_be16(sub + 6));
+
+			// Individual pairs, sorted by the second glyph
+			if(gfx_be16(sub) == 1) {
+				if(cov >= gfx_be16(sub + 8)) continue;
+				const u8* set = sub + gfx_be16(sub + 10 + cov * 2);
+				for(u32 b = 0; b < n; b ++) {
+					if(decided[b]) continue;
+					for(int lo = 0, hi = gfx_be16(set) - 1; lo <= hi;) {
+						int mid = (lo + hi) / 2;
+						const u8* rec = set + 2 + mid * (2 + rec_size);
+						u16 second = gfx_be16(rec);
+						if(glyphs[b] < second) hi = mid - 1;
+						else if(glyphs[b] > second) lo = mid + 1;
+						else { decided[b] = true; gfx_add_kern(face, glyphs[a], glyphs[b], gfx_ot_x_advance(rec + 2, vf1)); break; }
+					}
+				}
+			}
+
+			// Class pairs, where every second glyph has a class (0 if it isn't listed)
+			else if(gfx_be16(sub) == 2) {
+				u16 class1 = gfx_ot_class(sub + gfx_be16(sub + 8), glyphs[a]);
+				u16 class1_count = gfx_be16(sub + 12), class2_count = gfx_be16(sub + 14);
+				if(class1 >= class1_count) continue;
+				const u8* row = sub + 16 + class1 * class2_count * rec_size;
+				for(u32 b = 0; b < n; b ++) {
+					if(decided[b]) continue;
+					decided[b] = true;
+					u16 class2 = gfx_ot_class(sub + gfx_be16(sub + 10), glyphs[b]);
+					if(class2 < class2_count) gfx_add_kern(face, glyphs[a], glyphs[b], gfx_ot_x_advance(row + class2 * rec_size, vf1));
+				}
+			}
 		}
+	}
+}
 
-		else if(point == ' ') {
-			curx += face->space_width * ctx->font.size * 4 / 3 /*px -> pts*/ / RENDERING_FONT_SIZE();
-			continue;
+// Precomputes the face's kerning pairs in font units, from the GPOS 'kern' feature or the old 'kern' table if there's no GPOS kerning.
+// Only pairs between the glyphs up to GFX_KERN_MAX_CODEPOINT are read, so the table stays small and the lookup stays one hash probe.
+static void gfx_load_kerning(gfx_typeface* face) {
+	PROFILER_ZONE_START
+	u32 words = (face->face->num_glyphs + 63) / 64;
+	face->kern_left = vnew();
+	memset(vpush_uninit(face->kern_left, words), 0, words * sizeof(u64));
+
+	u16* glyphs = vnew();
+	u64* seen = GFX_CALLOC(words, sizeof(u64));
+	for(FT_ULong c = ' '; c <= GFX_KERN_MAX_CODEPOINT; c ++) {
+		FT_UInt g = FT_Get_Char_Index(face->face, c);
+		if(!g || seen[g >> 6] >> (g & 63) & 1) continue;
+		seen[g >> 6] |= 1ull << (g & 63);
+		vpush(glyphs, g);
+	}
+	GFX_FREE(seen);
+
+	bool gpos = false;
+	FT_ULong len = 0;
+	if(!FT_Load_Sfnt_Table(face->face, TTAG_GPOS, 0, NULL, &len) && len >= 10) {
+		u8* table = GFX_MALLOC(len);
+		if(!FT_Load_Sfnt_Table(face->face, TTAG_GPOS, 0, table, &len)) {
+			const u8* features = table + gfx_be16(table + 6);
+			const u8* lookups  = table + gfx_be16(table + 8);
+			u16 lookup_count = gfx_be16(lookups);
+
+			// Every script has its own kern feature, but they usually share lookups, which must only be added once
+			u8* applied = GFX_CALLOC(lookup_count + 1, 1);
+			u8* decided = GFX_MALLOC(vlen(glyphs) + 1);
+			for(u16 f = 0; f < gfx_be16(features); f ++) {
+				const u8* rec = features + 2 + f * 6;
+				if(memcmp(rec, "kern", 4)) continue;
+				const u8* feature = features + gfx_be16(rec + 4);
+				for(u16 l = 0; l < gfx_be16(feature + 2); l ++) {
+					u16 index = gfx_be16(feature + 4 + l * 2);
+					if(index >= lookup_count || applied[index]) continue;
+					applied[index] = gpos = true;
+					gfx_load_pairpos(face, lookups + gfx_be16(lookups + 2 + index * 2), glyphs, decided);
+				}
+			}
+			GFX_FREE(applied);
+			GFX_FREE(decided);
 		}
+		GFX_FREE(table);
+	}
 
-		gfx_char* ch = hget(gfx_char, face->chars, { point, ctx->font.size });
-		if(!ch) ch = gfx_load_char(ctx->font.cur, point);
-		if(!ch) continue;
+	if(!gpos && FT_HAS_KERNING(face->face)) {
+		FT_Vector k;
+		for(u32 a = 0; a < vlen(glyphs); a ++)
+			for(u32 b = 0; b < vlen(glyphs); b ++)
+				if(!FT_Get_Kerning(face->face, glyphs[a], glyphs[b], FT_KERNING_UNSCALED, &k))
+					gfx_add_kern(face, glyphs[a], glyphs[b], k.x);
+	}
 
-		gfx_atlas* atlas = ctx->atlases + ch->atlas;
-		gfx_slot_hnd slot = gfx_make_tex_available_for_draw(atlas->tex_id);
+	if(face->kern.size) info("Loaded %d kerning pairs for '%s' from %s", face->kern.size, face->name, gpos ? "GPOS" : "kern");
+	vfree(glyphs);
+	PROFILER_ZONE_END
+}
 
-		realx = curx + ch->bearing.x;
-		realy = cury - ch->bearing.y;
-		w     = ch->size.x;
-		h     = ch->size.y;
+// Gets a face's kerning scaled to a size, or NULL if the face doesn't have any. Each size is only scaled once.
+static gfx_kerning* gfx_get_kerning(gfx_face tf, u32 size) {
+	gfx_typeface* face = ctx->share->fonts + tf;
+	if(!face->kern.size) return NULL;
+	for(u32 i = 0; i < vlen(face->kernings); i ++)
+		if(face->kernings[i].size == size) return face->kernings + i;
+
+	// Same pixel size glyphs are rasterized at in gfx_load_glyph
+	gfx_kerning new = { .size = size };
+	f32 scale = size * 4.0f / 3.0f / face->face->units_per_EM;
+	for(ht_int_t i = 0; i < face->kern.n_buckets; i ++) {
+		if(!hexist(face->kern, i)) continue;
+		i16 px = roundf(hval(face->kern, i) * scale);
+		if(px) *hput(gfx_kern, new.pairs, hkey(face->kern, i)) = px;
+	}
 
+	if(!face->kernings) face->kernings = vnew();
+	vpush(face->kernings, new);
+	return face->kernings + vlen(face->kernings) - 1;
+}
 
-		tx = (float) ch->place.x * (float) (UV_X_MAX / (float) (atlas->growth_factor * GFX_ATLAS_START_SIZE));
-		ty = (float) ch->place.y * (float) (UV_Y_MAX / (float) (atlas->growth_factor * GFX_ATLAS_START_SIZE));
-		tw = (float) ch->size.x  * (float) (UV_X_MAX / (float) (atlas->growth_factor * GFX_ATLAS_START_SIZE));
-		th = (float) ch->size.y  * (float) (UV_Y_MAX / (float) (atlas->growth_factor * GFX_ATLAS_START_SIZE));
+// Kerning between two glyphs in pixels. Glyphs that never start a pair are rejected before touching the hash table.
+static inline short gfx_kern(gfx_typeface* face, gfx_kerning* kerning, u32 left, u32 right) {
+	if(!kerning || !left || !(face->kern_left[left >> 6] >> (left & 63) & 1)) return 0;
+	i16* px = hget(gfx_kern, kerning->pairs, GFX_KERN_PAIR(left, right));
+	return px ? *px : 0;
+}
 
-		u32 cur_idx = vlen(ctx->gl.drawbuf.shp);
-		vpusharr(ctx->gl.drawbuf.idx, { cur_idx, cur_idx + 1, cur_idx + 2, cur_idx + 2, cur_idx, cur_idx + 3 });
-		vpusharr(ctx->gl.drawbuf.shp, {
-			{ .x = realx    , .y = realy    , .type = GFX_TEX, .tex_slot = slot - 1, .uv_x = tx,      .uv_y = ty },
-			{ .x = realx + w, .y = realy    , .type = GFX_TEX, .tex_slot = slot - 1, .uv_x = tx + tw, .uv_y = ty },
-			{ .x = realx + w, .y = realy + h, .type = GFX_TEX, .tex_slot = slot - 1, .uv_x = tx + tw, .uv_y = ty + th },
-			{ .x = realx    , .y = realy + h, .type = GFX_TEX, .tex_slot = slot - 1, .uv_x = tx,      .uv_y = ty + th }
-		});
+// The same as gfx_kern with the size's kerning, worked out from the font units, for threads that can't make the table.
+static inline short gfx_kern_units(gfx_typeface* face, f32 px_per_unit, u32 left, u32 right) {
+	if(!face->kern.size || !left || !(face->kern_left[left >> 6] >> (left & 63) & 1)) return 0;
+	i16* units = hget(gfx_kern, face->kern, GFX_KERN_PAIR(left, right));
+	return units ? (i16) roundf(*units * px_per_unit) : 0;
+}
 
-		// Advance cursors for next glyph
-		curx += ch->advance;
+// Builds the face's codepoint coverage from its cmap, so finding a fallback is a bit test instead of a FreeType lookup per face.
+// The glyphs of low codepoints get kept too, for the low codepoint tables.
+static void gfx_load_coverage(gfx_typeface* face) {
+	PROFILER_ZONE_START
+	face->cover_pages = GFX_CALLOC(GFX_COVER_PAGES, sizeof(u16));
+	face->cover_bits = vnew();
+	face->low_glyphs = GFX_CALLOC(GFX_LOW_CODEPOINTS, sizeof(u16));
+
+	FT_UInt glyph;
+	for(FT_ULong c = FT_Get_First_Char(face->face, &glyph); glyph && c < GFX_COVER_PAGES << 8; c = FT_Get_Next_Char(face->face, c, &glyph)) {
+		if(c < GFX_LOW_CODEPOINTS) face->low_glyphs[c] = glyph;
+		u16* page = face->cover_pages + (c >> 8);
+		if(!*page) {
+			memset(vpush_uninit(face->cover_bits, GFX_COVER_WORDS), 0, GFX_COVER_WORDS * sizeof(u64));
+			*page = vlen(face->cover_bits) / GFX_COVER_WORDS;
+		}
+		face->cover_bits[(*page - 1) * GFX_COVER_WORDS + (c >> 6 & 3)] |= 1ull << (c & 63);
 	}
 	PROFILER_ZONE_END
 }
 
+static inline bool gfx_covers(const gfx_typeface* face, u32 point) {
+	if(point >= GFX_COVER_PAGES << 8) return false;
+	u16 page = face->cover_pages[point >> 8];
+	return page && face->cover_bits[(page - 1) * GFX_COVER_WORDS + (point >> 6 & 3)] >> (point & 63) & 1;
+}
 
-void textf(short x, short y, const char* fmt, ...) {
+// Which of the face's fallbacks a codepoint should come from, as a handle into face->fallbacks. 0 means the face itself,
+// which is also what's used when nothing has the codepoint, so it draws the face's .notdef box.
+static inline u32 gfx_pick_fallback(const gfx_typeface* face, u32 point) {
+	if(!vlen(face->fallbacks) || gfx_covers(face, point)) return 0;
+	for(u32 i = 0; i < vlen(face->fallbacks); i ++)
+		if(gfx_covers(ctx->share->fonts + face->fallbacks[i], point)) return i + 1;
+	return 0;
+}
+
+gfx_face gfx_load_font(const char* file) {
 	PROFILER_ZONE_START
+	gfx_typeface new = {
+		.chars = {0},
+		.face = NULL
+	};
 
-	char buf[256] = {0};
-	va_list args;
-	va_start(args, fmt);
-	vsnprintf(buf, 256, fmt, args);
-	va_end(args);
+	// Loads the freetype library.
+	FT_Library* ft = &ctx->share->ft;
+	if(!*ft) CHECK_CALL(FT_Init_FreeType(ft), return -1, "Couldn't initialize freetype");
 
-	text(buf, x, y);
+	// The file is read once and kept, pool threads open their own faces from it, not from a path that can go away
+	char* data = NULL;
+	new.data_len = gfx_read(file, &data);
+	new.data = (u8*) data;
+	CHECK_CALL(!new.data_len || FT_New_Memory_Face(*ft, new.data, new.data_len, 0, &new.face), GFX_FREE(data); return -1, "Couldn't load font '%s'", file);
+	CHECK_CALL(FT_Set_Pixel_Sizes(new.face, 0, RENDERING_FONT_SIZE()), FT_Done_Face(new.face); GFX_FREE(data); return -1, "Couldn't set size");
+
+	// Adds space_width
+	CHECK_CALL(FT_Load_Char(new.face, ' ', FT_LOAD_RENDER), FT_Done_Face(new.face); GFX_FREE(data); return -1, "Couldn't load the Space Character ( )");
+	char* name = GFX_MALLOC(strlen(file) + 1);
+	new.name = strcpy(name, file);
+	new.space_width = new.face->glyph->advance.x >> 6;
+	new.space_glyph = FT_Get_Char_Index(new.face, ' ');
+	gfx_load_kerning(&new);
+	gfx_load_coverage(&new);
+
+	// Stores the font, where growing the store can move the faces draw lists are reading
+	gfx_rwlock_take_write(&ctx->share->fonts_lock);
+	vpush(ctx->share->fonts, new);
+	gfx_rwlock_give_write(&ctx->share->fonts_lock);
+	info("Loaded font '%s'", new.name);
 	PROFILER_ZONE_END
+	return vlen(ctx->share->fonts) - 1;
 }
 
 
-// void load_glyph_buffer(char* str) {
-// 	u32 point;
-// 	while((point = gfx_readutf8((u8**) &str)))
-// 		glyph_ids[glyph_cur++] = str[i];
+// Frees every shaped string of the face, for when something they were shaped with changes.
+static void gfx_shaped_flush(gfx_typeface* face) {
+	for(ht_int_t i = 0; i < face->shaped.n_buckets; i ++)
+		if(hexist(face->shaped, i)) vfree(hval(face->shaped, i).glyphs);
+	hclear(gfx_shaped, face->shaped);
+}
+
+// Turns on GSUB features (ligatures, contextual alternates, etc.) for a face, e.g. gfx_font_features(face, NULL, NULL, "calt liga").
+// Chains are built once per (script, lang, features) and kept around, so switching back and forth is free. NULL/empty features turns shaping off.
+bool gfx_font_features(gfx_face tf, const char* script, const char* lang, const char* features) {
+	if(tf < 0 || (u32) tf >= vlen(ctx->share->fonts)) return false;
+	gfx_typeface* face = ctx->share->fonts + tf;
+
+	// Parses the 4 letter tags out, separated by spaces or commas.
+	unsigned char tags[32][4];
+	u32 n = 0;
+	while(features && *features && n < 32) {
+		if(*features == ' ' || *features == ',') { features ++; continue; }
+		for(int i = 0; i < 4; i ++) tags[n][i] = *features ? *features++ : ' ';
+		n ++;
+	}
 
+	if(!n) {
+		if(face->chain_hnd) gfx_shaped_flush(face);
+		face->chain_hnd = 0;
+		return true;
+	}
 
-// 	u32 len;
-// 	LBT_Glyph* ligated = LBT_apply_chain(glyph_ids, str, glyph_cur, &len);
-// 	for(u32 i = 0; i < len; i ++)
-// 		glyph_ids[i] = ligated[i];
-// 	glyph_cur = len;
-// }
+	unsigned char script_tag[4] = "    ", lang_tag[4] = "    ";
+	if(script) memcpy(script_tag, script, strnlen(script, 4));
+	if(lang)   memcpy(lang_tag, lang, strnlen(lang, 4));
+
+	XXH64_state_t state;
+	XXH64_reset(&state, 764544365);
+	XXH64_update(&state, script_tag, 4);
+	XXH64_update(&state, lang_tag, 4);
+	XXH64_update(&state, tags, n * 4);
+	u64 hash = XXH64_digest(&state);
+
+	u32 old = face->chain_hnd;
+	face->chain_hnd = 0;
+	if(!face->chains) face->chains = vnew();
+	for(u32 i = 0; i < vlen(face->chains); i ++)
+		if(face->chains[i].hash == hash) { face->chain_hnd = i + 1; break; }
+
+	if(!face->chain_hnd) {
+		if(!face->lbt) CHECK_CALL(!(face->lbt = LBT_new(face->face)), return false, "Couldn't read the GSUB table of '%s'", face->name);
+		LBT_Chain* chain = LBT_generate_chain(face->lbt, script ? &script_tag : NULL, lang ? &lang_tag : NULL, tags, n);
+		CHECK_CALL(!chain, return false, "Couldn't generate the GSUB chain for '%s'", face->name);
+		vpush(face->chains, { .hash = hash, .chain = chain });
+		face->chain_hnd = vlen(face->chains);
+		info("Generated GSUB chain #%d for '%s'", face->chain_hnd, face->name);
+	}
+
+	// Shaped strings are only valid for the chain that made them
+	if(old != face->chain_hnd) gfx_shaped_flush(face);
+	return true;
+}
+
+bool gfx_register_fallbacks(gfx_face tf, u32 num, const gfx_face* fallbacks) {
+	if(tf < 0 || (u32) tf >= vlen(ctx->share->fonts)) return false;
+	for(u32 i = 0; i < num; i ++)
+		CHECK_CALL(fallbacks[i] < 0 || (u32) fallbacks[i] >= vlen(ctx->share->fonts) || fallbacks[i] == tf, return false, "Invalid fallback face %d for '%s'", fallbacks[i], ctx->share->fonts[tf].name);
+
+	gfx_typeface* face = ctx->share->fonts + tf;
+	if(!face->fallbacks) face->fallbacks = vnew();
+	vempty(face->fallbacks);
+	for(u32 i = 0; i < num; i ++) vpush(face->fallbacks, fallbacks[i]);
+
+	// Shaped strings have the fallback glyphs baked in
+	gfx_shaped_flush(face);
+	return true;
+}
+
+bool gfx_font_native_raster(gfx_face tf, bool on) {
+	if(tf < 0 || (u32) tf >= vlen(ctx->share->fonts)) return false;
+	ctx->share->fonts[tf].native_raster = on;
+	return true;
+}
+
+bool gfx_font_outlines(gfx_face tf, bool on) {
+	if(tf < 0 || (u32) tf >= vlen(ctx->share->fonts)) return false;
+	ctx->share->fonts[tf].draw_outlines = on;
+	return true;
+}
+
+// Gets the string's glyphs after they've been through the face's chain. Shaping only happens the first time a string is seen.
+static LBT_Glyph* gfx_shape_cached(gfx_face tf, const char* str, u32 len) {
+	gfx_typeface* face = ctx->share->fonts + tf;
+	const char* end = str + len;
+	u64 hash = XXH64(str, len, 764544365);
+
+	gfx_shaped* shaped = hget(gfx_shaped, face->shaped, hash);
+	if(shaped) {
+		shaped->last_used = ctx->frame.count;
+		return shaped->glyphs;
+	}
+
+	PROFILER_ZONE_START
+	LBT_Glyph* glyphs = vnew();
+	LBT_Glyph* line = gfx_frame_vnew();
+	LBT_Chain* chain = face->chains[face->chain_hnd - 1].chain;
+	FT_ULong point;
+	do {
+		point = str < end ? gfx_readutf8((u8**) &str) : 0;
+		u32 fb = point && point != '\n' ? gfx_pick_fallback(face, point) : 0;
+		if(point && point != '\n' && !fb) { vpush(line, FT_Get_Char_Index(face->face, point)); continue; }
+
+		// Lines get shaped separately, since nothing can substitute across them. Neither can glyphs from another face.
+		if(vlen(line)) {
+			size_t outlen;
+			LBT_Glyph* ligated = LBT_apply_chain(chain, line, vlen(line), &outlen);
+			memcpy(vpush_uninit(glyphs, outlen), ligated, outlen * sizeof(LBT_Glyph));
+			free(ligated);
+			vempty(line);
+		}
+		if(fb) vpusharr(glyphs, { GFX_SHAPED_FALLBACK, fb, FT_Get_Char_Index(ctx->share->fonts[face->fallbacks[fb - 1]].face, point) });
+		else if(point) vpush(glyphs, GFX_SHAPED_NEWLINE);
+	} while(point);
+	vfree(line);
+
+	*hput(gfx_shaped, face->shaped, hash) = (gfx_shaped) { .glyphs = glyphs, .last_used = ctx->frame.count };
+	PROFILER_ZONE_END
+	return glyphs;
+}
+
+// Drops shaped strings that haven't been drawn in a while so strings that change every frame don't pile up.
+static void gfx_shaped_evict() {
+	for(u32 f = 0; f < vlen(ctx->share->fonts); f ++) {
+		gfx_typeface* face = ctx->share->fonts + f;
+		for(ht_int_t i = 0; i < face->shaped.n_buckets; i ++) {
+			if(!hexist(face->shaped, i) || ctx->frame.count - hval(face->shaped, i).last_used < GFX_SHAPED_MAX_AGE) continue;
+			vfree(hval(face->shaped, i).glyphs);
+			gfx_shaped_del(&face->shaped, i);
+		}
+	}
+}
+
+void font_size(u32 size) { if(size) ctx->font.size = size; }
+void gfx_font_buckets(f32 ratio, u32 min_size) {
+	ctx->font.bucket_ratio = ratio > 1.0f ? ratio : 0;
+	ctx->font.bucket_min = min_size ? min_size : 1;
+}
+void line_height(f32 h) { if(h > 0) ctx->font.lh = h; }
+void font(gfx_face face, u32 size) {
+	if(face >= 0 && face != ctx->font.cur)
+		ctx->font.cur = face;
+	if(size > 0) ctx->font.size = size;
+}
+
+// Writes the quad for one glyph with its origin (baseline) at x, y, sampling the atlas from the texture slot.
+static inline void gfx_glyph_quad(const gfx_char* ch, f32 x, short y, f32 scale, gfx_slot_hnd slot, struct gfx_vtx_buf* out) {
+	gfx_atlas* atlas = ctx->share->atlases + ch->atlas;
+	short realx = x + ch->bearing.x * scale;
+	short realy = y - ch->bearing.y * scale;
+	short w     = ch->size.x * scale;
+	short h     = ch->size.y * scale;
+
+	// Atlases only grow to the right and down, so the UVs just scale up by how far the atlas is from its biggest size
+	u32 grow = GFX_ATLAS_MAX_GROWTH_FACTOR / atlas->growth_factor;
+	u16 tx = ch->uv_x * grow;
+	u16 ty = ch->uv_y * grow;
+	u16 tw = (float) ch->size.x  * (float) (UV_X_MAX / (float) (atlas->growth_factor * GFX_ATLAS_START_SIZE));
+	u16 th = (float) ch->size.y  * (float) (UV_Y_MAX / (float) (atlas->growth_factor * GFX_ATLAS_START_SIZE));
+
+	out[0] = (struct gfx_vtx_buf) { .x = realx    , .y = realy    , .type = GFX_TEX, .tex_slot = slot - 1, .uv_x = tx,      .uv_y = ty };
+	out[1] = (struct gfx_vtx_buf) { .x = realx + w, .y = realy    , .type = GFX_TEX, .tex_slot = slot - 1, .uv_x = tx + tw, .uv_y = ty };
+	out[2] = (struct gfx_vtx_buf) { .x = realx + w, .y = realy + h, .type = GFX_TEX, .tex_slot = slot - 1, .uv_x = tx + tw, .uv_y = ty + th };
+	out[3] = (struct gfx_vtx_buf) { .x = realx    , .y = realy + h, .type = GFX_TEX, .tex_slot = slot - 1, .uv_x = tx,      .uv_y = ty + th };
+}
+
+// Pushes the quad for one glyph with its origin (baseline) at x, y. Scale is the drawn size over the rasterized size.
+static inline void gfx_emit_glyph(gfx_char* ch, f32 x, short y, f32 scale) {
+	// Can flush the draw buffers, so it goes before anything gets pushed
+	gfx_slot_hnd slot = gfx_make_tex_available_for_draw(ctx->share->atlases[ch->atlas].tex_id);
+
+	u32 cur_idx = vlen(ctx->gl.drawbuf.shp);
+	vpusharr(ctx->gl.drawbuf.idx, { cur_idx, cur_idx + 1, cur_idx + 2, cur_idx + 2, cur_idx, cur_idx + 3 });
+	gfx_glyph_quad(ch, x, y, scale, slot, vpush_uninit(ctx->gl.drawbuf.shp, 4));
+}
+
+// Decomposition state for gfx_get_outline. FreeType gives points in font units, which get turned into ems here so the
+// shader's root finding stays precise.
+struct gfx_outline_pen {
+	f32** curves;
+	f32 x, y, em;
+};
+
+static void gfx_outline_quad(struct gfx_outline_pen* p, f32 cx, f32 cy, f32 x, f32 y) {
+	vpusharr(*p->curves, { p->x * p->em, p->y * p->em, cx * p->em, cy * p->em, x * p->em, y * p->em, 0, 0 });
+	p->x = x, p->y = y;
+}
+static int gfx_outline_move(const FT_Vector* to, void* user) {
+	struct gfx_outline_pen* p = user;
+	p->x = to->x, p->y = to->y;
+	return 0;
+}
+static int gfx_outline_line(const FT_Vector* to, void* user) {
+	struct gfx_outline_pen* p = user;
+	gfx_outline_quad(p, (p->x + to->x) * 0.5f, (p->y + to->y) * 0.5f, to->x, to->y);
+	return 0;
+}
+static int gfx_outline_conic(const FT_Vector* control, const FT_Vector* to, void* user) {
+	gfx_outline_quad(user, control->x, control->y, to->x, to->y);
+	return 0;
+}
+
+// Cubics get split in half, and each half becomes the quadratic whose control point is the average of where the half's
+// two control points would put it. That's well under a font unit off for the curves fonts actually have.
+static int gfx_outline_cubic(const FT_Vector* c1, const FT_Vector* c2, const FT_Vector* to, void* user) {
+	struct gfx_outline_pen* p = user;
+	f32 x0 = p->x, y0 = p->y;
+	f32 mx = (x0 + 3.0f * c1->x + 3.0f * c2->x + to->x) / 8.0f, my = (y0 + 3.0f * c1->y + 3.0f * c2->y + to->y) / 8.0f;
+	f32 ax = (x0 + c1->x) / 2.0f, ay = (y0 + c1->y) / 2.0f;
+	f32 bx = (x0 + 2.0f * c1->x + c2->x) / 4.0f, by = (y0 + 2.0f * c1->y + c2->y) / 4.0f;
+	gfx_outline_quad(p, (3.0f * (ax + bx) - x0 - mx) / 4.0f, (3.0f * (ay + by) - y0 - my) / 4.0f, mx, my);
+
+	f32 cx = (c1->x + 2.0f * c2->x + to->x) / 4.0f, cy = (c1->y + 2.0f * c2->y + to->y) / 4.0f;
+	f32 dx = (c2->x + to->x) / 2.0f, dy = (c2->y + to->y) / 2.0f;
+	gfx_outline_quad(p, (3.0f * (cx + dx) - mx - to->x) / 4.0f, (3.0f * (cy + dy) - my - to->y) / 4.0f, to->x, to->y);
+	return 0;
+}
+
+// Gets a glyph's curves into the outline buffer the first time it's drawn. They're unhinted and in ems, so one copy works
+// for every size.
+static gfx_outline* gfx_get_outline(gfx_face tf, u32 glyph) {
+	static const FT_Outline_Funcs funcs = {
+		.move_to = gfx_outline_move, .line_to = gfx_outline_line,
+		.conic_to = gfx_outline_conic, .cubic_to = gfx_outline_cubic
+	};
+	gfx_typeface* face = ctx->share->fonts + tf;
+	gfx_outline* outline = hget(gfx_outline, face->outlines, glyph);
+	if(outline) return outline;
+
+	PROFILER_ZONE_START
+	CHECK_CALL(FT_Load_Glyph(face->face, glyph, FT_LOAD_NO_SCALE | FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP),
+		PROFILER_ZONE_END; return NULL, "Couldn't load the outline of glyph #%d", glyph);
+	FT_GlyphSlot slot = face->face->glyph;
+	f32 em = 1.0f / face->face->units_per_EM;
+	outline = hput(gfx_outline, face->outlines, glyph);
+	*outline = (gfx_outline) { .advance = slot->advance.x * em, .empty = true };
+	if(slot->format != FT_GLYPH_FORMAT_OUTLINE || !slot->outline.n_points) { PROFILER_ZONE_END; return outline; }
+
+	f32** curves = &ctx->share->curves;
+	u32 header = vlen(*curves) / 4;
+	FT_BBox box;
+	FT_Outline_Get_CBox(&slot->outline, &box);
+	vpusharr(*curves, { box.xMin * em, box.yMin * em, box.xMax * em, box.yMax * em, header + 2, 0, 0, 0 });
+	struct gfx_outline_pen pen = { .curves = curves, .em = em };
+	CHECK_CALL(FT_Outline_Decompose(&slot->outline, &funcs, &pen), vpopto(*curves, header * 4); PROFILER_ZONE_END; return outline, "Couldn't decompose glyph #%d", glyph);
+	(*curves)[header * 4 + 5] = vlen(*curves) / 4 - header - 2;
+
+	outline->header = header;
+	outline->empty = false;
+	PROFILER_ZONE_END
+	return outline;
+}
+
+// Pushes the quad of an outline glyph with its origin (baseline) at x, y, em pixels to the em. The shader places the
+// corners from the glyph's bounding box, so the vertex positions only matter for culling. Returns the advance.
+static f32 gfx_emit_outline(gfx_face tf, u32 glyph, f32 x, f32 y, f32 em) {
+	gfx_outline* outline = gfx_get_outline(tf, glyph);
+	if(!outline) return 0;
+	if(outline->empty) return outline->advance * em;
+
+	// Vertices have 27 bits of uv to say which glyph they're part of
+	if(vlen(ctx->gl.outlines.glyphs) / 4 >= 1 << 25) draw();
+	u32 key = vlen(ctx->gl.outlines.glyphs) / 4 << 2;
+	vpusharr(ctx->gl.outlines.glyphs, { x, y, em, outline->header });
+
+	const f32* box = ctx->share->curves + outline->header * 4;
+	short x0 = x + box[0] * em - 1, x1 = x + box[2] * em + 1;
+	short y0 = y - box[3] * em - 1, y1 = y - box[1] * em + 1;
+	u32 cur_idx = vlen(ctx->gl.drawbuf.shp);
+	vpusharr(ctx->gl.drawbuf.idx, { cur_idx, cur_idx + 1, cur_idx + 2, cur_idx + 2, cur_idx, cur_idx + 3 });
+	vpusharr(ctx->gl.drawbuf.shp, {
+		{ .x = x0, .y = y0, .type = GFX_TEX, .tex_slot = GFX_OUTLINE_SLOT, .uv_x = (key | 2) >> 13, .uv_y = (key | 2) & 0x1FFF },
+		{ .x = x1, .y = y0, .type = GFX_TEX, .tex_slot = GFX_OUTLINE_SLOT, .uv_x = (key | 3) >> 13, .uv_y = (key | 3) & 0x1FFF },
+		{ .x = x1, .y = y1, .type = GFX_TEX, .tex_slot = GFX_OUTLINE_SLOT, .uv_x = (key | 1) >> 13, .uv_y = (key | 1) & 0x1FFF },
+		{ .x = x0, .y = y1, .type = GFX_TEX, .tex_slot = GFX_OUTLINE_SLOT, .uv_x = key >> 13,       .uv_y = key & 0x1FFF }
+	});
+	return outline->advance * em;
+}
+
+// When drawing runs into a glyph that isn't cached, the rest of the string gets rasterized in one batch with it.
+static void gfx_load_rest_of_text(gfx_face tf, const char* str, const char* end, u32 size) {
+	gfx_typeface* face = ctx->share->fonts + tf;
+	u32* keys = gfx_frame_vnew();
+	FT_ULong point;
+	while (str < end && (point = gfx_readutf8((u8**) &str))) {
+		if(point == '\n' || point == ' ') continue;
+		u32 fb = gfx_pick_fallback(face, point);
+		vpush(keys, GFX_RASTER_KEY(fb, FT_Get_Char_Index(fb ? ctx->share->fonts[face->fallbacks[fb - 1]].face : face->face, point)));
+	}
+	gfx_load_run(tf, keys, vlen(keys), size);
+	vfree(keys);
+}
+
+static void gfx_load_rest_of_shaped(gfx_face tf, const LBT_Glyph* glyphs, u32 n, u32 size) {
+	gfx_typeface* face = ctx->share->fonts + tf;
+	u32* keys = gfx_frame_vnew();
+	for(u32 i = 0; i < n; i ++) {
+		if(glyphs[i] == GFX_SHAPED_NEWLINE || glyphs[i] == face->space_glyph) continue;
+		if(glyphs[i] == GFX_SHAPED_FALLBACK) { vpush(keys, GFX_RASTER_KEY(glyphs[i + 1], glyphs[i + 2])); i += 2; }
+		else vpush(keys, GFX_RASTER_KEY(0, glyphs[i]));
+	}
+	gfx_load_run(tf, keys, vlen(keys), size);
+	vfree(keys);
+}
+
+// Draws len bytes of str with the current font, with the baseline of the first line at y.
+static void gfx_text(const char* str, u32 len, short x, short y) {
+	PROFILER_ZONE_START
+
+	gfx_typeface* face = ctx->share->fonts + ctx->font.cur;
+	gfx_kerning* kerning = gfx_get_kerning(ctx->font.cur, ctx->font.size);
+	u32 raster = gfx_font_bucket(ctx->font.size);
+	f32 scale = (f32) ctx->font.size / raster;
+	f32 em = ctx->font.size * 4.0f / 3.0f; // Pixels per em, for outline glyphs
+
+	// There's at most a quad per byte, so none of the pushes below have to grow the draw buffer
+	vreserve(ctx->gl.drawbuf.shp, len * 4);
+	vreserve(ctx->gl.drawbuf.idx, len * 6);
+
+	// Ligatures and such are on, so the string is drawn from its cached glyphs instead
+	if(face->chain_hnd) {
+		LBT_Glyph* glyphs = gfx_shape_cached(ctx->font.cur, str, len);
+		f32 curx = x;
+		short cury = y;
+		u32 prev = 0;
+		bool batched = false;
+		for(u32 i = 0; i < vlen(glyphs); i ++) {
+			if(glyphs[i] == GFX_SHAPED_NEWLINE) {
+				cury += gfx_line_advance(ctx->font.size);
+				curx = x;
+				prev = 0;
+				continue;
+			}
+
+			// Glyphs from a fallback face don't kern with anything
+			if(glyphs[i] == GFX_SHAPED_FALLBACK) {
+				gfx_face fb = face->fallbacks[glyphs[i + 1] - 1];
+				if(face->draw_outlines) {
+					curx += gfx_emit_outline(fb, glyphs[i + 2], curx, cury, em);
+					i += 2;
+					prev = 0;
+					continue;
+				}
+				gfx_char* ch = hget(gfx_char, ctx->share->fonts[fb].chars, { glyphs[i + 2], raster });
+				if(!ch && !batched) batched = true, gfx_load_rest_of_shaped(ctx->font.cur, glyphs + i, vlen(glyphs) - i, raster);
+				if(!ch) ch = gfx_get_glyph(fb, glyphs[i + 2], raster);
+				i += 2;
+				prev = 0;
+				if(!ch) continue;
+				gfx_emit_glyph(ch, curx, cury, scale);
+				curx += ch->advance * scale;
+				continue;
+			}
+
+			curx += gfx_kern(face, kerning, prev, glyphs[i]);
+			prev = glyphs[i];
+			if(glyphs[i] == face->space_glyph) {
+				curx += face->space_width * ctx->font.size * 4 / 3 / RENDERING_FONT_SIZE();
+				continue;
+			}
+
+			if(face->draw_outlines) {
+				curx += gfx_emit_outline(ctx->font.cur, glyphs[i], curx, cury, em);
+				continue;
+			}
+			gfx_char* ch = hget(gfx_char, face->chars, { glyphs[i], raster });
+			if(!ch && !batched) batched = true, gfx_load_rest_of_shaped(ctx->font.cur, glyphs + i, vlen(glyphs) - i, raster);
+			if(!ch) ch = gfx_get_glyph(ctx->font.cur, glyphs[i], raster);
+			if(!ch) continue;
+			gfx_emit_glyph(ch, curx, cury, scale);
+			curx += ch->advance * scale;
+		}
+		PROFILER_ZONE_END
+		return;
+	}
+
+	FT_ULong point;
+	const char *end = str + len, *at;
+	f32 curx = x;
+	short cury = y;
+	u32 prev = 0;
+	bool batched = false;
+	gfx_char* low = face->draw_outlines ? NULL : gfx_low_table(face, raster)->chars;
+	while ((at = str) < end && (point = gfx_readutf8((u8**) &str))) {
+
+		// Newlines in six lines :D
+		if (point == '\n') {
+			cury += gfx_line_advance(ctx->font.size);
+			curx = x;
+			prev = 0;
+			continue;
+		}
+
+		// Most text is the face's own low codepoints, which skip the cmap, the fallbacks and the hash once they're cached
+		if (low && point < GFX_LOW_CODEPOINTS && low[point].loaded) {
+			curx += gfx_kern(face, kerning, prev, face->low_glyphs[point]);
+			prev = face->low_glyphs[point];
+			gfx_emit_glyph(low + point, curx, cury, scale);
+			curx += low[point].advance * scale;
+			continue;
+		}
+
+		// Codepoints the face doesn't have come from the first fallback that does, without kerning
+		u32 fb = point == ' ' ? 0 : gfx_pick_fallback(face, point);
+		gfx_face tf = fb ? face->fallbacks[fb - 1] : ctx->font.cur;
+		u32 glyph = point == ' ' ? face->space_glyph : FT_Get_Char_Index(ctx->share->fonts[tf].face, point);
+		curx += fb ? 0 : gfx_kern(face, kerning, prev, glyph);
+		prev = fb ? 0 : glyph;
+		if(point == ' ') {
+			curx += face->space_width * ctx->font.size * 4 / 3 /*px -> pts*/ / RENDERING_FONT_SIZE();
+			continue;
+		}
+
+		if(face->draw_outlines) {
+			curx += gfx_emit_outline(tf, glyph, curx, cury, em);
+			continue;
+		}
+		gfx_char* ch = hget(gfx_char, ctx->share->fonts[tf].chars, { glyph, raster });
+		if(!ch && !batched) batched = true, gfx_load_rest_of_text(ctx->font.cur, at, end, raster);
+		if(!ch) ch = gfx_get_glyph(tf, glyph, raster);
+		if(!ch) continue;
+		if(low && point < GFX_LOW_CODEPOINTS && face->low_glyphs[point]) gfx_low_fill(low + point, ch);
+		gfx_emit_glyph(ch, curx, cury, scale);
+
+		// Advance cursors for next glyph
+		curx += ch->advance * scale;
+	}
+	PROFILER_ZONE_END
+}
+
+void text(const char* str, short x, short y) {
+	if(vlen(ctx->share->fonts)) gfx_text(str, strlen(str), x, y);
+}
+
+
+void textf(short x, short y, const char* fmt, ...) {
+	PROFILER_ZONE_START
+
+	va_list args, measure;
+	va_start(args, fmt);
+	va_copy(measure, args);
+	int len = vsnprintf(NULL, 0, fmt, measure);
+	va_end(measure);
+	char* buf = gfx_frame_alloc(len + 1);
+	vsnprintf(buf, len + 1, fmt, args);
+	va_end(args);
+
+	text(buf, x, y);
+	gfx_arena_free(&ctx->frame.arena, buf);
+	PROFILER_ZONE_END
+}
+
+// ------ Number Formatting ------ //
+
+// Two digits at a time, so printing a number takes half the divisions
+static const char gfx_digit_pairs[201] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+static const u64 gfx_pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+// Writes v into buf, which needs 20 bytes, and returns how many it wrote.
+static u32 gfx_write_u64(char* buf, u64 v) {
+	char tmp[20], *at = tmp + 20;
+	while(v >= 100) {
+		at -= 2;
+		memcpy(at, gfx_digit_pairs + v % 100 * 2, 2);
+		v /= 100;
+	}
+	if(v >= 10) at -= 2, memcpy(at, gfx_digit_pairs + v * 2, 2);
+	else *--at = '0' + v;
+	u32 len = tmp + 20 - at;
+	memcpy(buf, at, len);
+	return len;
+}
+
+static u32 gfx_write_i64(char* buf, i64 v) {
+	if(v >= 0) return gfx_write_u64(buf, v);
+	*buf = '-';
+	return 1 + gfx_write_u64(buf + 1, -(u64) v);
+}
+
+// Writes v with a fixed number of decimals like %.*f, rounding half up. Needs GFX_F64_LEN bytes, since values past 64 bits
+// get all of their digits. The whole and fractional parts are split before scaling, so only the fraction gets rounded.
+// Values past 64 bits and more than 9 decimals go to snprintf, which counts the NUL it writes in GFX_F64_LEN.
+static u32 gfx_write_f64(char* buf, f64 v, u32 precision) {
+	if(v != v) return memcpy(buf, "nan", 3), 3;
+	u32 len = 0;
+	if(signbit(v)) buf[len ++] = '-', v = -v;
+	if(v == INFINITY) return memcpy(buf + len, "inf", 3), len + 3;
+	if(precision > 9 || v >= 0x1p63) {
+		int n = snprintf(buf + len, GFX_F64_LEN - len, "%.*f", precision > 20 ? 20 : precision, v);
+		return n < 0 ? len : len + min((u32) n, GFX_F64_LEN - 1 - len);
+	}
+
+	u64 whole = v;
+	u64 frac = (v - whole) * gfx_pow10[precision] + 0.5;
+	if(frac >= gfx_pow10[precision]) whole ++, frac -= gfx_pow10[precision];
+	len += gfx_write_u64(buf + len, whole);
+	if(!precision) return len;
+	buf[len ++] = '.';
+
+	// The fraction is written like any other number, then padded out with zeroes in front
+	char digits[20];
+	u32 n = gfx_write_u64(digits, frac);
+	memset(buf + len, '0', precision - n);
+	memcpy(buf + len + precision - n, digits, n);
+	return len + precision;
+}
+
+void text_int(int64_t v, short x, short y) {
+	char buf[24];
+	if(vlen(ctx->share->fonts)) gfx_text(buf, gfx_write_i64(buf, v), x, y);
+}
+
+void text_float(double v, uint32_t precision, short x, short y) {
+	char buf[GFX_F64_LEN];
+	if(vlen(ctx->share->fonts)) gfx_text(buf, gfx_write_f64(buf, v, precision), x, y);
+}
+
+// Formats into buf, which needs 256 + GFX_F64_LEN bytes, and returns how much of it is text, up to 256 bytes
+static u32 gfx_format(char* buf, const gfx_fmt* args, u32 n) {
+	u32 len = 0;
+	for(u32 i = 0; i < n && len < 256; i ++) {
+		switch(args[i].type) {
+			case GFX_FMT_STR: {
+				u32 l = strnlen(args[i].str, 256 - len);
+				memcpy(buf + len, args[i].str, l);
+				len += l;
+			} break;
+			case GFX_FMT_INT: len += gfx_write_i64(buf + len, args[i].i); break;
+			case GFX_FMT_UINT: len += gfx_write_u64(buf + len, args[i].u); break;
+			case GFX_FMT_FLOAT: len += gfx_write_f64(buf + len, args[i].f, args[i].precision); break;
+		}
+	}
+	return min(len, 256);
+}
+
+uint32_t gfx_fmt_write(char* buf, uint32_t size, const gfx_fmt* args, uint32_t n) {
+	if(!size) return 0;
+	char tmp[256 + GFX_F64_LEN];
+	u32 len = min(gfx_format(tmp, args, n), size - 1);
+	memcpy(buf, tmp, len);
+	buf[len] = 0;
+	return len;
+}
+
+void gfx_text_fmt(short x, short y, const gfx_fmt* args, uint32_t n) {
+	PROFILER_ZONE_START
+	char buf[256 + GFX_F64_LEN];
+	u32 len = gfx_format(buf, args, n);
+	if(vlen(ctx->share->fonts)) gfx_text(buf, len, x, y);
+	PROFILER_ZONE_END
+}
+
+// Advance of a glyph without rendering it. Glyphs that are already in the atlas just reuse what text() would use.
+static u16 gfx_load_advance(gfx_face tf, u32 glyph, u32 size) {
+	gfx_typeface* face = ctx->share->fonts + tf;
+	gfx_char* ch = hget(gfx_char, face->chars, { glyph, size });
+	if(ch) return ch->advance;
+
+	FT_Fixed advance;
+	if(!gfx_use_size(face, size)) return 0;
+	CHECK_CALL(FT_Get_Advance(face->face, glyph, FT_LOAD_DEFAULT, &advance), return 0, "Couldn't get the advance of glyph #%d", glyph);
+	return advance >> 16;
+}
+
+// Gets a face's advances at a rasterized size, making the ASCII table the first time the size is measured.
+static gfx_metrics* gfx_get_metrics(gfx_face tf, u32 size) {
+	gfx_typeface* face = ctx->share->fonts + tf;
+	for(u32 i = 0; i < vlen(face->metrics); i ++)
+		if(face->metrics[i].size == size) return face->metrics + i;
+
+	PROFILER_ZONE_START
+	gfx_metrics new = { .size = size };
+	for(u32 c = 0; c < 128; c ++) {
+		new.ascii[c].glyph = FT_Get_Char_Index(face->face, c);
+		new.ascii[c].advance = gfx_load_advance(tf, new.ascii[c].glyph, size);
+	}
+
+	if(!face->metrics) face->metrics = vnew();
+	vpush(face->metrics, new);
+	PROFILER_ZONE_END
+	return face->metrics + vlen(face->metrics) - 1;
+}
+
+static inline u16 gfx_glyph_advance(gfx_face tf, gfx_metrics* metrics, u32 glyph) {
+	u16* advance = hget(gfx_adv, metrics->glyphs, glyph);
+	return advance ? *advance : (*hput(gfx_adv, metrics->glyphs, glyph) = gfx_load_advance(tf, glyph, metrics->size));
+}
+
+// Walks a string exactly like text() does, but only adds up the advances. Writes the width of the first `max` lines
+// and the widest one, and returns how many lines there are.
+static u32 gfx_measure(gfx_face tf, u32 size, const char* str, u32 len, f32* widths, u32 max, f32* widest) {
+	gfx_typeface* face = ctx->share->fonts + tf;
+	gfx_kerning* kerning = gfx_get_kerning(tf, size);
+	u32 raster = gfx_font_bucket(size);
+	f32 scale = (f32) size / raster;
+	u32 space = face->space_width * size * 4 / 3 / RENDERING_FONT_SIZE();
+	gfx_metrics* metrics = gfx_get_metrics(tf, raster);
+
+	f32 curx = 0;
+	u32 lines = 0, prev = 0;
+	*widest = 0;
+
+	if(face->chain_hnd) {
+		LBT_Glyph* glyphs = gfx_shape_cached(tf, str, len);
+		for(u32 i = 0; i < vlen(glyphs); i ++) {
+			if(glyphs[i] == GFX_SHAPED_NEWLINE) {
+				if(lines < max) widths[lines] = curx;
+				if(curx > *widest) *widest = curx;
+				lines ++;
+				curx = 0;
+				prev = 0;
+				continue;
+			}
+			if(glyphs[i] == GFX_SHAPED_FALLBACK) {
+				gfx_face fb = face->fallbacks[glyphs[i + 1] - 1];
+				curx += gfx_glyph_advance(fb, gfx_get_metrics(fb, raster), glyphs[i + 2]) * scale;
+				i += 2;
+				prev = 0;
+				continue;
+			}
+
+			curx += gfx_kern(face, kerning, prev, glyphs[i]);
+			prev = glyphs[i];
+			curx += glyphs[i] == face->space_glyph ? space : gfx_glyph_advance(tf, metrics, glyphs[i]) * scale;
+		}
+	}
+	else {
+		FT_ULong point;
+		const char* end = str + len;
+		while (str < end && (point = gfx_readutf8((u8**) &str))) {
+			if (point == '\n') {
+				if(lines < max) widths[lines] = curx;
+				if(curx > *widest) *widest = curx;
+				lines ++;
+				curx = 0;
+				prev = 0;
+				continue;
+			}
+
+			u32 fb = point == ' ' ? 0 : gfx_pick_fallback(face, point);
+			if(fb) {
+				gfx_face used = face->fallbacks[fb - 1];
+				curx += gfx_glyph_advance(used, gfx_get_metrics(used, raster), FT_Get_Char_Index(ctx->share->fonts[used].face, point)) * scale;
+				prev = 0;
+				continue;
+			}
+
+			// ASCII never has to go through FreeType or the hash table
+			u32 glyph = point < 128 ? metrics->ascii[point].glyph : FT_Get_Char_Index(face->face, point);
+			if(point == ' ') glyph = face->space_glyph;
+			curx += gfx_kern(face, kerning, prev, glyph);
+			prev = glyph;
+			if(point == ' ') curx += space;
+			else curx += (point < 128 ? metrics->ascii[point].advance : gfx_glyph_advance(tf, metrics, glyph)) * scale;
+		}
+	}
+
+	if(lines < max) widths[lines] = curx;
+	if(curx > *widest) *widest = curx;
+	return lines + 1;
+}
+
+void text_measure(const char* str, f32* w, f32* h) {
+	f32 widest = 0;
+	u32 lines = 0;
+	if(vlen(ctx->share->fonts)) {
+		PROFILER_ZONE_START
+		lines = gfx_measure(ctx->font.cur, ctx->font.size, str, strlen(str), NULL, 0, &widest);
+		PROFILER_ZONE_END
+	}
+
+	// Every line after the first moves down as much as text() moves it
+	if(w) *w = widest;
+	if(h) *h = lines ? (lines - 1) * gfx_line_advance(ctx->font.size) + ctx->font.size * 4.0f / 3.0f : 0;
+}
+
+u32 text_line_widths(const char* str, f32* widths, u32 max) {
+	if(!vlen(ctx->share->fonts)) return 0;
+	PROFILER_ZONE_START
+	f32 widest;
+	u32 lines = gfx_measure(ctx->font.cur, ctx->font.size, str, strlen(str), widths, max, &widest);
+	PROFILER_ZONE_END
+	return lines;
+}
+
+// Breaks a paragraph-less stretch of text into lines greedily, starting at byte `from`, which has to be where a line
+// starts. Words that don't even fit on a line of their own get broken between characters.
+static void gfx_layout_lines(gfx_layout* layout, const char* str, u32 from, u32 len) {
+	gfx_face tf = layout->face;
+	u32 size = layout->size;
+	u32 start = from;
+
+	while(true) {
+		const char* nl = memchr(str + start, '\n', len - start);
+		u32 para_end = nl ? nl - str : len;
+		u32 end = para_end;
+
+		if(layout->wrap) {
+			f32 linew = 0, segw;
+			u32 pos = start;
+			while(pos < para_end) {
+				// Each step takes the spaces before a word and the word itself
+				u32 next = pos;
+				while(next < para_end && str[next] == ' ') next ++;
+				while(next < para_end && str[next] != ' ') next ++;
+				gfx_measure(tf, size, str + pos, next - pos, NULL, 0, &segw);
+				if(linew + segw <= layout->w) { linew += segw; pos = next; continue; }
+
+				// Too long for any line, so it's cut wherever the line fills up, with at least one character per line
+				if(pos == start) {
+					while(pos < next) {
+						const char* c = str + pos;
+						gfx_readutf8((u8**) &c);
+						gfx_measure(tf, size, str + pos, c - str - pos, NULL, 0, &segw);
+						if(linew + segw > layout->w && pos > start) break;
+						linew += segw;
+						pos = c - str;
+					}
+				}
+				break;
+			}
+			end = pos;
+		}
+
+		f32 width;
+		gfx_measure(tf, size, str + start, end - start, NULL, 0, &width);
+		vpush(layout->lines, { .start = start, .end = end, .width = width });
+		ctx->stats.layout_lines ++;
+
+		// Soft breaks swallow the spaces they happen at, hard ones the newline. Spaces running up to the end of the
+		// paragraph don't start a line of their own.
+		if(end < para_end) {
+			start = end;
+			while(start < para_end && str[start] == ' ') start ++;
+			if(start < para_end) continue;
+		}
+		if(nl) start = para_end + 1;
+		else break;
+	}
+}
+
+// Gets the layout of a text_box() call, only redoing the lines from the one before the first changed byte onwards.
+static gfx_layout* gfx_get_layout(const char* str, short w, bool wrap) {
+	u32 len = strlen(str);
+	gfx_layout* layout = hget(gfx_layout, ctx->font.layouts, (u64) str);
+	if(!layout) {
+		layout = hput(gfx_layout, ctx->font.layouts, (u64) str);
+		*layout = (gfx_layout) { .text = vnew(), .lines = vnew() };
+	}
+	layout->last_used = ctx->frame.count;
+
+	u32 from = 0, keep = 0;
+	if(vlen(layout->lines) && layout->face == ctx->font.cur && layout->size == ctx->font.size && layout->w == w && layout->wrap == wrap) {
+		u32 old = vlen(layout->text);
+		while(from < old && from < len && layout->text[from] == str[from]) from ++;
+		if(from == old && from == len) return layout;
+
+		// The line before the change is redone too, since the changed line's first word might fit on it now
+		while(keep < vlen(layout->lines) && layout->lines[keep].end < from) keep ++;
+		if(keep) keep --;
+		from = keep < vlen(layout->lines) ? layout->lines[keep].start : 0;
+	}
+	else from = 0;
+
+	PROFILER_ZONE_START
+	layout->face = ctx->font.cur;
+	layout->size = ctx->font.size;
+	layout->w = w;
+	layout->wrap = wrap;
+	vpopto(layout->lines, keep);
+	vempty(layout->text);
+	memcpy(vpush_uninit(layout->text, len), str, len);
+	gfx_layout_lines(layout, str, from, len);
+	PROFILER_ZONE_END
+	return layout;
+}
+
+// Drops the layouts of strings that haven't been drawn in a while.
+static void gfx_layouts_evict() {
+	for(ht_int_t i = 0; i < ctx->font.layouts.n_buckets; i ++) {
+		if(!hexist(ctx->font.layouts, i) || ctx->frame.count - hval(ctx->font.layouts, i).last_used < GFX_LAYOUT_MAX_AGE) continue;
+		vfree(hval(ctx->font.layouts, i).text);
+		vfree(hval(ctx->font.layouts, i).lines);
+		gfx_layout_del(&ctx->font.layouts, i);
+	}
+}
+
+u32 text_box_line_widths(const char* str, short w, bool wrap, f32* widths, u32 max) {
+	if(!vlen(ctx->share->fonts) || !str) return 0;
+	gfx_layout* layout = gfx_get_layout(str, w, wrap);
+	for(u32 i = 0; i < vlen(layout->lines) && i < max; i ++) widths[i] = layout->lines[i].width;
+	return vlen(layout->lines);
+}
+
+void text_box(const char* str, short x, short y, short w, short h, gfx_text_align align, bool wrap) {
+	if(!vlen(ctx->share->fonts) || !str) return;
+	PROFILER_ZONE_START
+	gfx_layout* layout = gfx_get_layout(str, w, wrap);
+	FT_Face ft_face = ctx->share->fonts[ctx->font.cur].face;
+
+	// y is the top of the box, so the first baseline is the font's ascent below it
+	f32 px = ctx->font.size * 4.0f / 3.0f;
+	short ascent = ft_face->ascender * px / ft_face->units_per_EM;
+	short line = gfx_line_advance(ctx->font.size);
+
+	for(u32 i = 0; i < vlen(layout->lines); i ++) {
+		if(h > 0 && i * line + px > h) break;
+		gfx_line* l = layout->lines + i;
+		short offset = align == GFX_ALIGN_RIGHT ? w - l->width : align == GFX_ALIGN_CENTER ? (w - l->width) / 2 : 0;
+		gfx_text(str + l->start, l->end - l->start, x + offset, y + ascent + i * line);
+	}
+	PROFILER_ZONE_END
+}
+
+// ------ Text Slots ------ //
+
+static inline u32 gfx_count_points(const char* str, const char* end) {
+	u32 n = 0;
+	while(str < end && gfx_readutf8((u8**) &str)) n ++;
+	return n;
+}
+
+// Remembers which texture slot an atlas was in when a quad was made for it.
+static void gfx_slot_note_atlas(gfx_text_slot* s, u8 atlas, gfx_slot_hnd slot) {
+	for(u32 i = 0; i < vlen(s->atlases); i ++)
+		if(s->atlases[i].atlas == atlas) { s->atlases[i].slot = slot; return; }
+	vpush(s->atlases, { atlas, slot });
+}
+
+// Lays out the codepoints of text[from, to) as entries i onwards of chars and verts, which already have room for them.
+// Works like text() does, returning the pen after the last codepoint, with y and prev left for whatever comes next.
+static f32 gfx_slot_layout(gfx_text_slot* s, u32 i, u32 from, u32 to, f32 pen, short* y, u32* prev) {
+	gfx_typeface* face = ctx->share->fonts + s->face;
+	gfx_kerning* kerning = gfx_get_kerning(s->face, s->size);
+	gfx_char* low = gfx_low_table(face, s->raster)->chars;
+	f32 scale = (f32) s->size / s->raster;
+
+	FT_ULong point;
+	const char *str = s->text + from, *end = s->text + to, *at;
+	bool batched = false;
+	for(; (at = str) < end && (point = gfx_readutf8((u8**) &str)); i ++) {
+		struct gfx_slot_char* c = s->chars + i;
+		struct gfx_vtx_buf* v = s->verts + i * 4;
+		*c = (struct gfx_slot_char) { .byte = at - s->text };
+		memset(v, 0, 4 * sizeof(*v));
+
+		if(point == '\n') {
+			*y += gfx_line_advance(s->size);
+			pen = c->x = c->after = s->x;
+			*prev = 0;
+			continue;
+		}
+
+		gfx_char* ch = NULL;
+		u32 fb = 0, glyph;
+		gfx_face tf = s->face;
+		if(point < GFX_LOW_CODEPOINTS && low[point].loaded) ch = low + point, glyph = face->low_glyphs[point];
+		else {
+			fb = point == ' ' ? 0 : gfx_pick_fallback(face, point);
+			tf = fb ? face->fallbacks[fb - 1] : s->face;
+			glyph = point == ' ' ? face->space_glyph : FT_Get_Char_Index(ctx->share->fonts[tf].face, point);
+		}
+		pen += fb ? 0 : gfx_kern(face, kerning, *prev, glyph);
+		*prev = fb ? 0 : glyph;
+		c->glyph = *prev;
+		c->x = pen;
+		if(point == ' ') {
+			pen += face->space_width * s->size * 4 / 3 / RENDERING_FONT_SIZE();
+			c->after = pen;
+			continue;
+		}
+
+		if(!ch) {
+			ch = hget(gfx_char, ctx->share->fonts[tf].chars, { glyph, s->raster });
+			if(!ch && !batched) batched = true, gfx_load_rest_of_text(s->face, at, end, s->raster);
+			if(!ch) ch = gfx_get_glyph(tf, glyph, s->raster);
+			if(ch && !fb && point < GFX_LOW_CODEPOINTS && face->low_glyphs[point]) gfx_low_fill(low + point, ch);
+		}
+		if(ch) {
+			gfx_slot_hnd slot = gfx_make_tex_available_for_draw(ctx->share->atlases[ch->atlas].tex_id);
+			gfx_glyph_quad(ch, pen, *y, scale, slot, v);
+			gfx_slot_note_atlas(s, ch->atlas, slot);
+			c->quad = true;
+			c->left = ch->bearing.x * scale;
+			pen += ch->advance * scale;
+		}
+		c->after = pen;
+	}
+	return pen;
+}
+
+// Remakes every quad, for when the size's bucket, the atlases or their texture slots changed under the slot.
+static void gfx_slot_rebuild(gfx_text_slot* s) {
+	PROFILER_ZONE_START
+	u32 len = vlen(s->text), n = gfx_count_points(s->text, s->text + len);
+	vempty(s->chars);
+	vempty(s->verts);
+	vempty(s->atlases);
+	vpush_uninit(s->chars, n);
+	vpush_uninit(s->verts, n * 4);
+	s->raster = gfx_font_bucket(s->size);
+	s->growths = ctx->share->atlas_growths;
+
+	short y = s->y;
+	u32 prev = 0;
+	gfx_slot_layout(s, 0, 0, len, s->x, &y, &prev);
+	PROFILER_ZONE_END
+}
+
+static inline gfx_text_slot* gfx_get_slot(gfx_textslot hnd) {
+	if(hnd < 0 || (u32) hnd >= vlen(ctx->font.slots) || !ctx->font.slots[hnd].used) return NULL;
+	return ctx->font.slots + hnd;
+}
+
+// Faces that shape or draw outlines don't use the quads, their text just goes through text() when it's drawn
+static inline bool gfx_slot_uses_quads(gfx_text_slot* s) {
+	gfx_typeface* face = ctx->share->fonts + s->face;
+	return !face->chain_hnd && !face->draw_outlines;
+}
+
+gfx_textslot gfx_textslot_new(gfx_face face, u32 size, short x, short y) {
+	if(face < 0 || (u32) face >= vlen(ctx->share->fonts) || !size) return -1;
+
+	u32 i = 0;
+	while(i < vlen(ctx->font.slots) && ctx->font.slots[i].used) i ++;
+	if(i == vlen(ctx->font.slots)) vpush(ctx->font.slots, {0});
+	ctx->font.slots[i] = (gfx_text_slot) {
+		.text = vnew(), .chars = vnew(), .verts = vnew(), .atlases = vnew(),
+		.face = face, .size = size, .x = x, .y = y, .used = true
+	};
+	return i;
+}
+
+void gfx_textslot_free(gfx_textslot hnd) {
+	gfx_text_slot* s = gfx_get_slot(hnd);
+	if(!s) return;
+	vfree(s->text);
+	vfree(s->chars);
+	vfree(s->verts);
+	vfree(s->atlases);
+	s->used = false;
+}
+
+void gfx_textslot_set(gfx_textslot hnd, const char* str) {
+	gfx_text_slot* s = gfx_get_slot(hnd);
+	if(!s) return;
+	u32 len = strlen(str), old = vlen(s->text);
+
+	// The bytes that stayed the same at both ends, cut back to whole codepoints
+	u32 pre = 0, suf = 0;
+	while(pre < old && pre < len && s->text[pre] == str[pre]) pre ++;
+	if(pre == old && pre == len) return;
+	while(pre && (str[pre] & 0xC0) == 0x80) pre --;
+	while(suf < old - pre && suf < len - pre && s->text[old - 1 - suf] == str[len - 1 - suf]) suf ++;
+	while(suf && (str[len - suf] & 0xC0) == 0x80) suf --;
+
+	// Newlines in the part that changed, to see how far the lines after it move
+	i32 lines = 0;
+	for(u32 i = pre; i < old - suf; i ++) lines -= s->text[i] == '\n';
+	for(u32 i = pre; i < len - suf; i ++) lines += str[i] == '\n';
+
+	vempty(s->text);
+	memcpy(vpush_uninit(s->text, len), str, len);
+	if(!gfx_slot_uses_quads(s) || s->raster != gfx_font_bucket(s->size) || s->growths != ctx->share->atlas_growths) {
+		if(gfx_slot_uses_quads(s)) gfx_slot_rebuild(s);
+		else s->raster = 0;
+		return;
+	}
+	PROFILER_ZONE_START
+
+	// Entries [keep, tail) are the codepoints that changed, which get replaced by `add` new ones
+	u32 n = vlen(s->chars), keep = 0, tail;
+	while(keep < n && s->chars[keep].byte < pre) keep ++;
+	for(tail = keep; tail < n && s->chars[tail].byte < old - suf; tail ++);
+	u32 add = gfx_count_points(str + pre, str + len - suf), total = keep + add + n - tail;
+
+	if(total > n) {
+		vpush_uninit(s->chars, total - n);
+		vpush_uninit(s->verts, (total - n) * 4);
+	}
+	memmove(s->chars + keep + add, s->chars + tail, (n - tail) * sizeof(*s->chars));
+	memmove(s->verts + (keep + add) * 4, s->verts + tail * 4, (n - tail) * 4 * sizeof(*s->verts));
+	if(total < n) {
+		vpopto(s->chars, total);
+		vpopto(s->verts, total * 4);
+	}
+	for(u32 i = keep + add; i < total; i ++) s->chars[i].byte += len - old;
+
+	// The changed codepoints pick up where the ones before them left off
+	short y = s->y;
+	for(u32 i = 0; i < pre; i ++) y += str[i] == '\n' ? gfx_line_advance(s->size) : 0;
+	u32 prev = keep ? s->chars[keep - 1].glyph : 0;
+	f32 pen = gfx_slot_layout(s, keep, pre, len - suf, keep ? s->chars[keep - 1].after : s->x, &y, &prev);
+
+	// The rest keep their quads, the line they're on only moves over by however much the changed part grew
+	f32 dx = 0;
+	short dy = lines * gfx_line_advance(s->size);
+	u32 i = keep + add;
+	if(i < total && str[s->chars[i].byte] != '\n') {
+		gfx_kerning* kerning = gfx_get_kerning(s->face, s->size);
+		dx = pen + gfx_kern(ctx->share->fonts + s->face, kerning, prev, s->chars[i].glyph) - s->chars[i].x;
+	}
+	for(; i < total && (dx || dy); i ++) {
+		struct gfx_slot_char* c = s->chars + i;
+		struct gfx_vtx_buf* v = s->verts + i * 4;
+		if(str[c->byte] == '\n') dx = 0;
+		c->x += dx;
+		c->after += dx;
+		if(!c->quad) continue;
+
+		short w = v[1].x - v[0].x;
+		v[0].x = v[3].x = (short) (c->x + c->left);
+		v[1].x = v[2].x = v[0].x + w;
+		for(u32 j = 0; j < 4; j ++) v[j].y += dy;
+	}
+	PROFILER_ZONE_END
+}
+
+void gfx_textslot_move(gfx_textslot hnd, short x, short y) {
+	gfx_text_slot* s = gfx_get_slot(hnd);
+	if(!s) return;
+	short dx = x - s->x, dy = y - s->y;
+	for(u32 i = 0; i < vlen(s->chars); i ++) {
+		s->chars[i].x += dx;
+		s->chars[i].after += dx;
+		if(!s->chars[i].quad) continue;
+		for(u32 j = 0; j < 4; j ++) s->verts[i * 4 + j].x += dx, s->verts[i * 4 + j].y += dy;
+	}
+	s->x = x, s->y = y;
+}
+
+void gfx_textslot_draw(gfx_textslot hnd) {
+	gfx_text_slot* s = gfx_get_slot(hnd);
+	if(!s || !vlen(s->text)) return;
+	PROFILER_ZONE_START
+
+	if(!gfx_slot_uses_quads(s)) {
+		gfx_face oldface = ctx->font.cur;
+		u32 oldsize = ctx->font.size;
+		font(s->face, s->size);
+		gfx_text(s->text, vlen(s->text), s->x, s->y);
+		font(oldface, oldsize);
+		PROFILER_ZONE_END
+		return;
+	}
+
+	// The atlases have to still be in the texture slots the quads point at, otherwise it's all remade
+	bool stale = s->raster != gfx_font_bucket(s->size) || s->growths != ctx->share->atlas_growths;
+	for(u32 i = 0; i < vlen(s->atlases) && !stale; i ++)
+		stale = gfx_make_tex_available_for_draw(ctx->share->atlases[s->atlases[i].atlas].tex_id) != s->atlases[i].slot;
+	for(u32 i = 0; i < vlen(s->atlases) && !stale; i ++)
+		stale = gfx_tex(ctx->share->atlases[s->atlases[i].atlas].tex_id)->slot != s->atlases[i].slot;
+	if(stale) gfx_slot_rebuild(s);
+
+	u32 n = vlen(s->chars), base = vlen(ctx->gl.drawbuf.shp);
+	vreserve(ctx->gl.drawbuf.idx, n * 6);
+	for(u32 i = 0; i < n; i ++) {
+		if(!s->chars[i].quad) continue;
+		u32 at = base + i * 4;
+		vpusharr(ctx->gl.drawbuf.idx, { at, at + 1, at + 2, at + 2, at, at + 3 });
+	}
+	memcpy(vpush_uninit(ctx->gl.drawbuf.shp, n * 4), s->verts, n * 4 * sizeof(*s->verts));
+	PROFILER_ZONE_END
+}
+
+// How far a glyph moves the cursor at a size. Faces drawn as outlines get it from the outline, so nothing gets rasterized.
+static bool gfx_shape_advance(bool outlines, gfx_face tf, u32 glyph, u32 size, f32* advance) {
+	if(outlines) {
+		gfx_outline* outline = gfx_get_outline(tf, glyph);
+		if(outline) *advance = outline->advance * size * 4.0f / 3.0f;
+		return outline;
+	}
+	u32 raster = gfx_font_bucket(size);
+	gfx_char* ch = gfx_get_glyph(tf, glyph, raster);
+	if(ch) *advance = ch->advance * (f32) size / raster;
+	return ch;
+}
+
+// Converts a string into glyph IDs + positions once, so they can be drawn with text_glyphs() as many times as needed.
+// Spaces and newlines are turned into positions, they don't produce glyphs.
+u32 gfx_shape(gfx_face tf, u32 size, const char* str, gfx_glyph* out, u32 max) {
+	if(tf < 0 || (u32) tf >= vlen(ctx->share->fonts) || !size) return 0;
+	PROFILER_ZONE_START
+
+	gfx_typeface* face = ctx->share->fonts + tf;
+	gfx_kerning* kerning = gfx_get_kerning(tf, size);
+	FT_ULong point;
+	f32 curx = 0;
+	short cury = 0;
+	u32 n = 0, prev = 0;
+
+	if(face->chain_hnd) {
+		LBT_Glyph* glyphs = gfx_shape_cached(tf, str, strlen(str));
+		for(u32 i = 0; i < vlen(glyphs) && n < max; i ++) {
+			if(glyphs[i] == GFX_SHAPED_NEWLINE) {
+				cury += gfx_line_advance(size);
+				curx = 0;
+				prev = 0;
+				continue;
+			}
+
+			if(glyphs[i] == GFX_SHAPED_FALLBACK) {
+				u16 fb = glyphs[i + 1], glyph = glyphs[i + 2];
+				f32 advance;
+				i += 2;
+				prev = 0;
+				if(!gfx_shape_advance(face->draw_outlines, face->fallbacks[fb - 1], glyph, size, &advance)) continue;
+				out[n ++] = (gfx_glyph) { .id = glyph, .x = curx, .y = cury, .fallback = fb };
+				curx += advance;
+				continue;
+			}
+
+			curx += gfx_kern(face, kerning, prev, glyphs[i]);
+			prev = glyphs[i];
+			if(glyphs[i] == face->space_glyph) {
+				curx += face->space_width * size * 4 / 3 / RENDERING_FONT_SIZE();
+				continue;
+			}
+
+			f32 advance;
+			if(!gfx_shape_advance(face->draw_outlines, tf, glyphs[i], size, &advance)) continue;
+			out[n ++] = (gfx_glyph) { .id = glyphs[i], .x = curx, .y = cury };
+			curx += advance;
+		}
+		PROFILER_ZONE_END
+		return n;
+	}
+
+	while (n < max && (point = gfx_readutf8((u8**) &str))) {
+		if (point == '\n') {
+			cury += gfx_line_advance(size);
+			curx = 0;
+			prev = 0;
+			continue;
+		}
+
+		u32 fb = point == ' ' ? 0 : gfx_pick_fallback(face, point);
+		gfx_face used = fb ? face->fallbacks[fb - 1] : tf;
+		u32 glyph = point == ' ' ? face->space_glyph : FT_Get_Char_Index(ctx->share->fonts[used].face, point);
+		curx += fb ? 0 : gfx_kern(face, kerning, prev, glyph);
+		prev = fb ? 0 : glyph;
+		if(point == ' ') {
+			curx += face->space_width * size * 4 / 3 / RENDERING_FONT_SIZE();
+			continue;
+		}
+
+		f32 advance;
+		if(!gfx_shape_advance(face->draw_outlines, used, glyph, size, &advance)) continue;
+
+		out[n ++] = (gfx_glyph) { .id = glyph, .x = curx, .y = cury, .fallback = fb };
+		curx += advance;
+	}
+	PROFILER_ZONE_END
+	return n;
+}
+
+void text_glyphs(gfx_face tf, u32 size, const gfx_glyph* glyphs, u32 n, short x, short y) {
+	if(tf < 0 || (u32) tf >= vlen(ctx->share->fonts) || !size) return;
+	PROFILER_ZONE_START
+
+	gfx_typeface* face = ctx->share->fonts + tf;
+	u32 raster = gfx_font_bucket(size);
+	f32 scale = (f32) size / raster;
+	bool batched = false;
+	vreserve(ctx->gl.drawbuf.shp, n * 4);
+	vreserve(ctx->gl.drawbuf.idx, n * 6);
+	for(u32 i = 0; i < n; i ++) {
+		gfx_face used = glyphs[i].fallback && glyphs[i].fallback <= vlen(face->fallbacks) ? face->fallbacks[glyphs[i].fallback - 1] : tf;
+		if(face->draw_outlines) {
+			gfx_emit_outline(used, glyphs[i].id, x + glyphs[i].x, y + glyphs[i].y, size * 4.0f / 3.0f);
+			continue;
+		}
+		gfx_char* ch = hget(gfx_char, ctx->share->fonts[used].chars, { glyphs[i].id, raster });
+		if(!ch && !batched) {
+			batched = true;
+			u32* keys = gfx_frame_vnew();
+			for(u32 j = i; j < n; j ++)
+				if(glyphs[j].fallback <= vlen(face->fallbacks)) vpush(keys, GFX_RASTER_KEY(glyphs[j].fallback, glyphs[j].id));
+			gfx_load_run(tf, keys, vlen(keys), raster);
+			vfree(keys);
+		}
+		if(!ch) ch = gfx_get_glyph(used, glyphs[i].id, raster);
+		if(ch) gfx_emit_glyph(ch, x + glyphs[i].x, y + glyphs[i].y, scale);
+	}
+	PROFILER_ZONE_END
+}
+
+void gfx_preload_glyphs(gfx_face tf, u32 size, const gfx_range* ranges, u32 n) {
+	if(tf < 0 || (u32) tf >= vlen(ctx->share->fonts) || !size) return;
+	PROFILER_ZONE_START
+	gfx_typeface* face = ctx->share->fonts + tf;
+	u32* keys = gfx_frame_vnew();
+	for(u32 r = 0; r < n; r ++) {
+		for(u32 point = ranges[r].first; point <= ranges[r].last; point ++) {
+			u32 fb = gfx_pick_fallback(face, point);
+			u32 glyph = FT_Get_Char_Index(fb ? ctx->share->fonts[face->fallbacks[fb - 1]].face : face->face, point);
+			if(glyph) vpush(keys, GFX_RASTER_KEY(fb, glyph));
+		}
+	}
+	gfx_load_run(tf, keys, vlen(keys), gfx_font_bucket(size));
+	vfree(keys);
+	PROFILER_ZONE_END
+}
+
+// ------ Draw Lists ------ //
+
+gfx_drawlist* gfx_drawlist_new(i32 layer) {
+	gfx_drawlist* list = GFX_MALLOC(sizeof(gfx_drawlist));
+	*list = (gfx_drawlist) {
+		.ctx = ctx, .items = vnew(), .glyphs = vnew(), .strs = vnew(),
+		.col = ctx->curcol, .face = ctx->font.cur, .size = ctx->font.size,
+		.layer = layer, .made = ctx->lists.made ++
+	};
+	return list;
+}
+
+void gfx_drawlist_free(gfx_drawlist* list) {
+	vfree(list->items);
+	vfree(list->glyphs);
+	vfree(list->strs);
+	GFX_FREE(list);
+}
+
+void gfx_drawlist_clear(gfx_drawlist* list) {
+	vempty(list->items);
+	vempty(list->glyphs);
+	vempty(list->strs);
+}
+
+void gfx_drawlist_submit(gfx_drawlist* list) {
+	gfx_drawlist** at = cvec_push(&list->ctx->lists.queue, 1);
+	if(at) *at = list;
+}
+
+void gfx_drawlist_fill(gfx_drawlist* list, u8 r, u8 g, u8 b, u8 a) {
+	list->col = (gfx_color) { .r = r, .g = g, .b = b, .a = a };
+}
+
+void gfx_drawlist_font(gfx_drawlist* list, gfx_face face, u32 size) {
+	if(face >= 0) list->face = face;
+	if(size > 0) list->size = size;
+}
+
+void gfx_drawlist_quad(gfx_drawlist* list, short x1, short y1, short x2, short y2, short x3, short y3, short x4, short y4) {
+	vpush(list->items, { .type = GFX_ITEM_QUAD, .quad = {
+		{ .x = x1, .y = y1, .type = GFX_FULL, .col = { .full = list->col.full } },
+		{ .x = x2, .y = y2, .type = GFX_FULL, .col = { .full = list->col.full } },
+		{ .x = x3, .y = y3, .type = GFX_FULL, .col = { .full = list->col.full } },
+		{ .x = x4, .y = y4, .type = GFX_FULL, .col = { .full = list->col.full } }
+	} });
+}
+
+void gfx_drawlist_rect(gfx_drawlist* list, short x, short y, short w, short h) {
+	gfx_drawlist_quad(list, x, y, x + w, y, x + w, y + h, x, y + h);
+}
+
+void gfx_drawlist_image(gfx_drawlist* list, gfx_img img, short x, short y, short w, short h) {
+	if(img >= 0) vpush(list->items, { .type = GFX_ITEM_IMAGE, .image = { img, x, y, w, h } });
+}
+
+// Lays text out the way gfx_text does, as long as every codepoint is the face's own and in the size's low codepoint
+// table. Nothing here can load glyphs or change the cache, so anything else makes the merge draw the text instead.
+void gfx_drawlist_text(gfx_drawlist* list, const char* str, short x, short y) {
+	PROFILER_ZONE_START
+	struct gfx_ctx* c = list->ctx;
+	u32 len = strlen(str);
+	u32 raster = gfx_font_bucket_of(&c->font, list->size);
+
+	gfx_rwlock_take_read(&c->share->fonts_lock);
+	if((u32) list->face >= vlen(c->share->fonts)) {
+		gfx_rwlock_give_read(&c->share->fonts_lock);
+		PROFILER_ZONE_END
+		return;
+	}
+	gfx_typeface* face = c->share->fonts + list->face;
+	gfx_char* low = NULL;
+	for(u32 i = 0; i < GFX_LOW_TABLES; i ++)
+		if(face->low[i].chars && face->low[i].size == raster) low = face->low[i].chars;
+
+	u32 first = vlen(list->glyphs);
+	f32 scale = (f32) list->size / raster;
+	f32 px_per_unit = list->size * 4.0f / 3.0f / face->face->units_per_EM; // What gfx_get_kerning scales by
+	f32 curx = x;
+	short cury = y;
+	u32 prev = 0;
+	bool laid_out = low;
+	FT_ULong point;
+	const char *at = str, *end = str + len;
+	while (laid_out && at < end && (point = gfx_readutf8((u8**) &at))) {
+		if (point == '\n') {
+			cury += gfx_line_advance_of(&c->font, list->size);
+			curx = x;
+			prev = 0;
+		} else if (point < GFX_LOW_CODEPOINTS && low[point].loaded) {
+			curx += gfx_kern_units(face, px_per_unit, prev, face->low_glyphs[point]);
+			prev = face->low_glyphs[point];
+			vpush(list->glyphs, { low[point], curx, cury });
+			curx += low[point].advance * scale;
+		} else if (point == ' ') {
+			curx += gfx_kern_units(face, px_per_unit, prev, face->space_glyph);
+			prev = face->space_glyph;
+			curx += face->space_width * list->size * 4 / 3 / RENDERING_FONT_SIZE();
+		} else laid_out = false;
+	}
+	gfx_rwlock_give_read(&c->share->fonts_lock);
+
+	if(!laid_out) vpopto(list->glyphs, first);
+	vpush(list->items, { .type = GFX_ITEM_TEXT, .text = {
+		.face = list->face, .size = list->size, .raster = raster,
+		.str = vlen(list->strs), .len = len,
+		.glyph = first, .glyphs = vlen(list->glyphs) - first,
+		.x = x, .y = y, .laid_out = laid_out
+	} });
+	memcpy(vpush_uninit(list->strs, len), str, len);
+	PROFILER_ZONE_END
+}
+
+// Lists on lower layers go first, and lists on the same layer go in the order they were made.
+static int gfx_drawlist_cmp(const void* a, const void* b) {
+	const gfx_drawlist *l = *(gfx_drawlist* const*) a, *r = *(gfx_drawlist* const*) b;
+	if(l->layer != r->layer) return l->layer < r->layer ? -1 : 1;
+	return (l->made > r->made) - (l->made < r->made);
+}
+
+static void gfx_drawlist_merge(gfx_drawlist* list) {
+	vreserve(ctx->gl.drawbuf.shp, (vlen(list->items) + vlen(list->glyphs)) * 4);
+	vreserve(ctx->gl.drawbuf.idx, (vlen(list->items) + vlen(list->glyphs)) * 6);
+	for(u32 i = 0; i < vlen(list->items); i ++) {
+		struct gfx_drawitem* it = list->items + i;
+		if(it->type == GFX_ITEM_QUAD) {
+			u32 cur_idx = vlen(ctx->gl.drawbuf.shp);
+			vpusharr(ctx->gl.drawbuf.idx, { cur_idx, cur_idx + 1, cur_idx + 2, cur_idx + 2, cur_idx, cur_idx + 3 });
+			memcpy(vpush_uninit(ctx->gl.drawbuf.shp, 4), it->quad, sizeof(it->quad));
+		} else if(it->type == GFX_ITEM_IMAGE) {
+			image(it->image.img, it->image.x, it->image.y, it->image.w, it->image.h);
+		} else {
+			// Shaping or outlines could have been turned on since, which the glyphs wouldn't have
+			gfx_typeface* face = ctx->share->fonts + it->text.face;
+			if(it->text.laid_out && !face->chain_hnd && !face->draw_outlines) {
+				f32 scale = (f32) it->text.size / it->text.raster;
+				for(u32 g = it->text.glyph; g < it->text.glyph + it->text.glyphs; g ++)
+					gfx_emit_glyph(&list->glyphs[g].ch, list->glyphs[g].x, list->glyphs[g].y, scale);
+				continue;
+			}
+			gfx_face cur = ctx->font.cur;
+			u32 size = ctx->font.size;
+			font(it->text.face, it->text.size);
+			gfx_text(list->strs + it->text.str, it->text.len, it->text.x, it->text.y);
+			font(cur, size);
+			ctx->stats.drawlist_text_deferred ++;
+		}
+	}
+}
+
+// Draws every submitted list into the frame. Runs before the frame gets flushed, after whatever threads made the
+// lists have submitted them.
+static void gfx_drawlists_merge() {
+	ctx->stats.drawlist_text_deferred = 0;
+	if(!cvec_len(&ctx->lists.queue)) return;
+	PROFILER_ZONE_START
+
+	// Taken out of the queue first, since drawing can flush
+	gfx_drawlist** lists = gfx_frame_vnew();
+	cvec_each(&ctx->lists.queue, chunk) {
+		u32 len = cvec_chunk_len(chunk);
+		memcpy(vpush_uninit(lists, len), chunk->data, len * sizeof(*lists));
+	}
+	cvec_reset(&ctx->lists.queue);
+	qsort(lists, vlen(lists), sizeof(*lists), gfx_drawlist_cmp);
+
+	for(u32 i = 0; i < vlen(lists); i ++) gfx_drawlist_merge(lists[i]);
+	vfree(lists);
+	PROFILER_ZONE_END
+}
+
+// ---------------------------------------------- Tracing ---------------------------------------------- //
+
+// Zones from PROFILER_ZONE_START/END and PROFILER_GPU_ZONE_START/END, without Tracy. Every thread writes its zones into
+// its own ring, so recording one is a couple of timestamps and a store, and dumps turn the rings into Chrome trace
+// JSON. Without GFX_TRACE none of it gets compiled in.
+
+#ifdef GFX_TRACE
+
+typedef struct gfx_trace_event {
+	const char* name;
+	u64 start, end; // Ticks, the same for instants like frames
+} gfx_trace_event;
+
+// One thread's zones, or one context's GPU zones. Only the thread it belongs to writes to it, and dumps read it while
+// it does, so the oldest events of a full ring can be getting overwritten as they're read.
+typedef struct gfx_trace_ring {
+	struct gfx_trace_ring* next;
+	u32 tid;
+	const char* name; // NULL for threads
+	_Atomic u64 written;
+	gfx_trace_event events[GFX_TRACE_EVENTS];
+} gfx_trace_ring;
+
+static gfx_trace_ring* _Atomic gfx_trace_rings = NULL;
+static _Atomic u32 gfx_trace_tids = 0;
+static _Thread_local gfx_trace_ring* gfx_trace_own = NULL;
+
+// Ticks and the clock when the first ring was made, everything's timed from there
+static struct { u64 ticks, ns; } gfx_trace_epoch;
+static _Atomic u32 gfx_trace_state = 0; // 1 while the epoch is being taken, 2 after
+
+static volatile sig_atomic_t gfx_trace_signalled = 0;
+static const char* gfx_trace_signal_path = NULL;
+
+// Nanoseconds
+static u64 gfx_trace_clock() {
+#ifdef _WIN32
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER t;
+	if(!freq.QuadPart) QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&t);
+	return (u64) ((f64) t.QuadPart * 1e9 / freq.QuadPart);
+#else
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000000ull + t.tv_nsec;
+#endif
+}
+
+// The tick rate, measured against the clock over everything since the epoch
+static f64 gfx_trace_ticks_per_ns() {
+	u64 ns = gfx_trace_clock() - gfx_trace_epoch.ns, ticks = gfx_trace_now() - gfx_trace_epoch.ticks;
+	return ns ? (f64) ticks / ns : 1;
+}
+
+static gfx_trace_ring* gfx_trace_ring_new(const char* name) {
+	u32 state = 0;
+	if(atomic_compare_exchange_strong(&gfx_trace_state, &state, 1)) {
+		gfx_trace_epoch.ns = gfx_trace_clock();
+		gfx_trace_epoch.ticks = gfx_trace_now();
+		atomic_store(&gfx_trace_state, 2);
+	}
+	else while(atomic_load(&gfx_trace_state) != 2);
+
+	gfx_trace_ring* ring = GFX_CALLOC(1, sizeof(gfx_trace_ring));
+	ring->tid = atomic_fetch_add(&gfx_trace_tids, 1) + 1;
+	ring->name = name;
+	ring->next = atomic_load(&gfx_trace_rings);
+	while(!atomic_compare_exchange_weak(&gfx_trace_rings, &ring->next, ring));
+	return ring;
+}
+
+static inline void gfx_trace_push(gfx_trace_ring* ring, const char* name, u64 start, u64 end) {
+	u64 at = atomic_load_explicit(&ring->written, memory_order_relaxed);
+	ring->events[at % GFX_TRACE_EVENTS] = (gfx_trace_event) { name, start, end };
+	atomic_store_explicit(&ring->written, at + 1, memory_order_release);
+}
+
+static void gfx_trace_zone(const char* name, u64 start) {
+	u64 end = gfx_trace_now();
+	if(!gfx_trace_own) gfx_trace_own = gfx_trace_ring_new(NULL);
+	gfx_trace_push(gfx_trace_own, name, start, end);
+}
+
+// Writing a file isn't safe in a signal handler, so the handler only asks for the next frame to do it
+static void gfx_trace_frame() {
+	u64 now = gfx_trace_now();
+	if(!gfx_trace_own) gfx_trace_own = gfx_trace_ring_new(NULL);
+	gfx_trace_push(gfx_trace_own, "frame", now, now);
+	if(gfx_trace_signalled) {
+		gfx_trace_signalled = 0;
+		gfx_trace_dump(gfx_trace_signal_path);
+	}
+}
+
+static void gfx_trace_signal(int sig) {
+	gfx_trace_signalled = 1;
+	signal(sig, gfx_trace_signal); // Some platforms reset the handler once it runs
+}
+
+void gfx_trace_dump_on_signal(int sig, const char* path) {
+	gfx_trace_signal_path = path;
+	signal(sig, gfx_trace_signal);
+}
+
+static void gfx_trace_gpu_init() {
+	typeof(ctx->trace)* t = &ctx->trace;
+	glGenQueries(GFX_TRACE_GPU_ZONES * 2, t->ids);
+	t->ring = gfx_trace_ring_new("GPU");
+	glGetInteger64v(GL_TIMESTAMP, &t->gpu_base);
+	t->ticks_base = gfx_trace_now();
+}
+
+static void gfx_trace_gpu_begin(const char* name) {
+	typeof(ctx->trace)* t = &ctx->trace;
+	u32 zone = UINT32_MAX;
+	if(t->depth < GFX_TRACE_GPU_DEPTH && t->begun - t->read < GFX_TRACE_GPU_ZONES) {
+		zone = t->begun ++ % GFX_TRACE_GPU_ZONES;
+		t->zones[zone] = (struct gfx_gpu_zone) { .name = name };
+		glQueryCounter(t->ids[zone * 2], GL_TIMESTAMP);
+	}
+	if(t->depth < GFX_TRACE_GPU_DEPTH) t->open[t->depth] = zone;
+	t->depth ++;
+}
+
+static void gfx_trace_gpu_end() {
+	typeof(ctx->trace)* t = &ctx->trace;
+	u32 zone = -- t->depth < GFX_TRACE_GPU_DEPTH ? t->open[t->depth] : UINT32_MAX;
+	if(zone == UINT32_MAX) return;
+	glQueryCounter(t->ids[zone * 2 + 1], GL_TIMESTAMP);
+	t->zones[zone].ended = true;
+}
+
+// Moves the zones whose queries came back into the context's GPU ring, in ticks, without waiting on the rest
+static void gfx_trace_gpu_collect() {
+	typeof(ctx->trace)* t = &ctx->trace;
+	f64 per_ns = gfx_trace_ticks_per_ns();
+	for(; t->read != t->begun; t->read ++) {
+		u32 zone = t->read % GFX_TRACE_GPU_ZONES;
+		GLint ready = 0;
+		if(!t->zones[zone].ended) break;
+		glGetQueryObjectiv(t->ids[zone * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &ready);
+		if(!ready) break;
+		GLuint64 begin, end;
+		glGetQueryObjectui64v(t->ids[zone * 2], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(t->ids[zone * 2 + 1], GL_QUERY_RESULT, &end);
+		gfx_trace_push(t->ring, t->zones[zone].name,
+			t->ticks_base + (i64) (begin - t->gpu_base) * per_ns, t->ticks_base + (i64) (end - t->gpu_base) * per_ns);
+	}
+}
+
+bool gfx_trace_dump(const char* path) {
+	FILE* f = fopen(path, "w");
+	CHECK_CALL(!f, return false, "Couldn't open '%s' to write the trace to", path);
+	f64 per_us = gfx_trace_ticks_per_ns() * 1000;
+	const char* sep = "";
+	fputs("{\"traceEvents\":[\n", f);
+	for(gfx_trace_ring* ring = atomic_load(&gfx_trace_rings); ring; ring = ring->next) {
+		if(ring->name) {
+			fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", sep, ring->tid, ring->name);
+			sep = ",\n";
+		}
+		u64 written = atomic_load_explicit(&ring->written, memory_order_acquire);
+		for(u64 i = written > GFX_TRACE_EVENTS ? written - GFX_TRACE_EVENTS : 0; i < written; i ++) {
+			gfx_trace_event e = ring->events[i % GFX_TRACE_EVENTS];
+			if(e.end < e.start || e.start < gfx_trace_epoch.ticks) continue; // Half overwritten
+			f64 ts = (e.start - gfx_trace_epoch.ticks) / per_us;
+			if(e.end == e.start)
+				fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}", sep, e.name, ts, ring->tid);
+			else
+				fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}", sep, e.name, ts, (e.end - e.start) / per_us, ring->tid);
+			sep = ",\n";
+		}
+	}
+	fputs("\n]}\n", f);
+	fclose(f);
+	return true;
+}
+
+#else
+
+bool gfx_trace_dump(const char* path) { (void) path; return false; }
+void gfx_trace_dump_on_signal(int sig, const char* path) { (void) sig, (void) path; }
+
+#endif
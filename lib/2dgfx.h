@@ -39,8 +39,10 @@ enum gfx_setting_name {
   GFX_SETTING_NO_DECORATIONS,
   GFX_SETTING_DONT_STORE_SETTINGS,
   GFX_SETTING_MSAA,
-  GFX_SETTING_INITIAL_WINDOW
+  GFX_SETTING_INITIAL_WINDOW,
+  GFX_SETTING_RENDER_THREAD
 };
+typedef struct gfx_jobs gfx_jobs;
 typedef struct gfx_settings {
   uint32_t width, height;
   const char* app_name;
@@ -51,6 +53,18 @@ typedef struct gfx_settings {
   bool dont_store_settings;
   float fps_recalc_delta;
   uint8_t msaa;
+  // Uploads, draw calls and swapping go to a thread that owns the GL context. gfx_frame() hands each frame over and
+  // returns, so the next frame gets built while the last one is drawn, and only waits when the render thread is still a
+  // frame behind. Starts and stops at the next gfx_frame() when changed with gfx_setting_set.
+  bool render_thread;
+  // Job pool to use instead of making one, like another context's from gfx_get_jobs(). Contexts made with share use
+  // that context's pool unless they're given one.
+  gfx_jobs* jobs;
+  // Context to share textures, atlases, fonts with their glyph caches, and the shader with, so they're only loaded once
+  // for every window. Each context can then be used from its own thread. Windows still have to be made on the thread
+  // that made the first one, and that thread's gfx_frame() polls events for all of them. Building frames in a share
+  // group takes turns, but swapping doesn't, and contexts that share don't use render threads.
+  struct gfx_ctx* share;
   enum gfx_setting_initial_window_mode: uint8_t {
     GFX_WIN_DEFAULT,
     GFX_WIN_FULLSCREEN,
@@ -153,20 +167,97 @@ typedef enum gfx_mouse_button {
 
 struct gfx_ctx;
 
+// Counters for what the context has cached and how much work it took, from gfx_get_stats. What's cached is the whole
+// share group's, see gfx_settings.share.
+typedef struct gfx_stats {
+  uint32_t glyph_loads;  // Glyphs rasterized by FreeType since gfx_init
+  uint32_t glyphs;       // Glyphs currently cached, across every face and size
+  uint32_t layout_lines; // Lines text_box() has laid out, not counting the ones it kept from the layout before
+  uint32_t atlases;
+  uint64_t atlas_bytes;  // CPU side size of all the atlas buffers
+  float atlas_occupancy; // Share of the atlases' area glyphs and images take up, from 0 to 1
+
+  // The last frame, in milliseconds for times
+  float frame_ms;        // From the gfx_frame() that started it to the one after it ended
+  float cpu_ms;          // Building it, until it was drawn or handed to the render thread
+  float gpu_ms;          // GPU time from a timer query, which comes back a frame or a few after the frame it timed
+  uint32_t draw_calls;
+  uint32_t flushes;      // Draw calls made before gfx_frame(), because texture slots ran out and such
+  uint32_t vertices, indices;
+  uint64_t upload_bytes; // Vertices, indices, outline glyphs and texture pixels sent to the GPU
+  uint32_t frame_glyph_loads;
+  uint32_t frame_allocs;      // Scratch allocations the last frame made from the frame arena
+  uint32_t frame_heap_allocs; // Vector allocations and reallocations the last frame made on the heap
+  uint64_t frame_arena_bytes; // How much of the frame arena the last frame used
+  uint32_t drawlist_text_deferred; // Draw list text the last frame laid out at the merge, for glyphs it didn't have yet
+
+  // With the render thread, in milliseconds, for the last frame it finished
+  float render_wait;    // gfx_frame() blocked waiting for the render thread to finish the frame before
+  float render_submit;  // Render thread uploading and drawing
+  float render_swap;    // Render thread swapping buffers
+  float render_latency; // From gfx_frame() handing the frame over to it being swapped
+  float render_overlap; // Render thread time that happened while the next frame was being built
+} gfx_stats;
+
 typedef int gfx_img;
 typedef int gfx_face;
+typedef int gfx_textslot;
+
+typedef enum gfx_text_align {
+  GFX_ALIGN_LEFT, GFX_ALIGN_CENTER, GFX_ALIGN_RIGHT
+} gfx_text_align;
+
+// A glyph that has already been shaped, positioned relative to the origin it gets drawn at.
+typedef struct gfx_glyph {
+  uint32_t id;       // Glyph index in the face, NOT a unicode codepoint.
+  int16_t x, y;
+  uint16_t fallback; // 0 for the face itself, otherwise the position of the fallback face it comes from + 1.
+} gfx_glyph;
 
 // Initializes a 2DGFX Context and sets up OpenGL, heaps and buffers.
 struct gfx_ctx* gfx_init(const char* title, gfx_settings* settings);
 bool gfx_frame();
 void gfx_quit();
+// Closes the context's window and frees it, with its text slots. Draw lists recorded for it have to be freed first. The
+// job pool and the share group get freed along with the last context using them.
+void gfx_ctx_free(struct gfx_ctx* c);
 
-// When using multiple 2DGFX contexts, switch contexts with this.
+// When using multiple 2DGFX contexts, switch contexts with this. It makes the context's GL context current on the
+// thread. Threads using contexts that share take turns: a thread has the share group from setting one of its contexts
+// until it sets another context or NULL, and gfx_frame() only lets go of it for the swap. A context can only be set on
+// one thread at a time.
 void gfx_ctx_set(struct gfx_ctx* c);
 
+// Jobs, run by the context's work stealing pool of threads, which has one per core besides the thread that made the
+// context. 2DGFX rasterizes glyphs on it, and the app can use it for its own work. Submit and wait from the context's
+// thread or from inside a job. Jobs that wait on jobs run others in the meantime, other threads sleep while they wait,
+// and so do the pool's threads when there's nothing to do.
+typedef struct gfx_job gfx_job;
+gfx_job* gfx_job_submit(void (*fn)(void* arg), void* arg);
+void gfx_job_wait(gfx_job* job); // Every submitted job has to be waited on, which frees it
+// Calls fn on pieces of [0, n) of up to grain each, spread over the pool and the calling thread, and returns once
+// they're all done.
+void gfx_parallel_for(uint32_t n, uint32_t grain, void (*fn)(void* arg, uint32_t from, uint32_t to), void* arg);
+// The context's pool, to share with contexts made after it through gfx_settings.jobs
+gfx_jobs* gfx_get_jobs();
+
 // Loads a font through FreeType
 gfx_face gfx_load_font(const char* file);
 
+// Enables GSUB features for a face through libatures, like "calt liga" for coding fonts. NULL script/lang uses the defaults.
+bool gfx_font_features(gfx_face face, const char* script, const char* lang, const char* features);
+
+// Sets the faces that get searched, in order, for codepoints the face doesn't have. Replaces any earlier fallbacks.
+bool gfx_register_fallbacks(gfx_face face, uint32_t num, const gfx_face* fallbacks);
+
+// Rasterizes the face's glyphs with the built in rasterizer instead of FreeType's, which is faster on big batches of
+// glyphs. Glyphs that were already loaded stay as they are.
+bool gfx_font_native_raster(gfx_face face, bool on);
+
+// Draws the face's glyphs straight from their curves in the fragment shader instead of from rasterized bitmaps, so text
+// stays sharp at any size and zooming doesn't fill up atlases. Costs more per pixel, so it's best for big or changing sizes.
+bool gfx_font_outlines(gfx_face face, bool on);
+
 // Loads in image through STB_Image
 gfx_img gfx_load_img(const char* file);
 gfx_img gfx_load_img_mem(uint8_t* t, uint32_t len);
@@ -190,18 +281,139 @@ gfx_vector_mini* const isize(gfx_img img); // Image size.
 
 // Text Drawing commands
 void font_size(uint32_t size);
-void lineheight(float h);
+// Rasterizes glyphs at sizes min_size * ratio^n (rounded up) and scales them down, so many sizes share one set of bitmaps.
+// Lower ratios look sharper but use more atlas space, 1.25 is a good start. A ratio <= 1 turns it off.
+void gfx_font_buckets(float ratio, uint32_t min_size);
+void line_height(float h); // Multiple of the font size each line takes up, 1 by default
 void font(gfx_face face, uint32_t size);
 void text(const char* str, short x, short y);
 void textf(short x, short y, const char* fmt, ...); // SLOW, AVOID UNLESS DEBUGGING
 
+// Numbers that change every frame, without going through printf. Floats get a fixed number of decimals, like %.*f.
+void text_int(int64_t v, short x, short y);
+void text_float(double v, uint32_t precision, short x, short y);
+
+// Typed formatting, e.g. text_fmt(10, 10, "x: ", pos.x, " speed: ", gfx_fmt_float(speed, 1), " px/s"). How each argument
+// is printed comes from its type at compile time, so there's no format string to parse: strings are copied, integers
+// printed in full and floats with 2 decimals unless wrapped in gfx_fmt_float. Up to 8 arguments and 256 bytes of text.
+enum gfx_fmt_type { GFX_FMT_STR, GFX_FMT_INT, GFX_FMT_UINT, GFX_FMT_FLOAT };
+typedef struct gfx_fmt {
+  union { const char* str; int64_t i; uint64_t u; double f; };
+  uint8_t type, precision;
+} gfx_fmt;
+void gfx_text_fmt(short x, short y, const gfx_fmt* args, uint32_t n);
+// The same formatting into buf instead of onto the screen, cut off to fit size bytes with a NUL. Returns the length.
+uint32_t gfx_fmt_write(char* buf, uint32_t size, const gfx_fmt* args, uint32_t n);
+
+static inline gfx_fmt gfx_fmt_str(const char* s) { return (gfx_fmt){ .str = s, .type = GFX_FMT_STR }; }
+static inline gfx_fmt gfx_fmt_int(int64_t v) { return (gfx_fmt){ .i = v, .type = GFX_FMT_INT }; }
+static inline gfx_fmt gfx_fmt_uint(uint64_t v) { return (gfx_fmt){ .u = v, .type = GFX_FMT_UINT }; }
+static inline gfx_fmt gfx_fmt_float(double v, uint8_t precision) { return (gfx_fmt){ .f = v, .type = GFX_FMT_FLOAT, .precision = precision }; }
+static inline gfx_fmt gfx_fmt_double(double v) { return gfx_fmt_float(v, 2); }
+static inline gfx_fmt gfx_fmt_same(gfx_fmt f) { return f; }
+
+#define GFX_FMT_ARG(a) _Generic((a),\
+  char*: gfx_fmt_str, const char*: gfx_fmt_str,\
+  float: gfx_fmt_double, double: gfx_fmt_double, gfx_fmt: gfx_fmt_same,\
+  unsigned long: gfx_fmt_uint, unsigned long long: gfx_fmt_uint,\
+  default: gfx_fmt_int)(a)
+#define GFX_FMT_COUNT(_1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define GFX_FMT_1(a) GFX_FMT_ARG(a)
+#define GFX_FMT_2(a, ...) GFX_FMT_ARG(a), GFX_FMT_1(__VA_ARGS__)
+#define GFX_FMT_3(a, ...) GFX_FMT_ARG(a), GFX_FMT_2(__VA_ARGS__)
+#define GFX_FMT_4(a, ...) GFX_FMT_ARG(a), GFX_FMT_3(__VA_ARGS__)
+#define GFX_FMT_5(a, ...) GFX_FMT_ARG(a), GFX_FMT_4(__VA_ARGS__)
+#define GFX_FMT_6(a, ...) GFX_FMT_ARG(a), GFX_FMT_5(__VA_ARGS__)
+#define GFX_FMT_7(a, ...) GFX_FMT_ARG(a), GFX_FMT_6(__VA_ARGS__)
+#define GFX_FMT_8(a, ...) GFX_FMT_ARG(a), GFX_FMT_7(__VA_ARGS__)
+#define text_fmt(x, y, ...) gfx_text_fmt(x, y,\
+  (gfx_fmt[]){ GFX_FMT_COUNT(__VA_ARGS__, GFX_FMT_8, GFX_FMT_7, GFX_FMT_6, GFX_FMT_5, GFX_FMT_4, GFX_FMT_3, GFX_FMT_2, GFX_FMT_1)(__VA_ARGS__) },\
+  GFX_FMT_COUNT(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1))
+#define fmt_write(buf, size, ...) gfx_fmt_write(buf, size,\
+  (gfx_fmt[]){ GFX_FMT_COUNT(__VA_ARGS__, GFX_FMT_8, GFX_FMT_7, GFX_FMT_6, GFX_FMT_5, GFX_FMT_4, GFX_FMT_3, GFX_FMT_2, GFX_FMT_1)(__VA_ARGS__) },\
+  GFX_FMT_COUNT(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1))
+
+// Measures text as text() would draw it with the current font, without loading any glyph bitmaps. w or h can be NULL.
+void text_measure(const char* str, float* w, float* h);
+// Writes the width of each of the first max lines of str, and returns how many lines it has.
+uint32_t text_line_widths(const char* str, float* widths, uint32_t max);
+
+// Draws text inside a box with its top left at x, y, breaking lines at spaces when wrap is on. Lines past h aren't drawn,
+// unless h is 0. Layouts are cached by the string's address, so edits to a string only reflow from the line that changed.
+void text_box(const char* str, short x, short y, short w, short h, gfx_text_align align, bool wrap);
+// Writes the width of each of the first max lines text_box() breaks str into, and returns how many lines there are.
+uint32_t text_box_line_widths(const char* str, short w, bool wrap, float* widths, uint32_t max);
+
+// Text that stays put and changes a bit at a time, like counters, clocks and tickers. A slot keeps its glyph quads between
+// frames, and setting new text only lays out the codepoints that changed, the ones after them just get moved over. Faces
+// with shaping or outlines on get drawn through text() instead. Returns -1 for faces that don't exist.
+gfx_textslot gfx_textslot_new(gfx_face face, uint32_t size, short x, short y);
+void gfx_textslot_set(gfx_textslot slot, const char* str);
+void gfx_textslot_draw(gfx_textslot slot);
+void gfx_textslot_move(gfx_textslot slot, short x, short y);
+void gfx_textslot_free(gfx_textslot slot);
+
+// Draw lists, for building parts of a frame on other threads. Any thread can fill a list, and gfx_frame() draws every list
+// submitted since the last frame on top of it, lowest layer first and in the order the lists were made within a layer.
+// So the result doesn't depend on which thread finishes first. Submit lists from any thread, but before the context's
+// thread calls gfx_frame(). Lists are made and freed on the context's thread and keep what they have between frames,
+// until they're cleared, so they can be submitted again unchanged.
+// Text reads the glyph cache without changing it. Text with a glyph that isn't cached yet gets laid out by gfx_frame(),
+// which caches it for the frames after, and so does text in faces that shape or draw outlines.
+typedef struct gfx_drawlist gfx_drawlist;
+gfx_drawlist* gfx_drawlist_new(int32_t layer); // Starts with the current fill and font
+void gfx_drawlist_free(gfx_drawlist* list);
+void gfx_drawlist_clear(gfx_drawlist* list);
+void gfx_drawlist_submit(gfx_drawlist* list);
+void gfx_drawlist_fill(gfx_drawlist* list, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+void gfx_drawlist_font(gfx_drawlist* list, gfx_face face, uint32_t size);
+void gfx_drawlist_quad(gfx_drawlist* list, short x1, short y1, short x2, short y2, short x3, short y3, short x4, short y4);
+void gfx_drawlist_rect(gfx_drawlist* list, short x, short y, short w, short h);
+void gfx_drawlist_image(gfx_drawlist* list, gfx_img img, short x, short y, short w, short h);
+void gfx_drawlist_text(gfx_drawlist* list, const char* str, short x, short y);
+
+// Rasterizes every glyph in the codepoint ranges ahead of time, on worker threads, so the first frame they're drawn in
+// doesn't have to. Codepoints the face doesn't have are loaded from its fallbacks.
+typedef struct gfx_range { uint32_t first, last; } gfx_range;
+void gfx_preload_glyphs(gfx_face face, uint32_t size, const gfx_range* ranges, uint32_t n);
+
+// Glyph based text. Shape once with gfx_shape, then draw the glyphs as many times as needed.
+uint32_t gfx_shape(gfx_face face, uint32_t size, const char* str, gfx_glyph* out, uint32_t max);
+void text_glyphs(gfx_face face, uint32_t size, const gfx_glyph* glyphs, uint32_t n, short x, short y);
+
 // Calculates FPS
 double gfx_time();
 void gfx_sleep(uint32_t miliseconds);
 double gfx_fps();
 bool gfx_fps_changed();
+gfx_stats gfx_get_stats();
+
+// Every frame's stats are kept for the last GFX_STATS_HISTORY frames, to catch spikes an average hides.
+#define GFX_STATS_HISTORY 240
+typedef struct gfx_percentiles { float p50, p95, p99, max; } gfx_percentiles;
+typedef struct gfx_frame_history {
+  uint32_t frames; // Frames in the history, up to GFX_STATS_HISTORY
+  gfx_percentiles frame_ms, cpu_ms, gpu_ms;
+} gfx_frame_history;
+gfx_frame_history gfx_get_frame_history();
+// Stats of the frame that ended ago frames before the last one, NULL once it's out of the history
+const gfx_stats* gfx_get_frame_stats(uint32_t ago);
+
+// A vertex the frame has drawn: where it is, its gfx_vtx_type and either its color or its texture slot and UV, packed.
+typedef struct gfx_vertex { int16_t x, y; uint8_t type; uint32_t data; } gfx_vertex;
+// Copies the vertices drawn since the last flush, from the first'th on, and returns how many there are from it. For tests
+// and debugging. Quads that draw nothing, like a text slot's spaces, come out zeroed.
+uint32_t gfx_frame_vertices(uint32_t first, gfx_vertex* out, uint32_t max);
+
+// FPS in the bottom right corner, over a graph of the history's frame times and their percentiles
 void gfx_default_fps_counter();
 
+// Tracing, when 2DGFX is built with GFX_TRACE defined. Its functions and GPU work get timed into a ring per thread,
+// which these write out as Chrome trace JSON for chrome://tracing or Perfetto. Without GFX_TRACE they do nothing.
+bool gfx_trace_dump(const char* path);
+// Dumps at the next gfx_frame() after the process gets sig, like SIGUSR1, to trace a running app from outside
+void gfx_trace_dump_on_signal(int sig, const char* path);
+
 void on_mouse_button(gfx_vector pos, gfx_mouse_button button, bool pressed, gfx_keymod mods);
 void on_mouse_move(gfx_vector pos);
 void on_mouse_enter(bool entered);
@@ -21,6 +21,7 @@ set c=clang-cl --target=x86_64-pc-win32 /c /MDd /Z7 /EHsc /Od /D_CRT_SECURE_NO_W
 :: for /f "tokens=*" %%F in ('dir /b /a:-d "*.c"') do call set c=%%c%% "%%F"
 :: for /f "tokens=*" %%F in ('dir /b /a:-d ".\deps\*.c"') do call set c=%%c%% ".\deps\%%F"
 for /f "tokens=*" %%F in ('dir /b /a:-d ".\lib\*.c"') do call set c=%%c%% ".\lib\%%F"
+for /f "tokens=*" %%F in ('dir /b /a:-d ".\deps\extern\libatures\*.c"') do call set c=%%c%% ".\deps\extern\libatures\%%F"
 :: set c=%c% /DTRACY_ENABLE .\deps\extern\tracy\TracyClient.cpp
 echo running %c%
 %c%
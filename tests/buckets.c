@@ -0,0 +1,64 @@
+#include "tests.h"
+#include <2dgfx.h>
+
+// Atlas memory and FreeType work for main.c's particle demo (sizes 5 - 50), with and without size buckets.
+// Every run shares one context but loads its own copy of the font, so its glyph cache starts out empty. The atlases are
+// shared between runs, so a run is measured by how much it adds to them.
+
+static const char* messages[] = { "lol", "ez", "cool demo", "but CAN YOU DO THIS?", "send n*des", "lmao" };
+#define MLEN (sizeof(messages) / sizeof(messages[0]))
+
+static struct gfx_ctx* ctx = NULL;
+
+typedef struct run { unsigned int glyph_loads; double atlas_used; } run;
+
+static double atlas_used(gfx_stats s) { return s.atlas_bytes * (double) s.atlas_occupancy; }
+
+static void draw_sizes() {
+	for(int size = 5; size <= 50; size ++) {
+		font_size(size);
+		for(int i = 0; i < MLEN; i ++) text(messages[i], 10, size * 10);
+	}
+	gfx_frame();
+}
+
+static run draw_particles(float ratio) {
+	if(!ctx) ctx = gfx_init("buckets", NULL);
+	gfx_stats before = gfx_get_stats();
+
+	gfx_face fon = gfx_load_font("roboto.ttf");
+	font(fon, 20);
+	gfx_font_buckets(ratio, 8);
+	draw_sizes();
+
+	gfx_stats after = gfx_get_stats();
+	run r = { after.glyph_loads - before.glyph_loads, atlas_used(after) - atlas_used(before) };
+	printf("\n" SUBTESTINDENT "%u glyph loads, %.2f MB of atlas used, %u atlases, %.2f MB in all", r.glyph_loads, r.atlas_used / 1048576.0, after.atlases, after.atlas_bytes / 1048576.0);
+	return r;
+}
+
+static run exact, bucketed;
+
+TEST("Exact sizes") {
+	exact = draw_particles(0);
+	assert(exact.glyph_loads > 0);
+	BENCH("frame") draw_sizes();
+}
+
+TEST("Buckets of 1.25") {
+	bucketed = draw_particles(1.25f);
+	assert(bucketed.glyph_loads < exact.glyph_loads);
+	assert(bucketed.atlas_used < exact.atlas_used);
+	BENCH("frame") draw_sizes();
+}
+
+TEST("Buckets of 1.5") {
+	run r = draw_particles(1.5f);
+	assert(r.glyph_loads < exact.glyph_loads);
+	assert(r.atlas_used < exact.atlas_used);
+
+	gfx_ctx_free(ctx);
+	ctx = NULL;
+}
+
+#include "tests_end.h"
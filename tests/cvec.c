@@ -0,0 +1,96 @@
+#include "tests.h"
+
+#define CVEC_H_IMPLEMENTATION
+#include <cvec.h>
+#include <vec.h>
+
+// Several threads appending quads at once, the way UI geometry would get made on worker threads. The lock free
+// vector against one vec.h vector behind a lock.
+
+#define THREADS 4
+#define QUADS 20000 // Per thread
+
+typedef struct vtx { float x, y; uint32_t thread, quad; } vtx;
+
+static cvec verts;
+static vtx* locked;
+static tests_lock locked_lock;
+
+static tests_thread_ret push_cvec(void* arg) {
+	uint32_t t = (uintptr_t) arg;
+	for (uint32_t i = 0; i < QUADS; i++) {
+		vtx* v = cvec_push(&verts, 4);
+		for (int c = 0; c < 4; c++) v[c] = (vtx) { c & 1, c >> 1, t, i };
+	}
+	return 0;
+}
+
+static tests_thread_ret push_locked(void* arg) {
+	uint32_t t = (uintptr_t) arg;
+	for (uint32_t i = 0; i < QUADS; i++) {
+		tests_lock_take(&locked_lock);
+		vtx* v = vpush_uninit(locked, 4);
+		for (int c = 0; c < 4; c++) v[c] = (vtx) { c & 1, c >> 1, t, i };
+		tests_lock_give(&locked_lock);
+	}
+	return 0;
+}
+
+static void run(tests_thread_ret (*fn)(void*)) {
+	tests_thread threads[THREADS];
+	for (uintptr_t t = 0; t < THREADS; t++) tests_thread_start(threads + t, fn, (void*) t);
+	for (int t = 0; t < THREADS; t++) tests_thread_join(threads[t]);
+}
+
+INIT() {
+	cvec_init(&verts, sizeof(vtx), 1022); // Not a multiple of 4, so quads end up not fitting at the end of chunks
+	locked = vnew();
+	tests_lock_init(&locked_lock);
+}
+
+TEST("Every append lands") {
+	run(push_cvec);
+	asserteq(cvec_len(&verts), THREADS * QUADS * 4);
+
+	// Each thread's quads are whole, and show up in the order the thread pushed them
+	static uint32_t next[THREADS];
+	bool in_order = true;
+	cvec_each(&verts, chunk) {
+		vtx* v = (vtx*) chunk->data;
+		uint32_t len = cvec_chunk_len(chunk);
+		assert(len % 4 == 0);
+		for (uint32_t i = 0; i < len; i += 4) {
+			for (int c = 0; c < 4; c++) in_order &= v[i + c].thread == v[i].thread && v[i + c].quad == v[i].quad;
+			in_order &= v[i].quad == next[v[i].thread]++;
+		}
+	}
+	assert(in_order);
+
+	// Chunks get reused after a reset
+	cvec_chunk* second = atomic_load(&verts.head->next);
+	cvec_reset(&verts);
+	asserteq(cvec_len(&verts), 0);
+	run(push_cvec);
+	asserteq(cvec_len(&verts), THREADS * QUADS * 4);
+	assert(atomic_load(&verts.head->next) == second);
+	assert(cvec_push(&verts, 1023) == NULL);
+}
+
+TEST("Appending from threads") {
+	tests_benchiters = 20; // Each run is THREADS * QUADS appends already
+	unsigned long long start = get_precise_time();
+	BENCH("cvec") {
+		cvec_reset(&verts);
+		run(push_cvec);
+	}
+	tests_report_rate(start, (double) tests_benchiters * THREADS * QUADS, "quads");
+
+	start = get_precise_time();
+	BENCH("vec.h behind a lock") {
+		vempty(locked);
+		run(push_locked);
+	}
+	tests_report_rate(start, (double) tests_benchiters * THREADS * QUADS, "quads");
+}
+
+#include "tests_end.h"
@@ -0,0 +1,80 @@
+#include "tests.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_SIZES_H
+
+// Glyph loads with the size changing between every glyph, the way text at a bunch of different sizes misses the cache.
+// Compares setting the size on the face each time (what 2dgfx used to do) with switching between FT_Size objects.
+// Set FTSIZE_FONT to try another font, hinting costs vary a lot between them.
+
+static const unsigned sizes[] = { 12, 14, 16, 20, 24, 32, 48, 64 };
+#define SIZES (sizeof(sizes) / sizeof(*sizes))
+
+static FT_Library lib;
+static FT_Face face;
+static FT_Size objects[SIZES];
+static FT_UInt glyphs[64];
+
+INIT() {
+	tests_load_font("FTSIZE_FONT", &lib, &face);
+
+	for (int i = 0; i < SIZES; i++) {
+		FT_New_Size(face, objects + i);
+		FT_Activate_Size(objects[i]);
+		FT_Set_Pixel_Sizes(face, 0, sizes[i] * 4.0f / 3.0f);
+	}
+	for (int i = 0; i < 64; i++) glyphs[i] = FT_Get_Char_Index(face, 'A' + i % 58);
+}
+
+TEST("Same results") {
+	// A size object has to give exactly what setting the size does
+	for (int i = 0; i < SIZES; i++) {
+		FT_Activate_Size(objects[i]);
+		FT_Load_Glyph(face, glyphs[5], FT_LOAD_RENDER);
+		FT_Pos advance = face->glyph->advance.x;
+		unsigned rows = face->glyph->bitmap.rows;
+
+		FT_Activate_Size(objects[(i + 1) % SIZES]);
+		FT_Set_Pixel_Sizes(face, 0, sizes[i] * 4.0f / 3.0f);
+		FT_Load_Glyph(face, glyphs[5], FT_LOAD_RENDER);
+		asserteq(face->glyph->advance.x, advance);
+		asserteq(face->glyph->bitmap.rows, rows);
+		FT_Set_Pixel_Sizes(face, 0, sizes[(i + 1) % SIZES] * 4.0f / 3.0f);
+	}
+}
+
+TEST("Interleaved sizes") {
+	unsigned long long loads = 0, start = get_precise_time();
+	BENCH("FT_Set_Pixel_Sizes per glyph") {
+		for (int i = 0; i < 64; i++) {
+			FT_Set_Pixel_Sizes(face, 0, sizes[i % SIZES] * 4.0f / 3.0f);
+			FT_Load_Glyph(face, glyphs[i], FT_LOAD_RENDER);
+		}
+		loads += 64;
+	}
+	tests_report_rate(start, loads, "glyphs");
+
+	loads = 0, start = get_precise_time();
+	BENCH("FT_Activate_Size per glyph") {
+		for (int i = 0; i < 64; i++) {
+			FT_Activate_Size(objects[i % SIZES]);
+			FT_Load_Glyph(face, glyphs[i], FT_LOAD_RENDER);
+		}
+		loads += 64;
+	}
+	tests_report_rate(start, loads, "glyphs");
+}
+
+TEST("One size") {
+	// The best case either way, for reference
+	FT_Activate_Size(objects[2]);
+	unsigned long long loads = 0, start = get_precise_time();
+	BENCH("no size changes") {
+		for (int i = 0; i < 64; i++) FT_Load_Glyph(face, glyphs[i], FT_LOAD_RENDER);
+		loads += 64;
+	}
+	tests_report_rate(start, loads, "glyphs");
+}
+
+#include "tests_end.h"
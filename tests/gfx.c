@@ -1,10 +1,14 @@
 #include "tests.h"
 #include <2dgfx.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <math.h>
 
 gfx_face fon;
 gfx_img hi;
+struct gfx_ctx* first;
 TEST("startup") {
-	gfx_init("test window", NULL);
+	first = gfx_init("test window", NULL);
 }
 
 TEST("load font") {
@@ -40,5 +44,496 @@ TEST("second text call") {
 	text("ABCDEFGHIJKLMNOP", 20, 370);
 }
 
+TEST("shaped glyphs") {
+	gfx_glyph glyphs[32];
+	uint32_t n = gfx_shape(fon, 20, "ABC DEF", glyphs, 32);
+	asserteq(n, 6);
+	assert(glyphs[3].x > glyphs[2].x);
+	text_glyphs(fon, 20, glyphs, n, 20, 390);
+	text_glyphs(fon, 20, glyphs, n, 20, 410);
+}
+
+TEST("ligatures") {
+	gfx_glyph plain[16], liga[16];
+	asserteq(gfx_shape(fon, 20, "office", plain, 16), 6);
+
+	// Roboto only has its ligatures under latn, "ffi" becomes one glyph
+	assert(gfx_font_features(fon, "latn", NULL, "liga"));
+	asserteq(gfx_shape(fon, 20, "office", liga, 16), 4);
+	assert(liga[1].id != plain[1].id);
+	text("office affine", 20, 430);
+	text("office affine", 20, 450);
+
+	// Off again has to drop the strings shaped with the chain, on again has to shape them again
+	assert(gfx_font_features(fon, NULL, NULL, NULL));
+	gfx_glyph again[16];
+	asserteq(gfx_shape(fon, 20, "office", again, 16), 6);
+	for(int i = 0; i < 6; i ++) asserteq(again[i].id, plain[i].id);
+	assert(gfx_font_features(fon, "latn", NULL, "liga"));
+	asserteq(gfx_shape(fon, 20, "office", again, 16), 4);
+	asserteq(again[1].id, liga[1].id);
+	assert(gfx_font_features(fon, NULL, NULL, NULL));
+}
+
+TEST("kerning") {
+	gfx_glyph av[2], ah[2];
+	asserteq(gfx_shape(fon, 20, "AV", av, 2), 2);
+	asserteq(gfx_shape(fon, 20, "AH", ah, 2), 2);
+	assert(av[1].x < ah[1].x);
+	text("AVAVA Tomato", 20, 470);
+}
+
+TEST("fallbacks") {
+	gfx_face heavy = gfx_load_font("../tetris/uni-sans/heavy.otf");
+	assert(heavy >= 0);
+	assert(!gfx_register_fallbacks(heavy, 1, (gfx_face[]) { heavy }));
+	assert(gfx_register_fallbacks(heavy, 1, (gfx_face[]) { fon }));
+
+	// Uni Sans has no Greek, so those come from Roboto
+	gfx_glyph glyphs[8];
+	asserteq(gfx_shape(heavy, 20, "A\u0391B", glyphs, 8), 3);
+	asserteq(glyphs[0].fallback, 0);
+	asserteq(glyphs[1].fallback, 1);
+	asserteq(glyphs[2].fallback, 0);
+	text_glyphs(heavy, 20, glyphs, 3, 20, 490);
+	font(heavy, 20);
+	text("Greek: \u0391\u03B2\u03B3 \u03B4\u03B5", 20, 510);
+	font(fon, 20);
+}
+
+TEST("measuring") {
+	font(fon, 20);
+	float a, av, h;
+	text_measure("A", &a, &h);
+	text_measure("AV", &av, NULL);
+	assert(a > 0 && av > a);
+	assert(h > 0);
+
+	float widths[4];
+	asserteq(text_line_widths("AV\n\nAVAV", widths, 4), 3);
+	asserteq(widths[0], av);
+	asserteq(widths[1], 0);
+	assert(widths[2] > av);
+
+	// Nothing gets rasterized just to measure
+	uint32_t loads = gfx_get_stats().glyph_loads;
+	text_measure("Measuring qwxz @#$%", NULL, NULL);
+	asserteq(gfx_get_stats().glyph_loads, loads);
+}
+
+// Breaks text into lines the way a wrapped text_box() should, a word at a time, measuring each word with the spaces before it
+static uint32_t wrap_reference(const char* str, float w, float* widths, uint32_t max) {
+	char line[256];
+	uint32_t n = 0, start = 0, pos = 0, len = strlen(str);
+	float linew = 0, segw;
+	while(pos < len) {
+		uint32_t next = pos;
+		while(next < len && str[next] == ' ') next ++;
+		while(next < len && str[next] != ' ') next ++;
+		snprintf(line, sizeof(line), "%.*s", (int) (next - pos), str + pos);
+		text_line_widths(line, &segw, 1);
+		if(pos == start || linew + segw <= w) { linew += segw; pos = next; continue; }
+
+		snprintf(line, sizeof(line), "%.*s", (int) (pos - start), str + start);
+		if(n < max) text_line_widths(line, widths + n, 1);
+		n ++;
+		while(pos < len && str[pos] == ' ') pos ++;
+		start = pos;
+		linew = 0;
+	}
+	snprintf(line, sizeof(line), "%.*s", (int) (pos - start), str + start);
+	if(start < len && n < max) text_line_widths(line, widths + n, 1);
+	return n + (start < len);
+}
+
+TEST("text boxes") {
+	font(fon, 16);
+	static char log[128] = "The quick brown fox jumps over the lazy dog, again and again and again.";
+	float widths[16], expected[16];
+	uint32_t n = text_box_line_widths(log, 150, true, widths, 16);
+	asserteq(n, wrap_reference(log, 150, expected, 16));
+	assert(n > 2);
+	for(uint32_t i = 0; i < n; i ++) {
+		assert(widths[i] <= 150);
+		assert(fabsf(widths[i] - expected[i]) < 0.01f);
+	}
+	text_box(log, 400, 300, 150, 0, GFX_ALIGN_LEFT, true);
+
+	// Without wrapping only newlines break lines
+	asserteq(text_box_line_widths("Centered\nlines", 150, false, widths, 16), 2);
+	asserteq(text_line_widths("Centered\nlines", expected, 16), 2);
+	assert(widths[0] == expected[0] && widths[1] == expected[1]);
+	text_box("Centered\nlines", 400, 420, 150, 0, GFX_ALIGN_CENTER, false);
+	text_box("Right", 400, 460, 150, 0, GFX_ALIGN_RIGHT, false);
+
+	// Spaces that don't fit at the end of a paragraph don't make an empty line
+	float words;
+	text_line_widths("Wrapped words", &words, 1);
+	short fit = words + 2;
+	asserteq(text_box_line_widths("Wrapped words      ", fit, true, widths, 16), 1);
+	asserteq(text_box_line_widths("Wrapped words      \nNext", fit, true, widths, 16), 2);
+	text_line_widths("Next", expected, 1);
+	assert(widths[1] == expected[0]);
+
+	// Editing the end of the text only reflows the last lines, and ends up like a fresh layout of it
+	uint32_t laid_out = gfx_get_stats().layout_lines;
+	asserteq(text_box_line_widths(log, 150, true, widths, 16), n);
+	asserteq(gfx_get_stats().layout_lines, laid_out);
+	strcat(log, " And again.");
+	uint32_t edited = text_box_line_widths(log, 150, true, widths, 16);
+	assert(gfx_get_stats().layout_lines - laid_out <= edited - n + 2);
+	static char fresh[128];
+	strcpy(fresh, log);
+	asserteq(text_box_line_widths(fresh, 150, true, expected, 16), edited);
+	for(uint32_t i = 0; i < edited; i ++) assert(widths[i] == expected[i]);
+	BENCH("unchanged box") text_box(log, 400, 300, 150, 0, GFX_ALIGN_LEFT, true);
+}
+
+TEST("preloading glyphs") {
+	uint32_t loads = gfx_get_stats().glyph_loads;
+	gfx_preload_glyphs(fon, 30, (gfx_range[]) { { 'A', 'Z' }, { 0x391, 0x3A9 } }, 2);
+	assert(gfx_get_stats().glyph_loads > loads + 26);
+
+	// Everything's in the atlas already
+	loads = gfx_get_stats().glyph_loads;
+	font(fon, 30);
+	text("HELLO WORLD \u0391\u0392\u0393", 20, 530);
+	asserteq(gfx_get_stats().glyph_loads, loads);
+	font(fon, 20);
+}
+
+TEST("native rasterizer") {
+	assert(gfx_font_native_raster(fon, true));
+	uint32_t loads = gfx_get_stats().glyph_loads;
+	font(fon, 26);
+	text("Rasterized without FreeType", 20, 560);
+	assert(gfx_get_stats().glyph_loads > loads);
+	assert(!gfx_font_native_raster(-1, true));
+
+	font(fon, 20);
+	gfx_font_native_raster(fon, false);
+}
+
+TEST("outline glyphs") {
+	assert(gfx_font_outlines(fon, true));
+	gfx_stats before = gfx_get_stats();
+	for(int size = 10; size <= 400; size *= 2) {
+		font(fon, size);
+		text("Zoom", 20, 100 + size);
+	}
+	gfx_frame();
+
+	// Nothing got rasterized for any of those sizes
+	gfx_stats after = gfx_get_stats();
+	asserteq(after.glyph_loads, before.glyph_loads);
+	asserteq(after.atlas_bytes, before.atlas_bytes);
+
+	font(fon, 20);
+	gfx_font_outlines(fon, false);
+}
+
+// Each value printed by fmt_write and by snprintf. None of them are exact ties, which snprintf rounds to even.
+#define SAME_AS_PRINTF(fmt, v) do {\
+	fmt_write(ours, sizeof(ours), v);\
+	snprintf(theirs, sizeof(theirs), fmt, v);\
+	assertstreq(ours, theirs);\
+} while(0)
+
+TEST("number formatting") {
+	static char ours[1024], theirs[1024];
+	SAME_AS_PRINTF("%d", 0);
+	SAME_AS_PRINTF("%d", -1234567);
+	SAME_AS_PRINTF("%lld", (long long) INT64_MIN);
+	SAME_AS_PRINTF("%llu", (unsigned long long) UINT64_MAX);
+	SAME_AS_PRINTF("%.2f", 9.995); // Really 9.99499..., so nothing carries
+	SAME_AS_PRINTF("%.2f", 9.9951);
+	const double floats[] = { 0, -0.0, 1.5e-7, -0.001, 59.94, 0.999999, -123.456, 4294967296.75, 0x1p63, 1e19, 1e18, -1e200 };
+	const uint8_t precisions[] = { 0, 1, 2, 5, 9, 10, 15, 20 };
+	for(uint32_t i = 0; i < sizeof(floats) / sizeof(*floats); i ++)
+		for(uint32_t p = 0; p < sizeof(precisions) / sizeof(*precisions); p ++) {
+			fmt_write(ours, sizeof(ours), gfx_fmt_float(floats[i], precisions[p]));
+			snprintf(theirs, sizeof(theirs), "%.*f", precisions[p], floats[i]);
+			assertstreq(ours, theirs);
+		}
+	fmt_write(ours, sizeof(ours), gfx_fmt_float(59.94, 2), " fps, frame ", 1234);
+	assertstreq(ours, "59.94 fps, frame 1234");
+	fmt_write(ours, sizeof(ours), gfx_fmt_float(NAN, 2), " ", gfx_fmt_float(INFINITY, 2), " ", gfx_fmt_float(-INFINITY, 0));
+	assertstreq(ours, "nan inf -inf");
+
+	// Cut off to fit, with the NUL, and at 256 bytes like text_fmt
+	asserteq(fmt_write(ours, 6, "frame ", 1234), 5);
+	assertstreq(ours, "frame");
+	asserteq(fmt_write(ours, sizeof(ours), gfx_fmt_float(-1.7976931348623157e308, 20)), 256);
+	snprintf(theirs, sizeof(theirs), "%.20f", -1.7976931348623157e308);
+	assert(!memcmp(ours, theirs, 256));
+
+	// Same glyphs either way, the difference is all in the formatting
+	double fps = 59.94;
+	BENCH("textf") textf(20, 60, "%.2f fps, frame %d", fps, 1234);
+	BENCH("text_fmt") text_fmt(20, 60, gfx_fmt_float(fps, 2), " fps, frame ", 1234);
+	BENCH("text_float") text_float(fps, 2, 20, 60);
+	BENCH("text") text("59.94", 20, 60);
+	gfx_frame();
+}
+// The quads drawn from vertex `first` on, without the zeroed ones text slots keep for spaces and newlines
+static uint32_t drawn_quads(uint32_t first, gfx_vertex* out, uint32_t max) {
+	gfx_vertex all[256];
+	uint32_t n = gfx_frame_vertices(first, all, 256), quads = 0;
+	if(n > 256) n = 256;
+	for(uint32_t i = 0; i + 4 <= n; i += 4) {
+		bool empty = true;
+		for(int j = 0; j < 4; j ++) empty &= !all[i + j].x && !all[i + j].y && !all[i + j].type && !all[i + j].data;
+		if(empty) continue;
+		for(int j = 0; j < 4 && quads * 4 + j < max; j ++) out[quads * 4 + j] = all[i + j];
+		quads ++;
+	}
+	return quads;
+}
+
+static bool same_vertices(const gfx_vertex* a, const gfx_vertex* b, uint32_t n) {
+	for(uint32_t i = 0; i < n; i ++)
+		if(a[i].x != b[i].x || a[i].y != b[i].y || a[i].type != b[i].type || a[i].data != b[i].data) return false;
+	return true;
+}
+
+TEST("text slots") {
+	gfx_textslot slot = gfx_textslot_new(fon, 20, 20, 90);
+	assert(slot >= 0);
+	asserteq(gfx_textslot_new(-1, 20, 0, 0), -1);
+
+	// After every edit the slot has to have the quads a fresh slot lays out for the text, which are the ones text() draws
+	const char* edits[] = {
+		"Frame 9 of the run",
+		"Frame 10 of the run",     // Grows
+		"Frame 7 of the run",      // Shrinks
+		"Frame 7\nof the run",     // Adds a newline
+		"Frame 70\nof the run",    // Grows before it
+		"Frame 70 of the run",     // Takes it out
+		"Frame 70 of the r\u00FCn", // A multibyte codepoint
+		"Frame 70 of the r\u00E9n", // Changes to another one with the same first byte
+		"Frame 70 of the run",
+		"",
+		"Frame 1",
+	};
+	font(fon, 20);
+	gfx_vertex edited[256], fresh[256], drawn[256];
+	for(uint32_t i = 0; i < sizeof(edits) / sizeof(*edits); i ++) {
+		gfx_textslot_set(slot, edits[i]);
+		gfx_textslot other = gfx_textslot_new(fon, 20, 20, 90);
+		gfx_textslot_set(other, edits[i]);
+
+		uint32_t first = gfx_frame_vertices(0, NULL, 0);
+		gfx_textslot_draw(slot);
+		uint32_t quads = drawn_quads(first, edited, 256);
+		first = gfx_frame_vertices(0, NULL, 0);
+		gfx_textslot_draw(other);
+		asserteq(drawn_quads(first, fresh, 256), quads);
+		first = gfx_frame_vertices(0, NULL, 0);
+		text(edits[i], 20, 90);
+		asserteq(drawn_quads(first, drawn, 256), quads);
+
+		assert(same_vertices(edited, fresh, quads * 4));
+		assert(same_vertices(edited, drawn, quads * 4));
+		gfx_textslot_free(other);
+	}
+	gfx_frame();
+
+	// Only the digits that change get laid out again, the rest of the string keeps its quads
+	char counter[32];
+	int frame = 0;
+	BENCH("counter") {
+		snprintf(counter, sizeof(counter), "Frame %d of the run", frame ++);
+		gfx_textslot_set(slot, counter);
+		gfx_textslot_draw(slot);
+	}
+	BENCH("same with text()") text(counter, 20, 90);
+	gfx_frame();
+	gfx_textslot_free(slot);
+}
+
+TEST("frame arena") {
+	// Scratch buffers come out of the frame arena and all go back at once in gfx_frame()
+	textf(20, 120, "%s %d", "Longer than the 256 bytes textf used to have on the stack. Longer than the 256 bytes textf used to have on the stack. Longer than the 256 bytes textf used to have on the stack. Longer than the 256 bytes textf used to have on the stack.", 4);
+	gfx_preload_glyphs(fon, 33, (gfx_range[]) { { 'a', 'z' } }, 1);
+	gfx_frame();
+	gfx_stats stats = gfx_get_stats();
+	assert(stats.frame_allocs >= 2);
+	assert(stats.frame_arena_bytes > 0);
+
+	gfx_frame();
+	asserteq(gfx_get_stats().frame_allocs, 0);
+	asserteq(gfx_get_stats().frame_arena_bytes, 0);
+}
+TEST("frame stats") {
+	for (int i = 0; i < 10; i++) {
+		rect(100, 100, 200, 200);
+		image(hi, 300, 200, 100, 100);
+		gfx_default_fps_counter();
+		gfx_frame();
+	}
+	gfx_stats stats = gfx_get_stats();
+	assert(stats.draw_calls >= 1);
+	assert(stats.vertices >= 8 && stats.indices >= 12);
+	assert(stats.upload_bytes > 0);
+	assert(stats.frame_ms > 0 && stats.cpu_ms > 0);
+	assert(stats.atlas_occupancy > 0 && stats.atlas_occupancy <= 1);
+	asserteq(gfx_get_frame_stats(0)->draw_calls, stats.draw_calls);
+	assert(gfx_get_frame_stats(GFX_STATS_HISTORY) == NULL);
+
+	gfx_frame_history history = gfx_get_frame_history();
+	assert(history.frames >= 10);
+	assert(history.frame_ms.p50 <= history.frame_ms.p99 && history.frame_ms.p99 <= history.frame_ms.max);
+}
+TEST("render thread") {
+	gfx_setting_set(GFX_SETTING_RENDER_THREAD, &(bool) { true });
+	gfx_frame();
+
+	// New glyphs, a new texture and text that gets drawn every frame, all made while the render thread has the context
+	gfx_img again = gfx_load_img("hyperAngery.png");
+	int frame = 0;
+	BENCH("frame") {
+		fill(255, 255, 255, 255);
+		rect(100, 100, 200, 200);
+		image(again, 300, 200, 100, 100);
+		font_size(31);
+		textf(20, 150, "Frame %d, drawn on the render thread", frame ++);
+		gfx_frame();
+	}
+	gfx_stats stats = gfx_get_stats();
+	assert(stats.render_latency > 0);
+	assert(stats.render_submit > 0);
+	assert(stats.render_overlap >= 0);
+
+	// The context comes back, with the textures the render thread made
+	gfx_setting_set(GFX_SETTING_RENDER_THREAD, &(bool) { false });
+	gfx_frame();
+	image(again, 300, 200, 100, 100);
+	text("Back on the main thread", 20, 150);
+	gfx_frame();
+}
+
+// Dashboard panels, each made on its own thread
+#define PANELS 4
+static gfx_drawlist* panels[PANELS];
+
+static tests_thread_ret record_panel(void* arg) {
+	uintptr_t i = (uintptr_t) arg;
+	gfx_drawlist* list = panels[i];
+	gfx_drawlist_clear(list);
+	gfx_drawlist_fill(list, 60 * i, 80, 160, 255);
+	gfx_drawlist_rect(list, 20 + i * 150, 600, 140, 100);
+	gfx_drawlist_image(list, hi, 30 + i * 150, 610, 40, 40);
+	gfx_drawlist_font(list, fon, 23);
+	gfx_drawlist_text(list, "Panel AVAV", 30 + i * 150, 680);
+	gfx_drawlist_submit(list);
+	return 0;
+}
+
+// The context's thread keeps drawing text at a new size while the panels get made, which changes the glyph cache
+static void record_panels() {
+	tests_thread threads[PANELS];
+	for (uintptr_t i = 0; i < PANELS; i++) tests_thread_start(threads + i, record_panel, (void*) i);
+	font(fon, 19);
+	text("Drawn while the panels are being made", 20, 580);
+	font(fon, 20);
+	for (int i = 0; i < PANELS; i++) tests_thread_join(threads[i]);
+}
+
+TEST("draw lists") {
+	for (int i = 0; i < PANELS; i++) panels[i] = gfx_drawlist_new(0);
+
+	// Nothing was ever drawn at 23, so the text gets laid out when the lists are merged, which caches its glyphs
+	record_panels();
+	gfx_frame();
+	asserteq(gfx_get_stats().drawlist_text_deferred, PANELS);
+	record_panels();
+	gfx_frame();
+	asserteq(gfx_get_stats().drawlist_text_deferred, 0);
+
+	BENCH("frame") {
+		record_panels();
+		gfx_frame();
+	}
+
+	// Lists keep what they have, so submitting them again draws the same panels
+	for (int i = 0; i < PANELS; i++) gfx_drawlist_submit(panels[i]);
+	gfx_frame();
+	for (int i = 0; i < PANELS; i++) gfx_drawlist_free(panels[i]);
+}
+
+// Jobs that split their part up again with a parallel for, which waits inside a job
+#define PARTS 8
+#define PART 20000
+static uint64_t squares[PARTS * PART];
+
+static void fill_squares(void* arg, uint32_t from, uint32_t to) {
+	uint64_t* part = arg;
+	for (uint32_t i = from; i < to; i++) part[i] = (uint64_t) (part - squares + i) * (part - squares + i);
+}
+
+static void fill_part(void* arg) {
+	gfx_parallel_for(PART, 1000, fill_squares, squares + (uintptr_t) arg * PART);
+}
+
+static void nothing(void* arg) {}
+
+TEST("jobs") {
+	gfx_job* parts[PARTS];
+	for (uintptr_t i = 0; i < PARTS; i++) parts[i] = gfx_job_submit(fill_part, (void*) i);
+	for (int i = 0; i < PARTS; i++) gfx_job_wait(parts[i]);
+	bool right = true;
+	for (uint64_t i = 0; i < PARTS * PART; i++) right &= squares[i] == i * i;
+	assert(right);
+
+	// Big batches of glyphs get rasterized on the pool
+	uint32_t loads = gfx_get_stats().glyph_loads;
+	gfx_preload_glyphs(fon, 37, (gfx_range[]) { { '!', '~' } }, 1);
+	assert(gfx_get_stats().glyph_loads > loads + 80);
+
+	BENCH("submit and wait") gfx_job_wait(gfx_job_submit(nothing, NULL));
+	BENCH("parallel for") gfx_parallel_for(PARTS * PART, 4096, fill_squares, squares);
+}
+
+// A second window sharing the first one's textures and glyphs, drawn on its own thread while this one keeps drawing
+// the first window and polling events for both
+static struct gfx_ctx* second;
+static _Atomic bool second_done;
+static uint32_t second_loads, second_atlases;
+
+static tests_thread_ret draw_second(void* arg) {
+	gfx_ctx_set(second);
+	for (int i = 0; i < 20; i++) {
+		fill(255, 255, 255, 255);
+		image(hi, 20, 20, 100, 100);
+		font(fon, 37);
+		textf(20, 200, "Frame %d, same glyphs", i);
+		gfx_frame();
+	}
+	second_loads = gfx_get_stats().glyph_loads;
+	second_atlases = gfx_get_stats().atlases;
+	gfx_ctx_set(NULL);
+	atomic_store(&second_done, true);
+	return 0;
+}
+
+TEST("shared windows") {
+	uint32_t atlases = gfx_get_stats().atlases;
+	second = gfx_init("second window", &(gfx_settings) { .width = 400, .height = 300, .dont_store_settings = true, .share = first });
+	assert(second);
+	gfx_ctx_set(first);
+
+	tests_thread t;
+	tests_thread_start(&t, draw_second, NULL);
+	while (!atomic_load(&second_done)) {
+		font(fon, 37);
+		text("Drawn next to the second window", 20, 250);
+		gfx_frame();
+	}
+	tests_thread_join(t);
+
+	// Everything it drew was already loaded by this window
+	asserteq(second_loads, 0);
+	asserteq(second_atlases, atlases);
+}
 
 #include "tests_end.h"
@@ -0,0 +1,137 @@
+#include "tests.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <stdint.h>
+#include "../deps/extern/libatures/libatures.h"
+
+// Shaping throughput for libatures. Defaults to the bundled roboto.ttf, but the numbers that matter come from a
+// programming-ligature font, so point GSUB_FONT at one (e.g. `set GSUB_FONT=FiraCode-Regular.ttf`).
+
+static const char* src =
+	"if (a != b && c >= d || e <= f) { x => y; p -> q; i++; j--; }\n"
+	"#define MAX(a, b) ((a) > (b) ? (a) : (b)) // === !== <=> ::= ..= ...\n"
+	"fi fl ffi ffl office affluent <!-- --> </> /* ** */ www |> <| >>= <<= ~~ %% &&& |||\n";
+
+static FT_Library lib;
+static FT_Face face;
+static LBT_ChainCreator* lbt;
+static LBT_Chain* chain;
+static LBT_Glyph* input;
+static size_t input_len;
+
+static const unsigned char features[][4] = { {'c','a','l','t'}, {'c','l','i','g'}, {'d','l','i','g'}, {'l','i','g','a'}, {'r','l','i','g'}, {'c','c','m','p'}, {' ','R','Q','D'} };
+
+INIT() {
+	tests_load_font("GSUB_FONT", &lib, &face);
+	lbt = LBT_new(face);
+	chain = LBT_generate_chain(lbt, NULL, NULL, features, sizeof(features) / sizeof(*features));
+
+	// Repeat the snippet into a decently sized buffer so per-call overhead doesn't dominate
+	size_t len = strlen(src);
+	input_len = len * 64;
+	input = malloc(input_len * sizeof(LBT_Glyph));
+	for (size_t i = 0; i < input_len; i++) input[i] = FT_Get_Char_Index(face, src[i % len]);
+}
+
+TEST("Chain generation") {
+	assert(lbt);
+	assert(chain);
+	BENCH("generate + destroy") LBT_destroy_chain(LBT_generate_chain(lbt, NULL, NULL, features, sizeof(features) / sizeof(*features)));
+}
+
+TEST("Substitution") {
+	size_t out_len = 0;
+	LBT_Glyph* out = LBT_apply_chain(chain, input, input_len, &out_len);
+	assert(out);
+	assert(out_len <= input_len);
+
+	// Applying twice has to give the same glyphs, cached tables or not
+	size_t again_len = 0;
+	LBT_Glyph* again = LBT_apply_chain(chain, input, input_len, &again_len);
+	asserteq(again_len, out_len);
+	assert(!memcmp(out, again, out_len * sizeof(LBT_Glyph)));
+	free(again);
+	free(out);
+
+	unsigned long long glyphs = 0;
+	unsigned long long start = get_precise_time();
+	BENCH("apply_chain") {
+		LBT_Glyph* o = LBT_apply_chain(chain, input, input_len, NULL);
+		glyphs += input_len;
+		free(o);
+	}
+	double secs = (double)(get_precise_time() - start) / tests_clocks_per_sec;
+	printf("\n" SUBTESTINDENT "%.2f Mglyphs/sec (%zu glyphs in, %zu out)", glyphs / secs / 1e6, input_len, out_len);
+}
+
+// Glyph IDs in the bundled roboto.ttf, whatever GSUB_FONT is. Its ligatures are only in the latn script.
+static LBT_Glyph* shape_roboto(LBT_Chain* with, FT_Face roboto, const char* str, size_t* n) {
+	LBT_Glyph in[32];
+	size_t len = strlen(str);
+	for (size_t i = 0; i < len; i++) in[i] = FT_Get_Char_Index(roboto, str[i]);
+	return LBT_apply_chain(with, in, len, n);
+}
+#define assert_shapes(str, ...) do {\
+	size_t n;\
+	LBT_Glyph* got = shape_roboto(latn, roboto, str, &n);\
+	asserteq(n, sizeof((LBT_Glyph[]) __VA_ARGS__) / sizeof(LBT_Glyph));\
+	assert(!memcmp(got, (LBT_Glyph[]) __VA_ARGS__, sizeof((LBT_Glyph[]) __VA_ARGS__)));\
+	free(got);\
+} while(0)
+
+TEST("Known ligatures") {
+	FT_Face roboto;
+	assert(!FT_New_Face(lib, "roboto.ttf", 0, &roboto));
+	LBT_ChainCreator* creator = LBT_new(roboto);
+	static const unsigned char latn_tag[4] = {'l','a','t','n'};
+	LBT_Chain* latn = LBT_generate_chain(creator, &latn_tag, NULL, features, sizeof(features) / sizeof(*features));
+	assert(latn);
+
+	// The ligature trie has to pick the first ligature of the set that matches, like the LigatureSet would
+	LBT_Glyph f = FT_Get_Char_Index(roboto, 'f'), o = FT_Get_Char_Index(roboto, 'o');
+	LBT_Glyph c = FT_Get_Char_Index(roboto, 'c'), e = FT_Get_Char_Index(roboto, 'e');
+	assert_shapes("ffi", { 446 });
+	assert_shapes("fi", { 444 });
+	assert_shapes("ffl", { 447 });
+	assert_shapes("fff", { 443, f });
+	assert_shapes("office", { o, 446, c, e });
+	assert_shapes("of", { o, f });
+
+	LBT_destroy_chain(latn);
+	LBT_destroy(creator);
+	FT_Done_Face(roboto);
+}
+
+// Several threads applying the one chain have to get what one thread does
+#define THREADS 4
+static LBT_Glyph* expected;
+static size_t expected_len;
+static _Atomic int mismatches;
+
+static tests_thread_ret apply_shared(void* arg) {
+	for (int i = 0; i < 50; i++) {
+		size_t len;
+		LBT_Glyph* out = LBT_apply_chain(chain, input, input_len, &len);
+		if (len != expected_len || memcmp(out, expected, len * sizeof(LBT_Glyph))) mismatches++;
+		free(out);
+	}
+	return 0;
+}
+
+TEST("Shared between threads") {
+	expected = LBT_apply_chain(chain, input, input_len, &expected_len);
+	tests_thread threads[THREADS];
+	for (int t = 0; t < THREADS; t++) tests_thread_start(threads + t, apply_shared, NULL);
+	for (int t = 0; t < THREADS; t++) tests_thread_join(threads[t]);
+	asserteq(mismatches, 0);
+	free(expected);
+}
+
+TEST("Short strings") {
+	// Roughly what 2dgfx does per line of a text() call
+	BENCH("apply_chain 16 glyphs") free(LBT_apply_chain(chain, input, 16, NULL));
+}
+
+#include "tests_end.h"
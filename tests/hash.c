@@ -0,0 +1,101 @@
+#include "tests.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <hash.h>
+#include "references/khash.h"
+
+// hash.h's SwissTable against the khash it replaced, with 64 bit keys like glyph idents and string keys like uniform
+// names. Hits look up keys that are all there, misses keys that never were, and deletes take every key back out.
+// The request also named kahash, but no copy of it is in the tree or in references/ to compare against, and khash,
+// which hash.h used to be, is the one the old numbers came from.
+
+#define KEYS 50000
+
+static uint64_t ints[KEYS], missing_ints[KEYS];
+static char* strs[KEYS];
+static char* missing_strs[KEYS];
+
+ht(swiss_int, uint64_t, uint32_t) swiss_ints;
+ht_impl(swiss_int, uint64_t, uint32_t, ht_int64_hash_func, ht_int64_hash_equal);
+kht(kh_int, uint64_t, uint32_t) kh_ints;
+kh_impl(kh_int, uint64_t, uint32_t, kh_int64_hash_func, kh_int64_hash_equal);
+
+ht(swiss_str, char*, uint32_t) swiss_strs;
+ht_impl_str(swiss_str, uint32_t);
+kht(kh_str, char*, uint32_t) kh_strs;
+kh_impl_str(kh_str, uint32_t);
+
+static uint64_t rand64() {
+	return (uint64_t) rand() << 42 ^ (uint64_t) rand() << 21 ^ rand();
+}
+
+INIT() {
+	srand(1);
+	for (int i = 0; i < KEYS; i++) {
+		ints[i] = rand64();
+		missing_ints[i] = rand64();
+		strs[i] = malloc(24);
+		missing_strs[i] = malloc(24);
+		snprintf(strs[i], 24, "u_uniform_%d", i);
+		snprintf(missing_strs[i], 24, "u_missing_%d", i);
+	}
+	tests_benchiters = 20; // Every run goes over all the keys
+}
+
+// Inserts go into a cleared table, so they're timed without it growing. Deletes are timed with the inserts that put
+// the keys back, take the insert time off to get theirs.
+#define BENCH_TABLE(label, name, put, get, del, clear, keys, missing, table) do {                      \
+	unsigned long long start = get_precise_time();                                                     \
+	BENCH(label " insert") {                                                                           \
+		clear(name, table);                                                                            \
+		for (int i = 0; i < KEYS; i++) *put(name, table, keys[i]) = i;                                 \
+	}                                                                                                  \
+	tests_report_rate(start, (double) tests_benchiters * KEYS, "ops");                                 \
+	start = get_precise_time();                                                                        \
+	BENCH(label " insert + delete") {                                                                  \
+		for (int i = 0; i < KEYS; i++) *put(name, table, keys[i]) = i;                                 \
+		for (int i = 0; i < KEYS; i++) del(name, table, keys[i]);                                      \
+	}                                                                                                  \
+	tests_report_rate(start, (double) tests_benchiters * KEYS, "ops");                                 \
+	for (int i = 0; i < KEYS; i++) *put(name, table, keys[i]) = i;                                     \
+	volatile uint32_t sink = 0;                                                                        \
+	start = get_precise_time();                                                                        \
+	BENCH(label " hit") for (int i = 0; i < KEYS; i++) sink += *get(name, table, keys[i]);             \
+	tests_report_rate(start, (double) tests_benchiters * KEYS, "ops");                                 \
+	start = get_precise_time();                                                                        \
+	BENCH(label " miss") for (int i = 0; i < KEYS; i++) sink += get(name, table, missing[i]) != NULL;  \
+	tests_report_rate(start, (double) tests_benchiters * KEYS, "ops");                                 \
+	clear(name, table);                                                                                \
+} while (0)
+
+// khash's _del takes the slot instead of the key
+#define kh_int_remove(h, key) kh_int_del(h, khget(kh_int, *(h), key) ? khget(kh_int, *(h), key) - (h)->vals : (h)->n_buckets)
+#define kh_str_remove(h, key) kh_str_del(h, khget(kh_str, *(h), key) ? khget(kh_str, *(h), key) - (h)->vals : (h)->n_buckets)
+#define khremove(name, h, key) name##_remove(&h, key)
+
+TEST("Same answers") {
+	for (int i = 0; i < KEYS; i++) *hput(swiss_int, swiss_ints, ints[i]) = i, *khput(kh_int, kh_ints, ints[i]) = i;
+	for (int i = 0; i < KEYS; i++) {
+		asserteq(*hget(swiss_int, swiss_ints, ints[i]), *khget(kh_int, kh_ints, ints[i]));
+		assert(!hget(swiss_int, swiss_ints, missing_ints[i]));
+	}
+	asserteq(swiss_ints.size, KEYS);
+	for (int i = 0; i < KEYS; i += 2) hdel(swiss_int, swiss_ints, ints[i]);
+	asserteq(swiss_ints.size, KEYS / 2);
+	for (int i = 0; i < KEYS; i++) asserteq(hget(swiss_int, swiss_ints, ints[i]) != NULL, i % 2);
+	hclear(swiss_int, swiss_ints);
+	khclear(kh_int, kh_ints);
+}
+
+TEST("64 bit keys") {
+	BENCH_TABLE("swiss", swiss_int, hput, hget, hdel, hclear, ints, missing_ints, swiss_ints);
+	BENCH_TABLE("khash", kh_int, khput, khget, khremove, khclear, ints, missing_ints, kh_ints);
+}
+
+TEST("String keys") {
+	BENCH_TABLE("swiss", swiss_str, hput, hget, hdel, hclear, strs, missing_strs, swiss_strs);
+	BENCH_TABLE("khash", kh_str, khput, khget, khremove, khclear, strs, missing_strs, kh_strs);
+}
+
+#include "tests_end.h"
@@ -0,0 +1,112 @@
+#include "tests.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <hash.h>
+
+// Glyph lookups the way text() does them for every codepoint. It used to map through the cmap, then hash
+// {glyph, size} into the face's table of 24 byte chars. Now it indexes a per size table of 16 byte chars by
+// codepoint, for codepoints under 0x250. Set LOOKUP_FONT to try another font.
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef struct { int16_t x, y; } mini;
+
+// What 2dgfx's gfx_char was before
+typedef struct old_char {
+	mini place, size, bearing;
+	u16 advance;
+	u32 atlas;
+	u32 glyph;
+} old_char;
+
+// And what it is now
+typedef struct new_char {
+	u16 uv_x, uv_y;
+	mini size, bearing;
+	u16 advance;
+	u8 atlas;
+	bool loaded;
+} new_char;
+
+typedef union ident { struct { u32 glyph, size; }; u64 full; } ident;
+#define IDENT_EQUAL(a, b) (a.full == b.full)
+#define IDENT_HASH(a) (ht_int64_hash_func(a.full))
+static ht(old_char, ident, old_char) chars;
+ht_impl(old_char, ident, old_char, IDENT_HASH, IDENT_EQUAL);
+
+#define LOW 0x250
+#define SIZES 8
+
+static FT_Library lib;
+static FT_Face face;
+static new_char low[SIZES][LOW];
+static u16 low_glyphs[LOW];
+
+static const char text[] =
+	"The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs! "
+	"Sphinx of black quartz, judge my vow; 0123456789 (x + y) * z = {w} <> [] ~ @ # $ % ^ & ";
+#define TEXT_LEN (sizeof(text) - 1)
+
+INIT() {
+	tests_load_font("LOOKUP_FONT", &lib, &face);
+
+	// Every printable ASCII glyph at every size, in both
+	for (u32 size = 0; size < SIZES; size++)
+		for (u32 c = ' '; c < 127; c++) {
+			u32 glyph = FT_Get_Char_Index(face, c);
+			*hput(old_char, chars, { glyph, 12 + size * 4 }) = (old_char) { .advance = c, .glyph = glyph };
+			low[size][c] = (new_char) { .advance = c, .loaded = true };
+			low_glyphs[c] = glyph;
+		}
+}
+
+TEST("Same glyphs") {
+	asserteq(sizeof(new_char), 16);
+	for (u32 i = 0; i < TEXT_LEN; i++) {
+		old_char* ch = hget(old_char, chars, { FT_Get_Char_Index(face, text[i]), 20 });
+		asserteq(ch->advance, low[2][(u8) text[i]].advance);
+		asserteq(ch->glyph, low_glyphs[(u8) text[i]]);
+	}
+}
+
+TEST("Lookups") {
+	volatile u32 sink = 0;
+	unsigned long long lookups = 0, start = get_precise_time();
+	BENCH("cmap + hash") {
+		for (u32 i = 0; i < TEXT_LEN; i++) {
+			old_char* ch = hget(old_char, chars, { FT_Get_Char_Index(face, text[i]), 12 + (i & 7) * 4 });
+			sink += ch->advance;
+		}
+		lookups += TEXT_LEN;
+	}
+	tests_report_rate(start, lookups, "lookups");
+
+	// Just the hash, as if the cmap lookup were free
+	u32 glyphs[TEXT_LEN];
+	for (u32 i = 0; i < TEXT_LEN; i++) glyphs[i] = FT_Get_Char_Index(face, text[i]);
+	lookups = 0, start = get_precise_time();
+	BENCH("hash") {
+		for (u32 i = 0; i < TEXT_LEN; i++) sink += hget(old_char, chars, { glyphs[i], 12 + (i & 7) * 4 })->advance;
+		lookups += TEXT_LEN;
+	}
+	tests_report_rate(start, lookups, "lookups");
+
+	lookups = 0, start = get_precise_time();
+	BENCH("low codepoint table") {
+		for (u32 i = 0; i < TEXT_LEN; i++) {
+			new_char* ch = low[i & 7] + (u8) text[i];
+			if (ch->loaded) sink += ch->advance + low_glyphs[(u8) text[i]];
+		}
+		lookups += TEXT_LEN;
+	}
+	tests_report_rate(start, lookups, "lookups");
+}
+
+#include "tests_end.h"
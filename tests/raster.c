@@ -0,0 +1,130 @@
+#include "tests.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb/stb_truetype.h>
+
+#define RASTER_H_IMPLEMENTATION
+#include <raster.h>
+
+// Bulk glyph loads through FreeType's rasterizer (FT_LOAD_RENDER) against raster.h drawing the same outlines, and
+// stb_truetype's rasterizer against raster.h drawing stbtt's outlines. Set RASTER_FONT to try another font.
+
+static const unsigned sizes[] = { 12, 16, 24, 32, 48, 72 };
+#define SIZES (sizeof(sizes) / sizeof(*sizes))
+
+static FT_Library lib;
+static FT_Face face;
+static stbtt_fontinfo info;
+static unsigned char* file;
+static raster_canvas canvas;
+static FT_UInt glyphs[94]; // Printable ASCII
+
+INIT() {
+	tests_load_font("RASTER_FONT", &lib, &face);
+	FILE* f = fopen(tests_font("RASTER_FONT"), "rb");
+	fseek(f, 0, SEEK_END);
+	long len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	file = malloc(len);
+	fread(file, 1, len, f);
+	fclose(f);
+	stbtt_InitFont(&info, file, stbtt_GetFontOffsetForIndex(file, 0));
+
+	for (int i = 0; i < 94; i++) glyphs[i] = FT_Get_Char_Index(face, '!' + i);
+}
+
+TEST("Matches FreeType") {
+	for (int s = 0; s < SIZES; s++) {
+		FT_Set_Pixel_Sizes(face, 0, sizes[s]);
+		unsigned long long total = 0, pixels = 0;
+		for (int i = 0; i < 94; i++) {
+			FT_Load_Glyph(face, glyphs[i], FT_LOAD_DEFAULT);
+			raster_ft_outline(&canvas, &face->glyph->outline);
+			uint8_t* ours = raster_end(&canvas);
+			FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL);
+
+			FT_Bitmap* bmp = &face->glyph->bitmap;
+			asserteq(canvas.w, bmp->width);
+			asserteq(canvas.h, bmp->rows);
+			asserteq(canvas.left, face->glyph->bitmap_left);
+			asserteq(canvas.top, face->glyph->bitmap_top);
+			for (unsigned y = 0; y < bmp->rows; y++)
+				for (unsigned x = 0; x < bmp->width; x++)
+					total += abs(ours[y * canvas.w + x] - bmp->buffer[y * bmp->pitch + x]);
+			pixels += bmp->rows * bmp->width;
+		}
+		// Both compute exact area coverage, only the curve flattening differs
+		assert(total < pixels * 2);
+	}
+}
+
+TEST("FreeType outlines") {
+	unsigned long long loads = 0, start = get_precise_time();
+	BENCH("FT_LOAD_RENDER") {
+		for (int s = 0; s < SIZES; s++) {
+			FT_Set_Pixel_Sizes(face, 0, sizes[s]);
+			for (int i = 0; i < 94; i++) FT_Load_Glyph(face, glyphs[i], FT_LOAD_RENDER);
+		}
+		loads += SIZES * 94;
+	}
+	tests_report_rate(start, loads, "glyphs");
+
+	loads = 0, start = get_precise_time();
+	BENCH("FT_LOAD_DEFAULT + raster.h") {
+		for (int s = 0; s < SIZES; s++) {
+			FT_Set_Pixel_Sizes(face, 0, sizes[s]);
+			for (int i = 0; i < 94; i++) {
+				FT_Load_Glyph(face, glyphs[i], FT_LOAD_DEFAULT);
+				raster_ft_outline(&canvas, &face->glyph->outline);
+				raster_end(&canvas);
+			}
+		}
+		loads += SIZES * 94;
+	}
+	tests_report_rate(start, loads, "glyphs");
+
+	// How much of either is the loading and hinting, which both have to do
+	loads = 0, start = get_precise_time();
+	BENCH("FT_LOAD_DEFAULT only") {
+		for (int s = 0; s < SIZES; s++) {
+			FT_Set_Pixel_Sizes(face, 0, sizes[s]);
+			for (int i = 0; i < 94; i++) FT_Load_Glyph(face, glyphs[i], FT_LOAD_DEFAULT);
+		}
+		loads += SIZES * 94;
+	}
+	tests_report_rate(start, loads, "glyphs");
+}
+
+TEST("stb_truetype outlines") {
+	unsigned long long loads = 0, start = get_precise_time();
+	BENCH("stbtt_GetGlyphBitmap") {
+		for (int s = 0; s < SIZES; s++) {
+			float scale = stbtt_ScaleForPixelHeight(&info, sizes[s]);
+			for (int i = 0; i < 94; i++) {
+				int w, h;
+				unsigned char* bmp = stbtt_GetGlyphBitmap(&info, scale, scale, glyphs[i], &w, &h, NULL, NULL);
+				stbtt_FreeBitmap(bmp, NULL);
+			}
+		}
+		loads += SIZES * 94;
+	}
+	tests_report_rate(start, loads, "glyphs");
+
+	loads = 0, start = get_precise_time();
+	BENCH("raster.h") {
+		for (int s = 0; s < SIZES; s++) {
+			float scale = stbtt_ScaleForPixelHeight(&info, sizes[s]);
+			for (int i = 0; i < 94; i++) {
+				raster_stbtt_glyph(&canvas, &info, glyphs[i], scale);
+				raster_end(&canvas);
+			}
+		}
+		loads += SIZES * 94;
+	}
+	tests_report_rate(start, loads, "glyphs");
+}
+
+#include "tests_end.h"
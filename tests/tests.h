@@ -1,5 +1,5 @@
 /*
- * tests.h v3.2.6 - Aqil Contractor @AqilC 2024
+ * tests.h v3.3.0 - Aqil Contractor @AqilC 2024
  * Licenced under Attribution-NonCommercial-ShareAlike 3.0
  *
  * This file is the beginning file of the 'tests.h' testing framework made by Aqil Contractor. To use this framework,
@@ -28,6 +28,7 @@
  *
  * Version History:
  * - Other versions only include minor changes, bug fixes, or small features.
+ * - 3.3.0 - Add helpers the benchmarks share: rates, a fixture font, threads and locks.
  * - 3.2.0 - Remove some macros used internally.
  * - 3.1.0 - Change test output colors.
  * - 3.0.0 - Change test syntax completely, allowing SUB("subtest name") {} instead of subtest("subtest name"); ... subend();
@@ -50,6 +51,7 @@
 
 
 #include <setjmp.h>
+#include <stdlib.h>
 
 jmp_buf tests_jmp_buf;
 unsigned int sigthing = 0;
@@ -373,6 +375,54 @@ static inline _Bool benchend_() {
 	return 0;
 }
 
+// ------------------------------------------------------------------- HELPERS --------------------------------------------------------------------
+
+// Prints how many of something a benchmark got through per second since start, e.g. tests_report_rate(start, loads, "glyphs")
+static void tests_report_rate(unsigned long long start, double count, const char* what) {
+	double rate = count / ((double)(get_precise_time() - start) / tests_clocks_per_sec);
+	if(rate >= 1e6) printf("\n" SUBTESTINDENT "%.1fM %s/sec", rate / 1e6, what);
+	else printf("\n" SUBTESTINDENT "%.0f %s/sec", rate, what);
+}
+
+// The font the FreeType tests load: whatever the env variable names, or the bundled roboto.ttf. tests_load_font exits
+// when it can't be loaded since nothing after would work, and needs FreeType included before it's used.
+static inline const char* tests_font(const char* env) {
+	const char* path = getenv(env);
+	return path ? path : "roboto.ttf";
+}
+#define tests_load_font(env, lib, face) do {\
+	const char* tests_font_path = tests_font(env);\
+	if(FT_Init_FreeType(lib) || FT_New_Face(*(lib), tests_font_path, 0, (face))) {\
+		printf("Couldn't load font '%s'\n", tests_font_path);\
+		exit(1);\
+	}\
+} while(0)
+
+// Threads and locks for the tests that push from several threads at once
+#ifdef _WIN32
+	typedef HANDLE tests_thread;
+	typedef DWORD tests_thread_ret;
+	#define tests_thread_start(t, fn, arg) (*(t) = CreateThread(NULL, 0, (fn), (arg), 0, NULL))
+	#define tests_thread_join(t) (WaitForSingleObject((t), INFINITE), CloseHandle(t))
+	typedef CRITICAL_SECTION tests_lock;
+	#define tests_lock_init(l) InitializeCriticalSection(l)
+	#define tests_lock_take(l) EnterCriticalSection(l)
+	#define tests_lock_give(l) LeaveCriticalSection(l)
+#else
+	#include <pthread.h>
+	typedef pthread_t tests_thread;
+	typedef void* tests_thread_ret;
+	#define tests_thread_start(t, fn, arg) pthread_create((t), NULL, (fn), (arg))
+	#define tests_thread_join(t) pthread_join((t), NULL)
+	typedef pthread_mutex_t tests_lock;
+	#define tests_lock_init(l) pthread_mutex_init((l), NULL)
+	#define tests_lock_take(l) pthread_mutex_lock(l)
+	#define tests_lock_give(l) pthread_mutex_unlock(l)
+#endif
+
+
+
+
 // ---------------------------------------------------- Macro based testing framework starts here ----------------------------------------------------
 
 #define TESTCONCAT(a, b) a##b
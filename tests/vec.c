@@ -0,0 +1,125 @@
+#include "tests.h"
+
+#include <stdint.h>
+#include <vec.h>
+
+// Push throughput of the vec.h macros. Every push used to go out of line through vpush_ and the realloc check, now
+// the macros only call it when the vector has to grow. Quads are six indices and four vertices, what drawing a glyph
+// pushes. The vectors are kept between runs and emptied, like the draw buffer is every frame.
+
+typedef struct vtx { float x, y, u, v; uint32_t color; } vtx;
+#define QUADS 1024
+
+static uint32_t* idx;
+static vtx* verts;
+
+INIT() {
+	idx = vnew();
+	verts = vnew();
+}
+
+// The old vpusharr, before it checked for room inline
+#define vpusharr_old(x, ...) (memcpy(vpush_((void**)&(x), sizeof((typeof(*(x))[]) __VA_ARGS__)), (typeof(*(x))[]) __VA_ARGS__, sizeof((typeof(*(x))[]) __VA_ARGS__)))
+
+static void quads_old() {
+	vempty(idx);
+	vempty(verts);
+	for (uint32_t i = 0; i < QUADS; i++) {
+		uint32_t at = i * 4;
+		vpusharr_old(idx, { at, at + 1, at + 2, at + 2, at, at + 3 });
+		vpusharr_old(verts, { { i, 0, 0, 0, at }, { i, 1, 0, 1, at }, { i + 1, 1, 1, 1, at }, { i + 1, 0, 1, 0, at } });
+	}
+}
+
+static void quads_arr() {
+	vempty(idx);
+	vempty(verts);
+	for (uint32_t i = 0; i < QUADS; i++) {
+		uint32_t at = i * 4;
+		vpusharr(idx, { at, at + 1, at + 2, at + 2, at, at + 3 });
+		vpusharr(verts, { { i, 0, 0, 0, at }, { i, 1, 0, 1, at }, { i + 1, 1, 1, 1, at }, { i + 1, 0, 1, 0, at } });
+	}
+}
+
+static void quads_uninit() {
+	vempty(idx);
+	vempty(verts);
+	vreserve(idx, QUADS * 6);
+	vreserve(verts, QUADS * 4);
+	for (uint32_t i = 0; i < QUADS; i++) {
+		uint32_t at = i * 4;
+		uint32_t* in = vpush_uninit(idx, 6);
+		in[0] = at, in[1] = at + 1, in[2] = at + 2, in[3] = at + 2, in[4] = at, in[5] = at + 3;
+		vtx* v = vpush_uninit(verts, 4);
+		v[0] = (vtx) { i, 0, 0, 0, at };
+		v[1] = (vtx) { i, 1, 0, 1, at };
+		v[2] = (vtx) { i + 1, 1, 1, 1, at };
+		v[3] = (vtx) { i + 1, 0, 1, 0, at };
+	}
+}
+
+TEST("Same contents") {
+	asserteq(sizeof(_DATA(idx)->used), 8);
+
+	quads_old();
+	uint32_t* want_idx = vnew();
+	vtx* want_verts = vnew();
+	vpushv(want_idx, idx);
+	vpushv(want_verts, verts);
+	quads_arr();
+	asserteq(vlen(idx), QUADS * 6);
+	assert(!vcmp(idx, want_idx) && !vcmp(verts, want_verts));
+	quads_uninit();
+	assert(!vcmp(idx, want_idx) && !vcmp(verts, want_verts));
+	vfree(want_idx);
+	vfree(want_verts);
+
+	// Reserving only grows the capacity, and pushing up to it doesn't move the vector
+	uint32_t* v = vnew();
+	vreserve(v, 1000);
+	asserteq(vlen(v), 0);
+	assert(vcap(v) >= 1000);
+	uint32_t* before = v;
+	for (uint32_t i = 0; i < 1000; i++) vpush(v, i);
+	assert(v == before);
+	vremove(v, 10);
+	asserteq(v[10], 11);
+	vunshift(v, 5);
+	asserteq(v[0], 5);
+	asserteq(vlen(v), 1000);
+	vfree(v);
+}
+
+TEST("Single pushes") {
+	unsigned long long pushes = 0, start = get_precise_time();
+	BENCH("vpush_") {
+		vempty(idx);
+		for (uint32_t i = 0; i < QUADS * 6; i++) *(uint32_t*) vpush_((void**) &idx, sizeof(uint32_t)) = i;
+		pushes += QUADS * 6;
+	}
+	tests_report_rate(start, pushes, "pushes");
+
+	pushes = 0, start = get_precise_time();
+	BENCH("vpush") {
+		vempty(idx);
+		for (uint32_t i = 0; i < QUADS * 6; i++) vpush(idx, i);
+		pushes += QUADS * 6;
+	}
+	tests_report_rate(start, pushes, "pushes");
+}
+
+TEST("Quads") {
+	unsigned long long quads = 0, start = get_precise_time();
+	BENCH("old vpusharr") quads_old(), quads += QUADS;
+	tests_report_rate(start, quads, "quads");
+
+	quads = 0, start = get_precise_time();
+	BENCH("vpusharr") quads_arr(), quads += QUADS;
+	tests_report_rate(start, quads, "quads");
+
+	quads = 0, start = get_precise_time();
+	BENCH("vreserve + vpush_uninit") quads_uninit(), quads += QUADS;
+	tests_report_rate(start, quads, "quads");
+}
+
+#include "tests_end.h"